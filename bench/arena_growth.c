@@ -0,0 +1,79 @@
+// Region growth and the large-allocation path of arena.h against one malloc per
+// object. Build with -DREGION_MAX_SIZE=1024 for fixed 8 KiB regions, the way
+// arena.h worked before regions grew
+#include "bench.h"
+
+static size_t malloc_count;
+
+static void* counting_malloc(size_t size) {
+    malloc_count++;
+    return malloc(size);
+}
+
+#define ARENA_MALLOC counting_malloc
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+
+// Bytes of tokens per run, like parsing an input of this size
+#ifndef BENCH_INPUT_SIZE
+#define BENCH_INPUT_SIZE (256 << 20)
+#endif // BENCH_INPUT_SIZE
+
+// One in this many allocations is a large 1 MiB buffer
+#define LARGE_EVERY 100000
+
+static size_t token_size(size_t i) {
+    return 8 + (i * 2654435761u) % 57;
+}
+
+static void parse_with_arena(void) {
+    Arena arena = {0};
+    size_t total = 0;
+    for (size_t i = 0; total < BENCH_INPUT_SIZE; ++i) {
+        size_t size = i % LARGE_EVERY == LARGE_EVERY - 1 ? 1 << 20 : token_size(i);
+        char* p = arena_alloc(&arena, size);
+        p[0] = (char)i;
+        total += size;
+    }
+    arena_free(&arena);
+}
+
+static void parse_with_malloc(void) {
+    size_t capacity = BENCH_INPUT_SIZE / 8;
+    char** objects = malloc(capacity * sizeof(*objects));
+    size_t count = 0;
+    size_t total = 0;
+    for (size_t i = 0; total < BENCH_INPUT_SIZE; ++i) {
+        size_t size = i % LARGE_EVERY == LARGE_EVERY - 1 ? 1 << 20 : token_size(i);
+        char* p = counting_malloc(size);
+        p[0] = (char)i;
+        objects[count++] = p;
+        total += size;
+    }
+    for (size_t i = 0; i < count; ++i) free(objects[i]);
+    free(objects);
+}
+
+int main(void) {
+    size_t arena_mallocs = 0, plain_mallocs = 0;
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        malloc_count = 0;
+        MEASURE("arena");
+        parse_with_arena();
+        MEASURE_END("arena");
+        arena_mallocs = malloc_count;
+
+        malloc_count = 0;
+        MEASURE("malloc per object");
+        parse_with_malloc();
+        MEASURE_END("malloc per object");
+        plain_mallocs = malloc_count;
+    }
+
+    double mb = BENCH_INPUT_SIZE / (double)(1 << 20);
+    printf("%.0f MiB of tokens, REGION_MAX_SIZE %d words\n", mb, REGION_MAX_SIZE);
+    printf("arena:             %8zu mallocs, %7.1f MiB/s\n", arena_mallocs, mb / bench_average("arena"));
+    printf("malloc per object: %8zu mallocs, %7.1f MiB/s\n", plain_mallocs, mb / bench_average("malloc per object"));
+    bench_dump();
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Growing the last allocation in place against allocating and copying, on a
+// virtual memory arena, a regular arena and a Linear. Buffers double from 16 B
+// to 64 MiB, and separately grow by 64 KiB at a time up to 4 MiB like a string
+// builder appending chunks
+#include "bench.h"
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#define LINEAR_IMPLEMENTATION
+#include "linear.h"
+
+#define MIN_SIZE 16
+#define DOUBLING_MAX ((size_t)64 << 20)
+#define STEP ((size_t)64 << 10)
+#define STEP_MAX ((size_t)4 << 20)
+
+typedef struct {
+    const char* name;
+    size_t max;
+    size_t step; // 0 doubles
+}Growth;
+
+static size_t next_size(Growth growth, size_t size) {
+    return growth.step == 0 || size < growth.step ? size * 2 : size + growth.step;
+}
+
+// Copying keeps every old buffer around, so the reservations are sized for that
+static size_t total_size(Growth growth) {
+    size_t total = 0;
+    for (size_t size = MIN_SIZE; size <= growth.max; size = next_size(growth, size)) total += size;
+    return total;
+}
+
+// What arena_realloc did before: always new memory and a copy
+static void* arena_realloc_copy(Arena* arena, size_t oldsize, size_t newsize, void* ptr) {
+    void* fresh = arena_alloc(arena, newsize);
+    if (ptr != NULL) memcpy(fresh, ptr, oldsize);
+    return fresh;
+}
+
+static void* linear_realloc_copy(Linear* linear, size_t oldsize, size_t newsize, void* ptr) {
+    void* fresh = linear_allocb(linear, newsize);
+    if (ptr != NULL) memcpy(fresh, ptr, oldsize);
+    return fresh;
+}
+
+#define GROW(label, growth, setup, realloc_call, teardown) do { \
+    const char* name_ = bench_name("%s, %s", growth.name, label); \
+    MEASURE(name_); \
+    setup; \
+    char* buffer = NULL; \
+    size_t size = 0; \
+    for (size_t next = MIN_SIZE; next <= growth.max; next = next_size(growth, next)) { \
+        buffer = realloc_call; \
+        assert(buffer != NULL); \
+        buffer[next - 1] = (char)next; \
+        size = next; \
+    } \
+    bench_sink += buffer[size - 1]; \
+    teardown; \
+    MEASURE_END(name_); \
+} while (0)
+
+int main(void) {
+    Growth growths[] = {
+        {"doubling to 64 MiB", DOUBLING_MAX, 0},
+        {"+64 KiB to 4 MiB", STEP_MAX, STEP},
+    };
+
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        for (size_t i = 0; i < sizeof(growths)/sizeof(growths[0]); ++i) {
+            Growth g = growths[i];
+            size_t total = total_size(g);
+            Arena arena = {0};
+            Linear linear = {0};
+
+            GROW("vm arena, in place", g, arena_init_vm(&arena, 2 * g.max, 0),
+                arena_realloc(&arena, size, next, buffer), arena_free(&arena));
+            GROW("vm arena, copying", g, arena_init_vm(&arena, 2 * total, 0),
+                arena_realloc_copy(&arena, size, next, buffer), arena_free(&arena));
+
+            // Past REGION_MAX_SIZE words the buffer needs a region of its own,
+            // so growth there copies either way
+            GROW("arena, in place", g, (void)0,
+                arena_realloc(&arena, size, next, buffer), arena_free(&arena));
+            GROW("arena, copying", g, (void)0,
+                arena_realloc_copy(&arena, size, next, buffer), arena_free(&arena));
+
+            GROW("linear, in place", g, linear = linear_new(2 * g.max),
+                linear_reallocb(&linear, size, next, buffer), linear_free(&linear));
+            GROW("linear, copying", g, linear = linear_new(2 * total),
+                linear_realloc_copy(&linear, size, next, buffer), linear_free(&linear));
+        }
+    }
+
+    bench_dump();
+    return 0;
+}
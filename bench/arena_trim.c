@@ -0,0 +1,108 @@
+// A bursty request loop on one long-lived arena: most requests use about 512 KiB,
+// every BURST_EVERY-th one 64 MiB. Compares keeping every region on arena_reset,
+// trimming to a fixed size, and freeing the arena after every request, by
+// mallocs, memory held from malloc between requests and the latency of a normal request.
+// bench/arena_trim_auto and bench/arena_trim_cache build the same loop with
+// ARENA_AUTO_TRIM and ARENA_REGION_CACHE
+#include "bench.h"
+
+// Bytes the arena holds from malloc, every block carries its size in front
+static size_t live_bytes, peak_bytes, malloc_count;
+
+static void* counting_malloc(size_t size) {
+    size_t* block = malloc(sizeof(size_t) * 2 + size);
+    if (block == NULL) return NULL;
+    block[0] = size;
+    live_bytes += size;
+    if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+    malloc_count++;
+    return block + 2;
+}
+
+static void counting_free(void* ptr) {
+    size_t* block = (size_t*)ptr - 2;
+    live_bytes -= block[0];
+    free(block);
+}
+
+#if defined(ARENA_AUTO_TRIM)
+#define ARENA_BUILD "auto trim"
+#elif defined(ARENA_REGION_CACHE)
+#define ARENA_BUILD "region cache"
+#else
+#define ARENA_BUILD "plain"
+#endif
+
+#define ARENA_MALLOC counting_malloc
+#define ARENA_FREE counting_free
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+
+#define REQUESTS 2000
+#define BURST_EVERY 200
+#define NORMAL_SIZE (512 << 10)
+#define BURST_SIZE (64 << 20)
+// What the trimming policy keeps, twice a normal request
+#define TRIM_KEEP (1 << 20)
+
+typedef enum {
+    KEEP_ALL,
+    TRIM,
+    FREE,
+}Policy;
+
+static void serve(Arena* arena, size_t size) {
+    size_t used = 0;
+    for (size_t i = 0; used < size; ++i) {
+        size_t token = 1024 + (i * 2654435761u) % 3072;
+        memset(arena_alloc(arena, token), (int)i, token);
+        used += token;
+    }
+}
+
+static void run(const char* label, Policy policy) {
+    Arena arena = {0};
+    live_bytes = peak_bytes = malloc_count = 0;
+    size_t kept_total = 0;
+    double slowest = 0, normal_total = 0, burst_total = 0;
+
+    const char* name = bench_name("%s, %s", label, ARENA_BUILD);
+    MEASURE(name);
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        bool burst = i % BURST_EVERY == BURST_EVERY - 1;
+        double start = get_now();
+        serve(&arena, burst ? BURST_SIZE : NORMAL_SIZE);
+        switch (policy) {
+            case KEEP_ALL: arena_reset(&arena); break;
+            case TRIM: arena_reset(&arena); arena_trim(&arena, TRIM_KEEP); break;
+            case FREE: arena_free(&arena); break;
+        }
+        double elapsed = get_now() - start;
+        if (burst) burst_total += elapsed;
+        else normal_total += elapsed;
+        if (!burst && elapsed > slowest) slowest = elapsed;
+        kept_total += live_bytes;
+    }
+    MEASURE_END(name);
+
+    size_t normal_count = REQUESTS - REQUESTS / BURST_EVERY;
+    printf("%-28s %6zu mallocs, %6.2f MiB kept on average, %6.2f MiB peak, normal request %.3f ms, slowest %.3f ms, burst %.1f ms\n",
+        name, malloc_count, kept_total / (double)REQUESTS / (1 << 20), peak_bytes / (double)(1 << 20),
+        normal_total / normal_count * 1e3, slowest * 1e3, burst_total / (REQUESTS / BURST_EVERY) * 1e3);
+    arena_free(&arena);
+#ifdef ARENA_REGION_CACHE
+    // The cache outlives the arena, empty it so every run starts cold
+    arena_region_cache_clear();
+#endif // ARENA_REGION_CACHE
+}
+
+int main(void) {
+    printf("%d requests of %d KiB, every %dth one %d MiB\n", REQUESTS, NORMAL_SIZE >> 10, BURST_EVERY, BURST_SIZE >> 20);
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        run("arena_reset", KEEP_ALL);
+        run("arena_trim 1 MiB", TRIM);
+        run("arena_free", FREE);
+    }
+    bench_dump();
+    return 0;
+}
@@ -0,0 +1,3 @@
+// The bursty arena_reset loop with arena_reset trimming to recent usage
+#define ARENA_AUTO_TRIM
+#include "arena_trim.c"
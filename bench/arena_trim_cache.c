@@ -0,0 +1,3 @@
+// The bursty arena_reset loop with freed regions going to the process-wide cache
+#define ARENA_REGION_CACHE
+#include "arena_trim.c"
@@ -0,0 +1,55 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#define MEASURE_IMPLEMENTATION
+#include "measure.h"
+
+// Times every measurement is repeated
+#ifndef BENCH_REPS
+#define BENCH_REPS 3
+#endif // BENCH_REPS
+
+// Results go here, so the work producing them can't be optimized out
+static volatile uint64_t bench_sink;
+
+static uint64_t bench_rng_state = 0x9e3779b97f4a7c15ull;
+
+static inline uint64_t bench_rand(void) {
+    bench_rng_state ^= bench_rng_state << 13;
+    bench_rng_state ^= bench_rng_state >> 7;
+    bench_rng_state ^= bench_rng_state << 17;
+    return bench_rng_state;
+}
+
+// Measure names are kept by pointer, so formatted ones need their own memory
+__attribute__((format(printf, 1, 2)))
+static inline const char* bench_name(const char* fmt, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    return strdup(buffer);
+}
+
+// Average of the runs of the measurement called NAME, in seconds
+static inline double bench_average(const char* name) {
+    size_t i;
+    if (!measures_find(name, &i)) return 0;
+    return measuresments_average(&measures[i].ms);
+}
+
+static inline void bench_dump(void) {
+    measures_dump(stdout);
+    measures_free();
+}
+
+#endif // BENCH_H_
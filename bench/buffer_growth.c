@@ -0,0 +1,105 @@
+// Building one big buffer in 64 KiB appends, default 1 GiB, through a dah array
+// and a StringBuilder: the realloc path, the mmap/mremap mode they switch to
+// past DAH_MMAP_THRESHOLD/SB_MMAP_THRESHOLD, and an allocator that always
+// copies, which is what realloc does where it can't remap. Peak RSS is reset
+// between runs through /proc/self/clear_refs
+#define _GNU_SOURCE
+#include "bench.h"
+
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+#define SB_NO_CURL
+#define SB_IMPLEMENTATION
+#include "string_builder.h"
+
+#ifndef BENCH_BUFFER_SIZE
+#define BENCH_BUFFER_SIZE ((size_t)1 << 30)
+#endif // BENCH_BUFFER_SIZE
+
+#define CHUNK (64 << 10)
+
+static size_t copied_bytes;
+
+static void* copying_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    (void)ctx;
+    void* moved = malloc(newsize);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, oldsize < newsize ? oldsize : newsize);
+    copied_bytes += oldsize < newsize ? oldsize : newsize;
+    free(ptr);
+    return moved;
+}
+
+static const Allocator copying_allocator = {
+    allocator__libc_alloc,
+    copying_realloc,
+    allocator__libc_free,
+    NULL,
+};
+
+static void reset_peak_rss(void) {
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (f == NULL) return;
+    fputs("5", f);
+    fclose(f);
+}
+
+// In MiB, 0 where /proc isn't there
+static double peak_rss(void) {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f == NULL) return 0;
+    char line[256];
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "VmHWM:", 6) == 0) kb = strtoull(line + 6, NULL, 10);
+    }
+    fclose(f);
+    return kb / 1024.0;
+}
+
+static void report(const char* name) {
+    printf("%-32s peak RSS %7.1f MiB, %7.1f MiB copied by the allocator\n", name, peak_rss(), copied_bytes / (double)(1 << 20));
+    copied_bytes = 0;
+}
+
+static void build_dah(const char* name, const Allocator* allocator, const char* chunk) {
+    reset_peak_rss();
+    MEASURE(name);
+    char* buffer;
+    if (allocator != NULL) dah_init_with(buffer, allocator);
+    else dah_init(buffer);
+    for (size_t size = 0; size < BENCH_BUFFER_SIZE; size += CHUNK) dah_append_many(buffer, chunk, CHUNK);
+    bench_sink += buffer[BENCH_BUFFER_SIZE - 1];
+    MEASURE_END(name);
+    report(name);
+    dah_free(buffer);
+}
+
+static void build_sb(const char* name, const Allocator* allocator, const char* chunk) {
+    reset_peak_rss();
+    MEASURE(name);
+    StringBuilder sb = {0};
+    sb.allocator = allocator;
+    for (size_t size = 0; size < BENCH_BUFFER_SIZE; size += CHUNK) sb_push_bytes(&sb, (void*)chunk, CHUNK);
+    bench_sink += sb.items[BENCH_BUFFER_SIZE - 1];
+    MEASURE_END(name);
+    report(name);
+    sb_free(&sb);
+}
+
+int main(void) {
+    static char chunk[CHUNK];
+    memset(chunk, 'x', sizeof(chunk));
+
+    printf("%zu MiB in %d KiB appends, mmap mode from %d MiB\n", BENCH_BUFFER_SIZE >> 20, CHUNK >> 10, DAH_MMAP_THRESHOLD >> 20);
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        build_dah("dah, realloc", &libc_allocator, chunk);
+        build_dah("dah, mmap mode", NULL, chunk);
+        build_dah("dah, copying", &copying_allocator, chunk);
+        build_sb("sb, realloc", &libc_allocator, chunk);
+        build_sb("sb, mmap mode", NULL, chunk);
+        build_sb("sb, copying", &copying_allocator, chunk);
+    }
+    bench_dump();
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Bulk-loading records into a dah array: one dah_append at a time, after a
+// dah_reserve, and through dah_append_many in batches, with reallocs, the peak
+// bytes held and what dah_shrink_to_fit gives back. bench/dah_growth_15 builds
+// the same loads with 1.5x growth
+#include "bench.h"
+#include <stddef.h>
+
+// Every block carries its size in front, in a max_align_t sized slot
+#define HEADER sizeof(max_align_t)
+static size_t live_bytes, peak_bytes, realloc_count;
+
+static void account(size_t removed, size_t added) {
+    live_bytes = live_bytes - removed + added;
+    if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+}
+
+static void* counting_malloc(size_t size) {
+    char* block = malloc(HEADER + size);
+    if (block == NULL) return NULL;
+    *(size_t*)block = size;
+    account(0, size);
+    return block + HEADER;
+}
+
+static void* counting_realloc(void* ptr, size_t size) {
+    if (ptr == NULL) return counting_malloc(size);
+    char* block = (char*)ptr - HEADER;
+    size_t old = *(size_t*)block;
+    block = realloc(block, HEADER + size);
+    if (block == NULL) return NULL;
+    *(size_t*)block = size;
+    account(old, size);
+    realloc_count++;
+    return block + HEADER;
+}
+
+static void counting_free(void* ptr) {
+    if (ptr == NULL) return;
+    char* block = (char*)ptr - HEADER;
+    account(*(size_t*)block, 0);
+    free(block);
+}
+
+#if defined(DAH_GROWTH_NAME)
+#elif defined(DAH_GROW)
+#define DAH_GROWTH_NAME "custom growth"
+#else
+#define DAH_GROWTH_NAME "2x growth"
+#endif
+
+#define DAH_MALLOC counting_malloc
+#define DAH_REALLOC counting_realloc
+#define DAH_FREE counting_free
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+
+#ifndef RECORDS
+#define RECORDS 10000000
+#endif // RECORDS
+#define BATCH 4096
+
+typedef struct {
+    uint64_t id;
+    uint32_t key;
+    float value;
+}Record;
+
+static Record record(size_t i) {
+    Record r = {i, (uint32_t)(i * 2654435761u), (float)i};
+    return r;
+}
+
+typedef enum {
+    ONE_BY_ONE,
+    RESERVED,
+    BATCHED,
+}Load;
+
+static void run(const char* label, Load load) {
+    live_bytes = peak_bytes = realloc_count = 0;
+    const char* name = bench_name("%s, %s", label, DAH_GROWTH_NAME);
+
+    MEASURE(name);
+    Record* records;
+    dah_init(records);
+    if (load == RESERVED) dah_reserve(records, RECORDS);
+
+    if (load == BATCHED) {
+        Record batch[BATCH];
+        for (size_t i = 0; i < RECORDS; i += BATCH) {
+            size_t n = RECORDS - i < BATCH ? RECORDS - i : BATCH;
+            for (size_t j = 0; j < n; ++j) batch[j] = record(i + j);
+            dah_append_many(records, batch, n);
+        }
+    } else {
+        for (size_t i = 0; i < RECORDS; ++i) dah_append(records, record(i));
+    }
+    MEASURE_END(name);
+
+    size_t loaded = live_bytes;
+    dah_shrink_to_fit(records);
+    bench_sink += records[RECORDS - 1].id;
+    printf("%-38s %3zu reallocs, peak %6.1f MiB, %6.1f MiB after loading, %6.1f MiB after dah_shrink_to_fit\n",
+        name, realloc_count, peak_bytes / (double)(1 << 20), loaded / (double)(1 << 20), live_bytes / (double)(1 << 20));
+    dah_free(records);
+}
+
+int main(void) {
+    printf("%d records of %zu bytes, %.1f MiB of data\n", RECORDS, sizeof(Record), RECORDS * sizeof(Record) / (double)(1 << 20));
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        run("dah_append", ONE_BY_ONE);
+        run("dah_reserve + dah_append", RESERVED);
+        run("dah_append_many", BATCHED);
+    }
+    bench_dump();
+    return 0;
+}
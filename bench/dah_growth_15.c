@@ -0,0 +1,4 @@
+// The dah bulk loads with 1.5x growth
+#define DAH_GROW(cap) ((cap) + (cap)/2)
+#define DAH_GROWTH_NAME "1.5x growth"
+#include "dah_growth.c"
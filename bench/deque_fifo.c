@@ -0,0 +1,142 @@
+// FIFO queues on a deque against a dah array popped with dah_remove_ordered:
+// steady push/pop at several queue depths, batched pushes and pops, and a BFS
+// over a grid with the queue as its work list
+#include "bench.h"
+
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+#define DEQ_IMPLEMENTATION
+#include "deque.h"
+
+#define OPS 10000000
+// dah pops move the whole queue, so it gets fewer operations at depth
+#define DAH_OPS(depth) ((depth) < 100 ? OPS : (size_t)1000000000 / (depth))
+#define BATCH 64
+#define GRID 1024
+
+static void fifo(size_t depth) {
+    uint32_t* dq = NULL;
+    uint32_t* da;
+    dah_init(da);
+    for (size_t i = 0; i < depth; ++i) {
+        deq_push_back(dq, (uint32_t)i);
+        dah_append(da, (uint32_t)i);
+    }
+
+    uint64_t sum = 0;
+    const char* deq_name = bench_name("push/pop at depth %zu, deque", depth);
+    MEASURE(deq_name);
+    for (size_t i = 0; i < OPS; ++i) {
+        sum += deq_pop_front(dq);
+        deq_push_back(dq, (uint32_t)i);
+    }
+    MEASURE_END(deq_name);
+
+    size_t dah_ops = DAH_OPS(depth);
+    const char* dah_name = bench_name("push/pop at depth %zu, dah", depth);
+    MEASURE(dah_name);
+    for (size_t i = 0; i < dah_ops; ++i) {
+        sum += da[0];
+        dah_remove_ordered(da, 0);
+        dah_append(da, (uint32_t)i);
+    }
+    MEASURE_END(dah_name);
+    bench_sink += sum;
+
+    deq_free(dq);
+    dah_free(da);
+}
+
+static void batched(void) {
+    uint32_t batch[BATCH];
+    for (size_t i = 0; i < BATCH; ++i) batch[i] = (uint32_t)i;
+    uint32_t* dq = NULL;
+    uint32_t* da;
+    dah_init(da);
+
+    uint64_t sum = 0;
+    MEASURE("batches of 64, deque");
+    for (size_t i = 0; i < OPS / BATCH; ++i) {
+        deq_push_back_many(dq, batch, BATCH);
+        // Pops lag a batch behind, so the items wrap around the buffer
+        if (i > 0) sum += deq_pop_front_many(dq, batch, BATCH);
+    }
+    MEASURE_END("batches of 64, deque");
+
+    MEASURE("batches of 64, dah");
+    for (size_t i = 0; i < OPS / BATCH; ++i) {
+        dah_append_many(da, batch, BATCH);
+        if (i > 0) {
+            memcpy(batch, da, sizeof(batch));
+            dah_remove_range(da, 0, BATCH);
+            sum += BATCH;
+        }
+    }
+    MEASURE_END("batches of 64, dah");
+    bench_sink += sum;
+
+    deq_free(dq);
+    dah_free(da);
+}
+
+// Distance from the top left corner to every cell of an open GRID x GRID grid
+static void bfs(void) {
+    uint32_t* dist = malloc(GRID * GRID * sizeof(*dist));
+    static const int dx[] = {1, -1, 0, 0}, dy[] = {0, 0, 1, -1};
+
+#define BFS(empty, push, pop) do { \
+    memset(dist, 0xff, GRID * GRID * sizeof(*dist)); \
+    dist[0] = 0; \
+    push(0); \
+    while (!(empty)) { \
+        uint32_t cell = pop(); \
+        int x = cell % GRID, y = cell / GRID; \
+        for (int d = 0; d < 4; ++d) { \
+            int nx = x + dx[d], ny = y + dy[d]; \
+            if (nx < 0 || ny < 0 || nx >= GRID || ny >= GRID) continue; \
+            uint32_t next = ny * GRID + nx; \
+            if (dist[next] != UINT32_MAX) continue; \
+            dist[next] = dist[cell] + 1; \
+            push(next); \
+        } \
+    } \
+    bench_sink += dist[GRID * GRID - 1]; \
+} while (0)
+
+    uint32_t* dq = NULL;
+#define deq_push(v) deq_push_back(dq, v)
+#define deq_pop() deq_pop_front(dq)
+    MEASURE("bfs 1024x1024, deque");
+    BFS(deq_empty(dq), deq_push, deq_pop);
+    MEASURE_END("bfs 1024x1024, deque");
+    deq_free(dq);
+
+    uint32_t* da;
+    dah_init(da);
+#define dah_push(v) dah_append(da, v)
+#define dah_pop() (front = da[0], dah_remove_ordered(da, 0), front)
+    uint32_t front;
+    MEASURE("bfs 1024x1024, dah");
+    BFS(dah_getlen(da) == 0, dah_push, dah_pop);
+    MEASURE_END("bfs 1024x1024, dah");
+    dah_free(da);
+    free(dist);
+}
+
+int main(void) {
+    size_t depths[] = {16, 1024, 65536};
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        for (size_t i = 0; i < sizeof(depths)/sizeof(depths[0]); ++i) fifo(depths[i]);
+        batched();
+        bfs();
+    }
+
+    printf("ns per push and pop:\n");
+    for (size_t i = 0; i < sizeof(depths)/sizeof(depths[0]); ++i) {
+        double deq = bench_average(bench_name("push/pop at depth %zu, deque", depths[i])) / OPS;
+        double da = bench_average(bench_name("push/pop at depth %zu, dah", depths[i])) / DAH_OPS(depths[i]);
+        printf("depth %6zu: deque %8.2f ns, dah %10.2f ns\n", depths[i], deq * 1e9, da * 1e9);
+    }
+    bench_dump();
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Inserting and looking up 1K to 10M keys in hash maps keyed by integers and by
+// StringView, with the bytes every key costs. Small maps repeat the work until
+// every measurement covers OPS operations, so the times are per operation
+#include "bench.h"
+
+#include "hashmap.h"
+
+HASHMAP_DECLARE(IntMap, intmap, uint64_t, uint64_t)
+HASHMAP_IMPLEMENT(IntMap, intmap, uint64_t, uint64_t, hashmap_hash_u64, hashmap_eq_u64)
+HASHMAP_DECLARE(StrMap, strmap, StringView, uint64_t)
+HASHMAP_IMPLEMENT(StrMap, strmap, StringView, uint64_t, hashmap_hash_sv, hashmap_eq_sv)
+
+#define MAX_KEYS 10000000
+#define OPS 2000000
+// Strings are "key-" and up to 8 digits, in one buffer
+#define STR_SIZE 16
+
+static uint64_t* int_keys;
+static uint64_t* int_misses;
+static char* str_data;
+static StringView* str_keys;
+static StringView* str_misses;
+
+static size_t rounds(size_t n) {
+    return n < OPS ? OPS / n : 1;
+}
+
+// Prints the averages once LAST is set
+static void bench_ints(size_t n, bool last) {
+    size_t r = rounds(n);
+    IntMap map = {0};
+
+    const char* insert = bench_name("u64 insert, %zu keys", n);
+    MEASURE(insert);
+    for (size_t round = 0; round < r; ++round) {
+        intmap_free(&map);
+        for (size_t i = 0; i < n; ++i) intmap_put(&map, int_keys[i], i);
+    }
+    MEASURE_END(insert);
+
+    const char* hit = bench_name("u64 lookup hit, %zu keys", n);
+    uint64_t sum = 0;
+    MEASURE(hit);
+    for (size_t round = 0; round < r; ++round) {
+        for (size_t i = 0; i < n; ++i) sum += *intmap_get(&map, int_keys[i]);
+    }
+    MEASURE_END(hit);
+
+    const char* miss = bench_name("u64 lookup miss, %zu keys", n);
+    MEASURE(miss);
+    for (size_t round = 0; round < r; ++round) {
+        for (size_t i = 0; i < n; ++i) sum += intmap_get(&map, int_misses[i]) != NULL;
+    }
+    MEASURE_END(miss);
+    bench_sink += sum;
+
+    if (last) printf("u64 %8zu keys: insert %6.1f ns, hit %6.1f ns, miss %6.1f ns, %5.1f bytes per key (%zu of entry)\n",
+        n, bench_average(insert) / (n * r) * 1e9, bench_average(hit) / (n * r) * 1e9,
+        bench_average(miss) / (n * r) * 1e9, intmap__block_size(map.capacity) / (double)n, sizeof(IntMapEntry));
+    intmap_free(&map);
+}
+
+static void bench_strs(size_t n, bool last) {
+    size_t r = rounds(n);
+    StrMap map = {0};
+
+    const char* insert = bench_name("sv insert, %zu keys", n);
+    MEASURE(insert);
+    for (size_t round = 0; round < r; ++round) {
+        strmap_free(&map);
+        for (size_t i = 0; i < n; ++i) strmap_put(&map, str_keys[i], i);
+    }
+    MEASURE_END(insert);
+
+    const char* hit = bench_name("sv lookup hit, %zu keys", n);
+    uint64_t sum = 0;
+    MEASURE(hit);
+    for (size_t round = 0; round < r; ++round) {
+        for (size_t i = 0; i < n; ++i) sum += *strmap_get(&map, str_keys[i]);
+    }
+    MEASURE_END(hit);
+
+    const char* miss = bench_name("sv lookup miss, %zu keys", n);
+    MEASURE(miss);
+    for (size_t round = 0; round < r; ++round) {
+        for (size_t i = 0; i < n; ++i) sum += strmap_get(&map, str_misses[i]) != NULL;
+    }
+    MEASURE_END(miss);
+    bench_sink += sum;
+
+    if (last) printf("sv  %8zu keys: insert %6.1f ns, hit %6.1f ns, miss %6.1f ns, %5.1f bytes per key (%zu of entry)\n",
+        n, bench_average(insert) / (n * r) * 1e9, bench_average(hit) / (n * r) * 1e9,
+        bench_average(miss) / (n * r) * 1e9, strmap__block_size(map.capacity) / (double)n, sizeof(StrMapEntry));
+    strmap_free(&map);
+}
+
+int main(void) {
+    int_keys = malloc(MAX_KEYS * sizeof(*int_keys));
+    int_misses = malloc(MAX_KEYS * sizeof(*int_misses));
+    str_data = malloc((size_t)MAX_KEYS * 2 * STR_SIZE);
+    str_keys = malloc(MAX_KEYS * sizeof(*str_keys));
+    str_misses = malloc(MAX_KEYS * sizeof(*str_misses));
+    for (size_t i = 0; i < MAX_KEYS; ++i) {
+        int_keys[i] = bench_rand();
+        int_misses[i] = bench_rand();
+
+        // Shuffled, so lookups don't go in insertion order
+        size_t id = (i * 2654435761u) % MAX_KEYS;
+        char* key = str_data + 2 * i * STR_SIZE;
+        char* miss = key + STR_SIZE;
+        str_keys[i] = (StringView){key, (size_t)snprintf(key, STR_SIZE, "key-%zu", id)};
+        str_misses[i] = (StringView){miss, (size_t)snprintf(miss, STR_SIZE, "nokey-%zu", id)};
+    }
+
+    for (size_t n = 1000; n <= MAX_KEYS; n *= 10) {
+        for (int rep = 0; rep < BENCH_REPS; ++rep) {
+            bench_ints(n, rep == BENCH_REPS - 1);
+            bench_strs(n, rep == BENCH_REPS - 1);
+        }
+    }
+
+    bench_dump();
+    free(int_keys);
+    free(int_misses);
+    free(str_data);
+    free(str_keys);
+    free(str_misses);
+    return 0;
+}
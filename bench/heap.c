@@ -0,0 +1,123 @@
+// A timer queue of 1K to 10M pending timers, where every step pops the earliest
+// and schedules a later one: the 4-ary heap against re-sorting the array after
+// every insert, and against keeping it sorted with a binary search and memmove.
+// Also top-100 of every size, through heapify and pop_many against a full sort
+#include "bench.h"
+
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+#include "heap.h"
+
+#define u64_less(a, b) ((a) < (b))
+HEAP_DECLARE(timers, uint64_t)
+HEAP_IMPLEMENT(timers, uint64_t, u64_less, HEAP_NO_INDEX)
+
+#define MAX_COUNT 10000000
+#define OPS 1000000
+// The sorted baselines do O(n) work per step, so they get fewer steps at size
+#define RESORT_OPS(n) ((n) < 10000 ? 1000 : (size_t)10000000 / (n))
+#define INSERT_OPS(n) ((n) < 1000 ? OPS : (size_t)1000000000 / (n))
+#define TOP_K 100
+
+// Sorted descending, so the earliest timer pops off the end
+static int cmp_desc(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x < y) - (x > y);
+}
+
+static int cmp_asc(const void* a, const void* b) {
+    return cmp_desc(b, a);
+}
+
+static uint64_t later(uint64_t now) {
+    return now + 1 + bench_rand() % 1000000;
+}
+
+static void insert_sorted(uint64_t** sorted, uint64_t timer) {
+    size_t lo = 0, hi = dah_getlen(*sorted);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if ((*sorted)[mid] > timer) lo = mid + 1;
+        else hi = mid;
+    }
+    dah_insert_many(*sorted, lo, &timer, 1);
+}
+
+static void run(size_t n, const uint64_t* timers) {
+    uint64_t* heap;
+    dah_init(heap);
+    dah_append_many(heap, timers, n);
+    timers_heapify(heap);
+
+    const char* heap_name = bench_name("timers, %zu pending, heap", n);
+    MEASURE(heap_name);
+    for (size_t i = 0; i < OPS; ++i) timers_push(&heap, later(timers_pop(heap)));
+    MEASURE_END(heap_name);
+    bench_sink += heap[0];
+
+    uint64_t* sorted;
+    dah_init(sorted);
+    dah_append_many(sorted, timers, n);
+    qsort(sorted, n, sizeof(*sorted), cmp_desc);
+
+    const char* resort_name = bench_name("timers, %zu pending, qsort per insert", n);
+    MEASURE(resort_name);
+    for (size_t i = 0; i < RESORT_OPS(n); ++i) {
+        uint64_t now = sorted[--dah_getheader(sorted)->count];
+        dah_append(sorted, later(now));
+        qsort(sorted, n, sizeof(*sorted), cmp_desc);
+    }
+    MEASURE_END(resort_name);
+
+    const char* insert_name = bench_name("timers, %zu pending, sorted insert", n);
+    MEASURE(insert_name);
+    for (size_t i = 0; i < INSERT_OPS(n); ++i) {
+        uint64_t now = sorted[--dah_getheader(sorted)->count];
+        insert_sorted(&sorted, later(now));
+    }
+    MEASURE_END(insert_name);
+    bench_sink += sorted[n - 1];
+
+    // Top K of the original timers
+    uint64_t top[TOP_K];
+    memcpy(heap, timers, n * sizeof(*heap));
+    dah_getheader(heap)->count = n;
+    const char* top_heap_name = bench_name("top %d of %zu, heapify + pop_many", TOP_K, n);
+    MEASURE(top_heap_name);
+    timers_heapify(heap);
+    timers_pop_many(heap, top, TOP_K);
+    MEASURE_END(top_heap_name);
+    bench_sink += top[TOP_K - 1];
+
+    memcpy(sorted, timers, n * sizeof(*sorted));
+    const char* top_sort_name = bench_name("top %d of %zu, qsort", TOP_K, n);
+    MEASURE(top_sort_name);
+    qsort(sorted, n, sizeof(*sorted), cmp_asc);
+    MEASURE_END(top_sort_name);
+    bench_sink += sorted[TOP_K - 1];
+
+    dah_free(heap);
+    dah_free(sorted);
+}
+
+int main(void) {
+    uint64_t* timers = malloc(MAX_COUNT * sizeof(*timers));
+    for (size_t i = 0; i < MAX_COUNT; ++i) timers[i] = bench_rand() % 1000000000;
+
+    for (size_t n = 1000; n <= MAX_COUNT; n *= 10) {
+        for (int rep = 0; rep < BENCH_REPS; ++rep) run(n, timers);
+    }
+
+    printf("%-10s %12s %18s %15s %14s %14s\n", "pending", "heap", "qsort per insert", "sorted insert", "top 100 heap", "top 100 qsort");
+    for (size_t n = 1000; n <= MAX_COUNT; n *= 10) {
+        printf("%-10zu %10.1fns %16.1fus %13.1fns %12.3fms %12.3fms\n", n,
+            bench_average(bench_name("timers, %zu pending, heap", n)) / OPS * 1e9,
+            bench_average(bench_name("timers, %zu pending, qsort per insert", n)) / RESORT_OPS(n) * 1e6,
+            bench_average(bench_name("timers, %zu pending, sorted insert", n)) / INSERT_OPS(n) * 1e9,
+            bench_average(bench_name("top %d of %zu, heapify + pop_many", TOP_K, n)) * 1e3,
+            bench_average(bench_name("top %d of %zu, qsort", TOP_K, n)) * 1e3);
+    }
+    bench_dump();
+    free(timers);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Interning the tokens of a dedup-heavy corpus: 8M identifiers drawn from 2000
+// distinct ones with long shared prefixes, the way a parser sees the same
+// names over and over. Compares matching every token against a keyword list
+// with sv_cmpsv and with atoms, and what the tokens take to keep around
+#include "bench.h"
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+#define SV_IMPLEMENTATION
+#include "string_view.h"
+#define SB_NO_CURL
+#define SB_IMPLEMENTATION
+#include "string_builder.h"
+#define INTERN_IMPLEMENTATION
+#include "intern.h"
+
+#define TOKENS 8000000
+#define DISTINCT 2000
+#define KEYWORDS 16
+
+static const char* prefixes[] = {"request_handler_", "connection_pool_", "metrics_", "user_session_state_"};
+
+static size_t arena_bytes(Arena* arena) {
+    size_t bytes = 0;
+    for (ArenaRegion* r = arena->start; r != NULL; r = r->next) bytes += sizeof(*r) + r->capacity * sizeof(uintptr_t);
+    return bytes;
+}
+
+int main(void) {
+    // The corpus, tokens separated by spaces
+    StringBuilder corpus_sb = {0};
+    for (size_t i = 0; i < TOKENS; ++i) {
+        // Skewed towards the first identifiers, like real code
+        size_t id = bench_rand() % (bench_rand() % DISTINCT + 1);
+        sb_push_sprintf(&corpus_sb, "%s%zu ", prefixes[id % 4], id);
+    }
+    StringView corpus = {corpus_sb.items, corpus_sb.count - 1};
+
+    StringView keywords[KEYWORDS];
+    for (size_t i = 0; i < KEYWORDS; ++i) {
+        size_t id = i * (DISTINCT / KEYWORDS);
+        keywords[i] = sv_from_cstr(bench_name("%s%zu", prefixes[id % 4], id));
+    }
+
+    size_t matches_sv = 0, matches_atom = 0;
+    size_t tokens_count = 0, distinct_count = 0, interned_bytes = 0;
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        StringSplit tokens = sv_split(corpus, ' ');
+        tokens_count = tokens.count;
+
+        Interner interner = {0};
+        Atom* atoms = malloc(tokens.count * sizeof(*atoms));
+        MEASURE("intern_split");
+        intern_split(&interner, &tokens, atoms);
+        MEASURE_END("intern_split");
+        distinct_count = intern_count(&interner);
+        interned_bytes = arena_bytes(&interner.arena) + dah_getheader(interner.strings)->capacity * sizeof(StringView)
+            + intern__map__block_size(interner.map.capacity);
+
+        Atom keyword_atoms[KEYWORDS];
+        for (size_t k = 0; k < KEYWORDS; ++k) keyword_atoms[k] = intern_atom(&interner, keywords[k]);
+
+        matches_sv = 0;
+        MEASURE("keyword match, sv_cmpsv");
+        for (size_t i = 0; i < tokens.count; ++i) {
+            for (size_t k = 0; k < KEYWORDS; ++k) matches_sv += sv_cmpsv(tokens.items[i], keywords[k]);
+        }
+        MEASURE_END("keyword match, sv_cmpsv");
+
+        matches_atom = 0;
+        MEASURE("keyword match, atoms");
+        for (size_t i = 0; i < tokens.count; ++i) {
+            for (size_t k = 0; k < KEYWORDS; ++k) matches_atom += atoms[i] == keyword_atoms[k];
+        }
+        MEASURE_END("keyword match, atoms");
+        assert(matches_sv == matches_atom);
+
+        size_t repeats = 0;
+        MEASURE("same as previous, sv_cmpsv");
+        for (size_t i = 1; i < tokens.count; ++i) repeats += sv_cmpsv(tokens.items[i], tokens.items[i - 1]);
+        MEASURE_END("same as previous, sv_cmpsv");
+        MEASURE("same as previous, pointers");
+        for (size_t i = 1; i < tokens.count; ++i) repeats += tokens.items[i].start == tokens.items[i - 1].start;
+        MEASURE_END("same as previous, pointers");
+        bench_sink += repeats;
+
+        free(atoms);
+        sv_split_free(&tokens);
+        intern_free(&interner);
+    }
+
+    printf("%zu tokens, %zu distinct, %zu keyword matches\n", tokens_count, distinct_count, matches_sv);
+    printf("corpus + a StringView per token: %7.1f MiB\n", (corpus.len + tokens_count * sizeof(StringView)) / (double)(1 << 20));
+    printf("interner + an Atom per token:    %7.1f MiB\n", (interned_bytes + tokens_count * sizeof(Atom)) / (double)(1 << 20));
+    printf("keyword match:    sv_cmpsv %.1f ms, atoms %.1f ms\n",
+        bench_average("keyword match, sv_cmpsv") * 1e3, bench_average("keyword match, atoms") * 1e3);
+    printf("same as previous: sv_cmpsv %.1f ms, pointers %.1f ms\n",
+        bench_average("same as previous, sv_cmpsv") * 1e3, bench_average("same as previous, pointers") * 1e3);
+    bench_dump();
+    sb_free(&corpus_sb);
+    return 0;
+}
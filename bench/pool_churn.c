@@ -0,0 +1,112 @@
+// Churn of same-sized objects through a Pool against glibc malloc: a working set
+// of live objects where every step frees a random one and allocates its
+// replacement. The threaded runs give every thread its own working set and
+// PoolCache on one shared Pool
+#include "bench.h"
+#include <pthread.h>
+
+static size_t arena_mallocs;
+
+static void* counting_malloc(size_t size) {
+    __atomic_fetch_add(&arena_mallocs, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+#define ARENA_MALLOC counting_malloc
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#define POOL_IMPLEMENTATION
+#include "pool.h"
+
+#define OBJECT_SIZE 64
+// Live objects per thread
+#define LIVE (1 << 16)
+// Frees and allocations per thread
+#define STEPS (1 << 21)
+#define THREADS 4
+
+static Pool pool;
+
+static uint64_t next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+#define CHURN(alloc, release) do { \
+    void** live = malloc(LIVE * sizeof(*live)); \
+    uint64_t state = 0x9e3779b97f4a7c15ull + (uintptr_t)arg; \
+    for (size_t i = 0; i < LIVE; ++i) { \
+        live[i] = alloc; \
+        memset(live[i], (int)i, OBJECT_SIZE); \
+    } \
+    for (size_t i = 0; i < STEPS; ++i) { \
+        size_t slot = next_random(&state) % LIVE; \
+        release(live[slot]); \
+        live[slot] = alloc; \
+        *(size_t*)live[slot] = i; \
+    } \
+    for (size_t i = 0; i < LIVE; ++i) release(live[i]); \
+    free(live); \
+} while (0)
+
+#define pool_release(item) pool_free(&pool, item)
+#define cache_release(item) pool_cache_free(&cache, item)
+
+static void* churn_pool(void* arg) {
+    CHURN(pool_alloc(&pool), pool_release);
+    return NULL;
+}
+
+static void* churn_malloc(void* arg) {
+    CHURN(malloc(OBJECT_SIZE), free);
+    return NULL;
+}
+
+static void* churn_cache(void* arg) {
+    PoolCache cache = pool_cache_new(&pool);
+    CHURN(pool_cache_alloc(&cache), cache_release);
+    pool_cache_flush(&cache);
+    return NULL;
+}
+
+static void run(const char* name, void* (*worker)(void*), size_t threads) {
+    pthread_t ids[THREADS];
+    MEASURE(name);
+    if (threads == 1) {
+        worker(NULL);
+    } else {
+        for (size_t i = 0; i < threads; ++i) pthread_create(&ids[i], NULL, worker, (void*)i);
+        for (size_t i = 0; i < threads; ++i) pthread_join(ids[i], NULL);
+    }
+    MEASURE_END(name);
+}
+
+int main(void) {
+    size_t steady_mallocs = 0;
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        pool_init(&pool, OBJECT_SIZE, 16);
+        run("pool", churn_pool, 1);
+        // The second run recycles what the first one freed, so it should never touch malloc
+        size_t before = arena_mallocs;
+        run("pool", churn_pool, 1);
+        steady_mallocs += arena_mallocs - before;
+        pool_destroy(&pool);
+
+        run("malloc", churn_malloc, 1);
+        run("malloc", churn_malloc, 1);
+
+        pool_init(&pool, OBJECT_SIZE, 16);
+        run("pool caches, 4 threads", churn_cache, THREADS);
+        pool_destroy(&pool);
+        run("malloc, 4 threads", churn_malloc, THREADS);
+    }
+
+    printf("%d live objects of %d bytes, %d frees and allocations per thread\n", LIVE, OBJECT_SIZE, STEPS);
+    printf("Arena mallocs once the pool was warm: %zu\n", steady_mallocs);
+    printf("pool: %.1f M ops/s, malloc: %.1f M ops/s\n",
+        STEPS / bench_average("pool") / 1e6, STEPS / bench_average("malloc") / 1e6);
+    bench_dump();
+    return 0;
+}
@@ -0,0 +1,129 @@
+// dah's radix sorts against qsort at several sizes and key distributions, for
+// plain u32, u64 and f64 keys and for structs sorted by a field
+#include "bench.h"
+
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+
+#define MAX_COUNT (1 << 22)
+
+typedef struct {
+    uint64_t key;
+    uint32_t payload[2];
+}Row;
+
+typedef enum {
+    UNIFORM,
+    // Keys from 0 to 255, lots of duplicates
+    NARROW,
+    SORTED,
+    REVERSED,
+}Distribution;
+
+static const char* distribution_names[] = {"uniform", "narrow", "sorted", "reversed"};
+
+static uint64_t key(Distribution d, size_t i, size_t count) {
+    switch (d) {
+        case UNIFORM: return bench_rand();
+        case NARROW: return bench_rand() & 0xff;
+        case SORTED: return i;
+        case REVERSED: return count - i;
+    }
+    return 0;
+}
+
+static int cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_f64(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_row(const void* a, const void* b) {
+    return cmp_u64(&((const Row*)a)->key, &((const Row*)b)->key);
+}
+
+// Runs both sorts on the same input, rebuilt from ORIGINAL before each
+#define COMPARE(Type, label, n, original, radix_sort, cmp) do { \
+    Type* items; \
+    dah_init(items); \
+    dah_append_many(items, original, n); \
+    const char* radix_name = bench_name("%s radix, %s", label, suffix); \
+    MEASURE(radix_name); \
+    radix_sort; \
+    MEASURE_END(radix_name); \
+    bench_sink += (uint64_t)items[n / 2]; \
+    memcpy(items, original, n * sizeof(Type)); \
+    const char* qsort_name = bench_name("%s qsort, %s", label, suffix); \
+    MEASURE(qsort_name); \
+    qsort(items, n, sizeof(Type), cmp); \
+    MEASURE_END(qsort_name); \
+    bench_sink += (uint64_t)items[n / 2]; \
+    dah_free(items); \
+} while (0)
+
+int main(void) {
+    uint32_t* u32s = malloc(MAX_COUNT * sizeof(*u32s));
+    uint64_t* u64s = malloc(MAX_COUNT * sizeof(*u64s));
+    double* f64s = malloc(MAX_COUNT * sizeof(*f64s));
+    Row* rows = malloc(MAX_COUNT * sizeof(*rows));
+
+    printf("%-40s %10s %10s %7s\n", "", "radix", "qsort", "speedup");
+    for (size_t n = 1 << 10; n <= MAX_COUNT; n <<= 6) {
+        for (Distribution d = UNIFORM; d <= REVERSED; ++d) {
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t k = key(d, i, n);
+                u32s[i] = (uint32_t)k;
+                u64s[i] = k;
+                // Signed, so the float key handling is exercised
+                f64s[i] = (double)(int64_t)k / 3.0;
+                rows[i].key = k;
+                rows[i].payload[0] = (uint32_t)i;
+            }
+
+            const char* suffix = bench_name("%zu %s", n, distribution_names[d]);
+            for (int rep = 0; rep < BENCH_REPS; ++rep) {
+                COMPARE(uint32_t, "u32", n, u32s, dah_radix_sort_u32(items), cmp_u32);
+                COMPARE(uint64_t, "u64", n, u64s, dah_radix_sort_u64(items), cmp_u64);
+                COMPARE(double, "f64", n, f64s, dah_radix_sort_f64(items), cmp_f64);
+                // Written out, as a struct can't go in bench_sink
+                Row* items;
+                dah_init(items);
+                dah_append_many(items, rows, n);
+                const char* radix_name = bench_name("row radix, %s", suffix);
+                MEASURE(radix_name);
+                dah_radix_sort_by(items, key, DAH_KEY_U64);
+                MEASURE_END(radix_name);
+                memcpy(items, rows, n * sizeof(Row));
+                const char* qsort_name = bench_name("row qsort, %s", suffix);
+                MEASURE(qsort_name);
+                qsort(items, n, sizeof(Row), cmp_row);
+                MEASURE_END(qsort_name);
+                bench_sink += items[n / 2].key;
+                dah_free(items);
+            }
+
+            const char* labels[] = {"u32", "u64", "f64", "row"};
+            for (size_t i = 0; i < sizeof(labels)/sizeof(labels[0]); ++i) {
+                double radix = bench_average(bench_name("%s radix, %s", labels[i], suffix));
+                double quick = bench_average(bench_name("%s qsort, %s", labels[i], suffix));
+                printf("%-40s %8.3fms %8.3fms %6.1fx\n", bench_name("%s, %s", labels[i], suffix), radix * 1e3, quick * 1e3, quick / radix);
+            }
+        }
+    }
+
+    bench_dump();
+    free(u32s);
+    free(u64s);
+    free(f64s);
+    free(rows);
+    return 0;
+}
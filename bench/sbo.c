@@ -0,0 +1,97 @@
+// Per-field temporaries on a CSV-like input: a StringBuilder for every field's
+// text and a dah array of its offsets, plain against SB_SBO/DAH_SBO with inline
+// storage. malloc and realloc are counted for both
+#include "bench.h"
+
+static size_t malloc_count, realloc_count;
+
+static void* counting_malloc(size_t size) {
+    malloc_count++;
+    return malloc(size);
+}
+
+static void* counting_realloc(void* ptr, size_t size) {
+    if (ptr == NULL) malloc_count++;
+    else realloc_count++;
+    return realloc(ptr, size);
+}
+
+// Only what's included below gets the counting versions
+#define malloc(size) counting_malloc(size)
+#define realloc(ptr, size) counting_realloc(ptr, size)
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+#define SB_NO_CURL
+#define SB_IMPLEMENTATION
+#include "string_builder.h"
+#undef malloc
+#undef realloc
+
+#define RECORDS 1000000
+#define FIELDS 8
+
+// Mostly short fields, one in 16 longer than the inline buffers
+static size_t field_size(size_t i) {
+    return i % 16 == 15 ? 100 : 4 + (i * 2654435761u) % 20;
+}
+
+static void report(const char* label, const char* name, size_t mallocs, size_t reallocs) {
+    printf("%-26s %9zu mallocs, %8zu reallocs, %.3fs\n", label, mallocs, reallocs, bench_average(name));
+}
+
+int main(void) {
+    static char text[128];
+    memset(text, 'a', sizeof(text));
+
+    size_t plain_mallocs = 0, plain_reallocs = 0, sbo_mallocs = 0, sbo_reallocs = 0;
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        malloc_count = realloc_count = 0;
+        MEASURE("plain");
+        for (size_t r = 0; r < RECORDS; ++r) {
+            for (size_t f = 0; f < FIELDS; ++f) {
+                size_t size = field_size(r * FIELDS + f);
+                StringBuilder sb = {0};
+                uint32_t* offsets;
+                dah_init(offsets);
+                for (size_t i = 0; i < size; i += 4) {
+                    sb_push_bytes(&sb, text, size - i < 4 ? size - i : 4);
+                    dah_append(offsets, (uint32_t)i);
+                }
+                bench_sink += sb.count + dah_getlen(offsets);
+                sb_free(&sb);
+                dah_free(offsets);
+            }
+        }
+        MEASURE_END("plain");
+        plain_mallocs = malloc_count;
+        plain_reallocs = realloc_count;
+
+        malloc_count = realloc_count = 0;
+        MEASURE("sbo");
+        for (size_t r = 0; r < RECORDS; ++r) {
+            for (size_t f = 0; f < FIELDS; ++f) {
+                size_t size = field_size(r * FIELDS + f);
+                SB_SBO(32) sb_storage;
+                StringBuilder* sb = sb_sbo_init(&sb_storage);
+                DAH_SBO(uint32_t, 8) offsets_storage;
+                uint32_t* offsets = dah_sbo_init(&offsets_storage);
+                for (size_t i = 0; i < size; i += 4) {
+                    sb_push_bytes(sb, text, size - i < 4 ? size - i : 4);
+                    dah_append(offsets, (uint32_t)i);
+                }
+                bench_sink += sb->count + dah_getlen(offsets);
+                sb_free(sb);
+                dah_free(offsets);
+            }
+        }
+        MEASURE_END("sbo");
+        sbo_mallocs = malloc_count;
+        sbo_reallocs = realloc_count;
+    }
+
+    printf("%d records of %d fields, every field builds its text and offsets\n", RECORDS, FIELDS);
+    report("plain", "plain", plain_mallocs, plain_reallocs);
+    report("SB_SBO(32) + DAH_SBO(8)", "sbo", sbo_mallocs, sbo_reallocs);
+    bench_dump();
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Thread-local scratch memory against one global Linear, Arena and TBuffer behind
+// a mutex, the way formatting was serialized before every thread got its own.
+// Every thread formats a few strings per request and throws them away
+#include "bench.h"
+#include <pthread.h>
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#define LINEAR_IMPLEMENTATION
+#include "linear.h"
+#define TSPRINTF_IMPLEMENTATION
+#include "tsprintf.h"
+
+// Requests per thread
+#ifndef REQUESTS
+#define REQUESTS 50000
+#endif // REQUESTS
+
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+static Linear global_linear;
+static Arena global_arena;
+static char global_tbuffer_data[1 << 10];
+static TBuffer global_tbuffer;
+
+typedef void* (*Worker)(void*);
+
+static void* linear_local(void* arg) {
+    size_t id = (size_t)arg;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        size_t snapshot = temp_snapshot();
+        char* key = temp_sprintf("worker-%zu/request-%zu", id, i);
+        char* line = temp_sprintf("%s: %zu bytes", key, i * 31);
+        bench_sink += line[0];
+        temp_rewind(snapshot);
+    }
+    return NULL;
+}
+
+static void* linear_global(void* arg) {
+    size_t id = (size_t)arg;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        pthread_mutex_lock(&global_lock);
+        size_t snapshot = linear_snapshot(&global_linear);
+        char* key = linear_sprintf(&global_linear, "worker-%zu/request-%zu", id, i);
+        char* line = linear_sprintf(&global_linear, "%s: %zu bytes", key, i * 31);
+        bench_sink += line[0];
+        linear_rewind(&global_linear, snapshot);
+        pthread_mutex_unlock(&global_lock);
+    }
+    return NULL;
+}
+
+static void* arena_local(void* arg) {
+    size_t id = (size_t)arg;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        ArenaScratch scratch = arena_scratch_begin(NULL, 0);
+        char* key = arena_sprintf(scratch.arena, "worker-%zu/request-%zu", id, i);
+        char* line = arena_sprintf(scratch.arena, "%s: %zu bytes", key, i * 31);
+        bench_sink += line[0];
+        arena_scratch_end(scratch);
+    }
+    return NULL;
+}
+
+static void* arena_global(void* arg) {
+    size_t id = (size_t)arg;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        pthread_mutex_lock(&global_lock);
+        ArenaMark mark = arena_mark(&global_arena);
+        char* key = arena_sprintf(&global_arena, "worker-%zu/request-%zu", id, i);
+        char* line = arena_sprintf(&global_arena, "%s: %zu bytes", key, i * 31);
+        bench_sink += line[0];
+        arena_jumpback(&global_arena, mark);
+        pthread_mutex_unlock(&global_lock);
+    }
+    return NULL;
+}
+
+static void* tbuffer_local(void* arg) {
+    size_t id = (size_t)arg;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        char* key = tsprintf("worker-%zu/request-%zu", id, i);
+        char* line = tsprintf("%s: %zu bytes", key, i * 31);
+        bench_sink += line[0];
+    }
+    return NULL;
+}
+
+static void* tbuffer_global(void* arg) {
+    size_t id = (size_t)arg;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        pthread_mutex_lock(&global_lock);
+        char* key = tbuffer_sprintf(&global_tbuffer, "worker-%zu/request-%zu", id, i);
+        char* line = tbuffer_sprintf(&global_tbuffer, "%s: %zu bytes", key, i * 31);
+        bench_sink += line[0];
+        pthread_mutex_unlock(&global_lock);
+    }
+    return NULL;
+}
+
+static void run(const char* label, Worker worker, size_t threads) {
+    pthread_t ids[64];
+    assert(threads <= sizeof(ids)/sizeof(ids[0]));
+
+    const char* name = bench_name("%s, %zu threads", label, threads);
+    MEASURE(name);
+    for (size_t i = 0; i < threads; ++i) pthread_create(&ids[i], NULL, worker, (void*)i);
+    for (size_t i = 0; i < threads; ++i) pthread_join(ids[i], NULL);
+    MEASURE_END(name);
+}
+
+int main(void) {
+    global_tbuffer = tbuffer_from_array(global_tbuffer_data);
+    size_t thread_counts[] = {1, 2, 4, 8, 16};
+
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        for (size_t i = 0; i < sizeof(thread_counts)/sizeof(thread_counts[0]); ++i) {
+            size_t threads = thread_counts[i];
+            run("temp_linear", linear_local, threads);
+            run("global linear + mutex", linear_global, threads);
+            run("arena_scratch", arena_local, threads);
+            run("global arena + mutex", arena_global, threads);
+            run("tsprintf", tbuffer_local, threads);
+            run("global tbuffer + mutex", tbuffer_global, threads);
+        }
+    }
+
+    printf("%d requests per thread, 2 strings each\n", REQUESTS);
+    bench_dump();
+    linear_free(&global_linear);
+    arena_free(&global_arena);
+    return 0;
+}
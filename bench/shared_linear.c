@@ -0,0 +1,80 @@
+// Allocation throughput of SharedLinear from 1 to 64 threads, against a Linear
+// behind a mutex. The records are split evenly between the threads, so perfect
+// scaling keeps the time flat on as many cores
+#include "bench.h"
+#include <pthread.h>
+
+#define LINEAR_IMPLEMENTATION
+#include "linear.h"
+
+// Records across all threads, 16 to 128 bytes each
+#ifndef RECORDS
+#define RECORDS (1 << 22)
+#endif // RECORDS
+
+#define MAX_THREADS 64
+
+static SharedLinear shared;
+static Linear locked;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t per_thread;
+
+static size_t record_size(size_t i) {
+    return 16 + (i * 2654435761u) % 113;
+}
+
+static void* append_shared(void* arg) {
+    size_t first = (size_t)arg * per_thread;
+    for (size_t i = first; i < first + per_thread; ++i) {
+        char* record = shared_linear_allocb(&shared, record_size(i));
+        record[0] = (char)i;
+    }
+    return NULL;
+}
+
+static void* append_locked(void* arg) {
+    size_t first = (size_t)arg * per_thread;
+    for (size_t i = first; i < first + per_thread; ++i) {
+        pthread_mutex_lock(&lock);
+        char* record = linear_allocb(&locked, record_size(i));
+        pthread_mutex_unlock(&lock);
+        record[0] = (char)i;
+    }
+    return NULL;
+}
+
+static void run(const char* label, void* (*worker)(void*), size_t threads) {
+    pthread_t ids[MAX_THREADS];
+    per_thread = RECORDS / threads;
+
+    const char* name = bench_name("%s, %zu threads", label, threads);
+    MEASURE(name);
+    // Sized so it never has to grow. SharedLinear gets fresh chunks every run
+    // too, since shared_linear_reset frees all but one
+    if (worker == append_locked) locked = linear_new((size_t)RECORDS * 136);
+    for (size_t i = 0; i < threads; ++i) pthread_create(&ids[i], NULL, worker, (void*)i);
+    for (size_t i = 0; i < threads; ++i) pthread_join(ids[i], NULL);
+    if (worker == append_locked) linear_free(&locked);
+    MEASURE_END(name);
+}
+
+int main(void) {
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+            run("shared_linear", append_shared, threads);
+            shared_linear_reset(&shared);
+            run("linear + mutex", append_locked, threads);
+        }
+    }
+
+    printf("%d records of 16 to 128 bytes per run\n", RECORDS);
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        const char* name = bench_name("shared_linear, %zu threads", threads);
+        const char* baseline = bench_name("linear + mutex, %zu threads", threads);
+        printf("%2zu threads: shared_linear %.1f Mallocs/s, linear + mutex %.1f Mallocs/s\n", threads,
+            RECORDS / bench_average(name) / 1e6, RECORDS / bench_average(baseline) / 1e6);
+    }
+    bench_dump();
+    shared_linear_free(&shared);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Scanning one and two fields of 4M records, over a SOA container and over a
+// dah array of the same records. The SoA loops only pull the columns they use
+// through the cache, and the integer and element-wise ones vectorize
+#include "bench.h"
+
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+#include "soa.h"
+
+#define RECORDS (1 << 22)
+// Scans per measurement, so one measurement is long enough to time
+#define PASSES 20
+
+#define BODY_FIELDS(X) \
+    X(float, x) X(float, y) X(float, z) \
+    X(float, vx) X(float, vy) X(float, vz) \
+    X(uint64_t, id) X(uint32_t, flags) X(float, mass)
+
+SOA_DECLARE(Bodies, bodies, BODY_FIELDS)
+SOA_IMPLEMENT(Bodies, bodies, BODY_FIELDS)
+
+// The same records one struct each, 40 bytes
+typedef BodiesRow Body;
+
+static Body body(size_t i) {
+    float f = (float)(i % 1000);
+    Body b = {f, f + 1, f + 2, 0.5f, 0.25f, 0.125f, i, (uint32_t)(i * 2654435761u), 1 + f / 1000};
+    return b;
+}
+
+int main(void) {
+    Bodies soa = {0};
+    Body* aos;
+    dah_init(aos);
+    dah_reserve(aos, RECORDS);
+    bodies_reserve(&soa, RECORDS);
+    for (size_t i = 0; i < RECORDS; ++i) {
+        Body b = body(i);
+        dah_append(aos, b);
+        bodies_append(&soa, b);
+    }
+
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        float sum = 0;
+        MEASURE("sum of mass, aos");
+        for (int pass = 0; pass < PASSES; ++pass) {
+            for (size_t i = 0; i < RECORDS; ++i) sum += aos[i].mass;
+        }
+        MEASURE_END("sum of mass, aos");
+        MEASURE("sum of mass, soa");
+        for (int pass = 0; pass < PASSES; ++pass) {
+            for (size_t i = 0; i < RECORDS; ++i) sum += soa.mass[i];
+        }
+        MEASURE_END("sum of mass, soa");
+        bench_sink += (uint64_t)sum;
+
+        MEASURE("x += vx, aos");
+        for (int pass = 0; pass < PASSES; ++pass) {
+            for (size_t i = 0; i < RECORDS; ++i) aos[i].x += aos[i].vx;
+        }
+        MEASURE_END("x += vx, aos");
+        MEASURE("x += vx, soa");
+        for (int pass = 0; pass < PASSES; ++pass) {
+            float* restrict x = soa.x;
+            const float* restrict vx = soa.vx;
+            for (size_t i = 0; i < RECORDS; ++i) x[i] += vx[i];
+        }
+        MEASURE_END("x += vx, soa");
+
+        size_t flagged = 0;
+        MEASURE("count of flags & 1, aos");
+        for (int pass = 0; pass < PASSES; ++pass) {
+            for (size_t i = 0; i < RECORDS; ++i) flagged += aos[i].flags & 1;
+        }
+        MEASURE_END("count of flags & 1, aos");
+        MEASURE("count of flags & 1, soa");
+        for (int pass = 0; pass < PASSES; ++pass) {
+            for (size_t i = 0; i < RECORDS; ++i) flagged += soa.flags[i] & 1;
+        }
+        MEASURE_END("count of flags & 1, soa");
+        bench_sink += flagged;
+    }
+
+    printf("%d records of %zu bytes, %d scans per measurement\n", RECORDS, sizeof(Body), PASSES);
+    const char* scans[] = {"sum of mass", "x += vx", "count of flags & 1"};
+    for (size_t i = 0; i < sizeof(scans)/sizeof(scans[0]); ++i) {
+        double aos_time = bench_average(bench_name("%s, aos", scans[i]));
+        double soa_time = bench_average(bench_name("%s, soa", scans[i]));
+        printf("%-20s aos %.3fs, soa %.3fs, %.1fx\n", scans[i], aos_time, soa_time, aos_time / soa_time);
+    }
+    bench_dump();
+    bodies_free(&soa);
+    dah_free(aos);
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Splitting throughput in GB/s on 128 MiB of CSV rows and 128 MiB of log lines:
+// sv_chop_by_c, sv_split, the allocation-free split iterator and sv_chop_by_any,
+// against the byte at a time loop sv_chop_by_c used to be. bench/sv_split_scalar
+// builds it again with SV_NO_SIMD, for the table lookup fallback of sv_chop_by_any
+#include "bench.h"
+
+#define SV_IMPLEMENTATION
+#include "string_view.h"
+
+#ifndef BENCH_INPUT_SIZE
+#define BENCH_INPUT_SIZE (128 << 20)
+#endif // BENCH_INPUT_SIZE
+
+static const char* levels[] = {"INFO", "WARN", "DEBUG", "ERROR"};
+static const char* services[] = {"auth", "billing", "gateway", "scheduler", "search"};
+
+// A timestamp, an id, a name, a price, a quantity, a country, a flag and a
+// note, some fields empty, like an export
+static size_t csv_row(char* out, size_t i) {
+    return sprintf(out, "2024-03-%02zu 12:%02zu:%02zu,%zu,%s-%zu,%zu.%02zu,%zu,%s,%s,%s\n",
+        i % 28 + 1, i % 60, (i * 7) % 60, i, services[i % 5], i % 997, i % 5000, i % 100, i % 50,
+        i % 3 == 0 ? "" : "US", i % 2 ? "true" : "false", i % 5 == 0 ? "backordered since last week" : "");
+}
+
+static size_t log_line(char* out, size_t i) {
+    return sprintf(out, "2024-03-%02zu 12:%02zu:%02zu.%03zu [%s] %s: request %zu from 10.0.%zu.%zu took %zums status=%zu bytes=%zu\n",
+        i % 28 + 1, i % 60, (i * 7) % 60, i % 1000, levels[i % 4], services[i % 5], i, i % 256, (i * 13) % 256,
+        i % 900, (size_t)(i % 7 == 0 ? 500 : 200), (i * 31) % 100000);
+}
+
+static StringView generate(size_t (*line)(char*, size_t)) {
+    char* data = malloc(BENCH_INPUT_SIZE + 256);
+    size_t size = 0;
+    for (size_t i = 0; size < BENCH_INPUT_SIZE; ++i) size += line(data + size, i);
+    return sv_from_parts(data, size);
+}
+
+// sv_chop_by_c before it used memchr
+static StringView chop_bytewise(StringView* sv, char delim) {
+    size_t i = 0;
+    while (i < sv->len && sv->start[i] != delim) ++i;
+    StringView chunk = sv_from_parts(sv->start, i);
+    if (i < sv->len) i++;
+    sv->start += i;
+    sv->len -= i;
+    return chunk;
+}
+
+static void report(const char* name, size_t bytes) {
+    printf("%-40s %6.2f GB/s\n", name, bytes / bench_average(name) / 1e9);
+}
+
+int main(void) {
+    StringView csv = generate(csv_row);
+    StringView log = generate(log_line);
+    SvDelims csv_delims = sv_delims(",;\t");
+    SvDelims log_delims = sv_delims(" =[]:");
+    SvDelims newline = sv_delims("\n");
+
+    for (int rep = 0; rep < BENCH_REPS; ++rep) {
+        size_t count = 0;
+
+        MEASURE("csv lines, bytewise");
+        for (StringView rest = csv; rest.len > 0;) count += chop_bytewise(&rest, '\n').len;
+        MEASURE_END("csv lines, bytewise");
+        MEASURE("csv lines, sv_chop_by_c");
+        for (StringView rest = csv; rest.len > 0;) count += sv_chop_by_c(&rest, '\n').len;
+        MEASURE_END("csv lines, sv_chop_by_c");
+
+        MEASURE("csv lines, sv_chop_by_any \"\\n\"");
+        for (StringView rest = csv; rest.len > 0;) count += sv_chop_by_any(&rest, &newline).len;
+        MEASURE_END("csv lines, sv_chop_by_any \"\\n\"");
+
+        MEASURE("csv fields, bytewise");
+        for (StringView rest = csv; rest.len > 0;) {
+            StringView line = chop_bytewise(&rest, '\n');
+            while (line.len > 0) count += chop_bytewise(&line, ',').len;
+        }
+        MEASURE_END("csv fields, bytewise");
+        MEASURE("csv fields, sv_chop_by_c");
+        for (StringView rest = csv; rest.len > 0;) {
+            StringView line = sv_chop_by_c(&rest, '\n');
+            while (line.len > 0) count += sv_chop_by_c(&line, ',').len;
+        }
+        MEASURE_END("csv fields, sv_chop_by_c");
+        MEASURE("csv fields, sv_split_iter");
+        for (StringView rest = csv; rest.len > 0;) {
+            SvSplitIter it = sv_split_iter_init(sv_chop_by_c(&rest, '\n'), ',');
+            StringView field;
+            while (sv_split_iter_next(&it, &field)) count += field.len;
+        }
+        MEASURE_END("csv fields, sv_split_iter");
+        MEASURE("csv fields, sv_chop_by_any \",;\\t\"");
+        for (StringView rest = csv; rest.len > 0;) {
+            StringView line = sv_chop_by_c(&rest, '\n');
+            while (line.len > 0) count += sv_chop_by_any(&line, &csv_delims).len;
+        }
+        MEASURE_END("csv fields, sv_chop_by_any \",;\\t\"");
+
+        MEASURE("log lines, sv_split");
+        StringSplit lines = sv_split(log, '\n');
+        MEASURE_END("log lines, sv_split");
+        count += lines.count;
+        sv_split_free(&lines);
+
+        MEASURE("log words, bytewise");
+        for (StringView rest = log; rest.len > 0;) {
+            StringView line = chop_bytewise(&rest, '\n');
+            while (line.len > 0) count += chop_bytewise(&line, ' ').len;
+        }
+        MEASURE_END("log words, bytewise");
+        MEASURE("log words, sv_chop_by_c");
+        for (StringView rest = log; rest.len > 0;) {
+            StringView line = sv_chop_by_c(&rest, '\n');
+            while (line.len > 0) count += sv_chop_by_c(&line, ' ').len;
+        }
+        MEASURE_END("log words, sv_chop_by_c");
+        MEASURE("log tokens, sv_chop_by_any \" =[]:\"");
+        for (StringView rest = log; rest.len > 0;) {
+            StringView line = sv_chop_by_c(&rest, '\n');
+            while (line.len > 0) count += sv_chop_by_any(&line, &log_delims).len;
+        }
+        MEASURE_END("log tokens, sv_chop_by_any \" =[]:\"");
+
+        bench_sink += count;
+    }
+
+#ifdef SV_NO_SIMD
+    printf("%zu MiB of CSV and %zu MiB of logs, without SIMD\n", csv.len >> 20, log.len >> 20);
+#else
+    printf("%zu MiB of CSV and %zu MiB of logs\n", csv.len >> 20, log.len >> 20);
+#endif // SV_NO_SIMD
+    report("csv lines, bytewise", csv.len);
+    report("csv lines, sv_chop_by_c", csv.len);
+    report("csv lines, sv_chop_by_any \"\\n\"", csv.len);
+    report("csv fields, bytewise", csv.len);
+    report("csv fields, sv_chop_by_c", csv.len);
+    report("csv fields, sv_split_iter", csv.len);
+    report("csv fields, sv_chop_by_any \",;\\t\"", csv.len);
+    report("log lines, sv_split", log.len);
+    report("log words, bytewise", log.len);
+    report("log words, sv_chop_by_c", log.len);
+    report("log tokens, sv_chop_by_any \" =[]:\"", log.len);
+    bench_dump();
+    free((char*)csv.start);
+    free((char*)log.start);
+    return 0;
+}
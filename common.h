@@ -0,0 +1,5265 @@
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// An allocator containers can carry instead of calling malloc/realloc/free.
+// Old sizes are passed along, so bump allocators can grow and pop in place.
+// The members aren't named after libc, so leak checkers that macro over realloc/free still work.
+typedef struct {
+    void* (*alloc)(void* ctx, size_t size);
+    void* (*resize)(void* ctx, void* ptr, size_t oldsize, size_t newsize);
+    void (*release)(void* ctx, void* ptr, size_t size);
+    void* ctx;
+}Allocator;
+
+#define allocator_alloc(a, size) (a)->alloc((a)->ctx, size)
+#define allocator_realloc(a, ptr, oldsize, newsize) (a)->resize((a)->ctx, ptr, oldsize, newsize)
+#define allocator_free(a, ptr, size) (a)->release((a)->ctx, ptr, size)
+
+// Everything below is static, so this header needs no implementation define
+
+static inline void* allocator__libc_alloc(void* ctx, size_t size) {
+    (void)ctx;
+    return malloc(size);
+}
+
+static inline void* allocator__libc_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    (void)ctx;
+    (void)oldsize;
+    return realloc(ptr, newsize);
+}
+
+static inline void allocator__libc_free(void* ctx, void* ptr, size_t size) {
+    (void)ctx;
+    (void)size;
+    free(ptr);
+}
+
+static const Allocator libc_allocator = {
+    allocator__libc_alloc,
+    allocator__libc_realloc,
+    allocator__libc_free,
+    NULL,
+};
+
+// Gives every allocation its own anonymous mapping, meant for buffers of many MB.
+// Growing remaps the pages with mremap instead of copying them when sys/mman.h
+// declares it, which glibc does with _GNU_SOURCE
+static inline void* allocator__mmap_alloc(void* ctx, size_t size) {
+    (void)ctx;
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+static inline void* allocator__mmap_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    (void)ctx;
+#ifdef MREMAP_MAYMOVE
+    void* moved = mremap(ptr, oldsize, newsize, MREMAP_MAYMOVE);
+    return moved == MAP_FAILED ? NULL : moved;
+#else
+    void* moved = allocator__mmap_alloc(ctx, newsize);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, oldsize < newsize ? oldsize : newsize);
+    munmap(ptr, oldsize);
+    return moved;
+#endif // MREMAP_MAYMOVE
+}
+
+static inline void allocator__mmap_free(void* ctx, void* ptr, size_t size) {
+    (void)ctx;
+    munmap(ptr, size);
+}
+
+static const Allocator mmap_allocator = {
+    allocator__mmap_alloc,
+    allocator__mmap_realloc,
+    allocator__mmap_free,
+    NULL,
+};
+
+#endif // ALLOCATOR_H_
+#ifndef ARENA_H_
+#define ARENA_H_
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
+// Size of the first region, in words
+#ifndef REGION_DEFAULT_SIZE
+#define REGION_DEFAULT_SIZE (1 << 10)
+#endif // REGION_DEFAULT_SIZE
+
+// Every new region doubles the size of the previous one, up to this size, in words
+#ifndef REGION_MAX_SIZE
+#define REGION_MAX_SIZE (1 << 18)
+#endif // REGION_MAX_SIZE
+
+// Allocations bigger than this get their own exactly sized region, in words
+#ifndef ARENA_LARGE_ALLOC_SIZE
+#define ARENA_LARGE_ALLOC_SIZE (REGION_MAX_SIZE / 4)
+#endif // ARENA_LARGE_ALLOC_SIZE
+
+#ifndef ARENA_CACHE_LINE
+#define ARENA_CACHE_LINE 64
+#endif // ARENA_CACHE_LINE
+
+// Granularity in which a virtual memory arena commits its reserved range, in bytes
+#ifndef ARENA_VM_COMMIT_SIZE
+#define ARENA_VM_COMMIT_SIZE (1 << 16)
+#endif // ARENA_VM_COMMIT_SIZE
+
+// Committed memory a virtual memory arena keeps on arena_reset/arena_jumpback, in bytes
+#ifndef ARENA_VM_RETAIN_SIZE
+#define ARENA_VM_RETAIN_SIZE (1 << 22)
+#endif // ARENA_VM_RETAIN_SIZE
+
+#ifndef ARENA_VM_HUGE_PAGE_SIZE
+#define ARENA_VM_HUGE_PAGE_SIZE (1 << 21)
+#endif // ARENA_VM_HUGE_PAGE_SIZE
+
+// Scratch arenas per thread, one more than the deepest chain of conflicts you pass
+#ifndef ARENA_SCRATCH_COUNT
+#define ARENA_SCRATCH_COUNT 2
+#endif // ARENA_SCRATCH_COUNT
+
+#ifdef ARENA_AUTO_TRIM
+// arena_reset averages the usage of the last this many resets, and trims to the average
+#ifndef ARENA_TRIM_DECAY
+#define ARENA_TRIM_DECAY 8
+#endif // ARENA_TRIM_DECAY
+#endif // ARENA_AUTO_TRIM
+
+#ifdef ARENA_REGION_CACHE
+// Bytes of freed regions kept around for other arenas of the process
+#ifndef ARENA_REGION_CACHE_SIZE
+#define ARENA_REGION_CACHE_SIZE (1 << 26)
+#endif // ARENA_REGION_CACHE_SIZE
+#endif // ARENA_REGION_CACHE
+
+#ifndef ARENA_MALLOC
+#include <stdlib.h>
+#define ARENA_MALLOC malloc
+#endif // ARENA_MALLOC 
+
+#ifndef ARENA_FREE
+#include <stdlib.h>
+#define ARENA_FREE free
+#endif // ARENA_FREE 
+
+typedef struct arena_region_s {
+    size_t capacity;
+    size_t count;
+    struct arena_region_s* next;
+
+    uintptr_t data[];
+}ArenaRegion;
+
+#define ARENA_VM (1 << 0)
+// Asks the kernel to back the arena with transparent huge pages
+#define ARENA_VM_HUGEPAGE (1 << 1)
+// Maps the arena from the hugetlbfs pool, falls back to regular pages if it's empty
+#define ARENA_VM_HUGETLB (1 << 2)
+
+#ifdef ARENA_STATS
+// Allocations are bucketed by the bit width of their size, the last bucket takes the rest
+#ifndef ARENA_STATS_CLASSES
+#define ARENA_STATS_CLASSES 32
+#endif // ARENA_STATS_CLASSES
+
+typedef struct {
+    // Bytes asked for by the caller
+    size_t requested;
+    // Bytes taken from regions, including rounding and alignment padding
+    size_t consumed;
+    // Bytes left unused at the end of regions the arena moved past
+    size_t tail_waste;
+    size_t regions;
+    size_t large_regions;
+    size_t in_use;
+    size_t peak;
+    size_t jumpbacks;
+    size_t resets;
+    size_t size_classes[ARENA_STATS_CLASSES];
+}ArenaStats;
+#endif // ARENA_STATS
+
+typedef struct {
+    ArenaRegion *start, *end;
+    // Dedicated regions of large allocations, newest first
+    ArenaRegion* large;
+
+    // Non-zero for arenas set up by arena_init_vm
+    int vm_flags;
+    // Bytes of the reserved range that are backed by memory
+    size_t committed;
+
+#ifdef ARENA_AUTO_TRIM
+    // Decaying average of the bytes in use at arena_reset
+    size_t peak_avg;
+#endif // ARENA_AUTO_TRIM
+
+#ifdef ARENA_STATS
+    ArenaStats stats;
+#endif // ARENA_STATS
+}Arena;
+
+typedef struct {
+    ArenaRegion* r;
+    size_t count;
+    ArenaRegion* large;
+}ArenaMark;
+
+typedef struct {
+    Arena* arena;
+    ArenaMark mark;
+}ArenaScratch;
+
+void* arena_alloc(Arena* self, size_t size);
+#define arena_calloc(arena, size) memset(arena_alloc(arena, size), 0, size)
+// Allocates memory aligned to ALIGN, which must be a power of two
+void* arena_alloc_aligned(Arena* self, size_t size, size_t align);
+#define arena_calloc_aligned(arena, size, align) memset(arena_alloc_aligned(arena, size, align), 0, size)
+#define arena_alloc_type(arena, Type) ((Type*)arena_alloc_aligned(arena, sizeof(Type), _Alignof(Type)))
+#define arena_alloc_array(arena, n, Type) ((Type*)arena_alloc_aligned(arena, sizeof(Type) * (n), _Alignof(Type)))
+// Allocates whole cache lines, so the memory doesn't share a line with any other allocation
+#define arena_alloc_cacheline(arena, size) \
+    arena_alloc_aligned(arena, ((size) + ARENA_CACHE_LINE - 1) & ~(size_t)(ARENA_CACHE_LINE - 1), ARENA_CACHE_LINE)
+// Grows or shrinks PTR in place when it's the last allocation, otherwise copies it to new memory
+void* arena_realloc(Arena* self, size_t oldsize, size_t newsize, void* ptr);
+// Frees PTR if it's the last allocation. Returns false and does nothing otherwise
+bool arena_pop(Arena* self, void* ptr, size_t size);
+#define arena_memdup(arena, ptr, size) memcpy(arena_alloc(arena, size), ptr, size)
+// Formats straight into the free space of the current region, and only formats
+// again into a fresh region when the string didn't fit
+__attribute__((format(printf, 2, 3)))
+char* arena_sprintf(Arena* self, const char* fmt, ...);
+char* arena_vsprintf(Arena* self, const char* fmt, va_list args);
+char* arena_strdup(Arena* self, const char* cstr);
+char* arena_realpath(Arena* self, const char* path);
+
+// Reserves RESERVE bytes of address space as the only region of an unused arena.
+// Pages are committed as the arena grows, and given back past ARENA_VM_RETAIN_SIZE
+// on arena_reset/arena_jumpback. Allocations past the reservation return NULL.
+bool arena_init_vm(Arena* self, size_t reserve, int flags);
+
+// Allocator for containers that live on SELF. Freeing only reclaims the last allocation
+Allocator arena_allocator(Arena* self);
+
+ArenaMark arena_mark(Arena* self);
+void arena_jumpback(Arena* self, ArenaMark mark);
+void arena_reset(Arena* self);
+void arena_free(Arena* self);
+// Releases the unused regions once KEEP_BYTES of capacity are covered, or decommits
+// past them in virtual memory arenas. Returns the number of bytes released.
+// With ARENA_AUTO_TRIM, arena_reset trims to a decaying average of recent usage.
+size_t arena_trim(Arena* self, size_t keep_bytes);
+
+#ifdef ARENA_REGION_CACHE
+// Frees the regions the process-wide cache is holding on to
+void arena_region_cache_clear(void);
+#endif // ARENA_REGION_CACHE
+
+// Returns one of the calling thread's scratch arenas that isn't in CONFLICTS.
+// Pass the arenas your caller handed you, so temporaries never land in them.
+// Scratch arenas are freed when their thread exits.
+Arena* arena_scratch(Arena** conflicts, size_t conflicts_count);
+// Gets a scratch arena and marks it, for arena_scratch_end to jump back to
+ArenaScratch arena_scratch_begin(Arena** conflicts, size_t conflicts_count);
+#define arena_scratch_end(scratch) arena_jumpback((scratch).arena, (scratch).mark)
+
+#ifdef ARENA_STATS
+// Prints usage counters and a size class histogram of the allocations
+void arena_stats_dump(Arena* self, FILE* sink);
+#endif // ARENA_STATS
+
+#endif // ARENA_H_
+
+#ifdef ARENA_IMPLEMENTATION
+#undef ARENA_IMPLEMENTATION
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#ifdef ARENA_STATS
+#define ARENA__STAT(stmt) stmt
+
+static void arena__stats_alloc(Arena* self, size_t size, size_t words) {
+    ArenaStats* stats = &self->stats;
+    stats->requested += size;
+    stats->consumed += words * sizeof(uintptr_t);
+    stats->in_use += words * sizeof(uintptr_t);
+    if (stats->in_use > stats->peak) stats->peak = stats->in_use;
+
+    size_t class = 0;
+    while (class < ARENA_STATS_CLASSES - 1 && (size >> class) != 0) class++;
+    stats->size_classes[class]++;
+}
+
+static void arena__stats_recount(Arena* self) {
+    size_t in_use = 0;
+    for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
+        in_use += r->count;
+        if (r == self->end) break;
+    }
+    for (ArenaRegion* r = self->large; r != NULL; r = r->next) {
+        in_use += r->count;
+    }
+    self->stats.in_use = in_use * sizeof(uintptr_t);
+}
+#else
+#define ARENA__STAT(stmt)
+#endif // ARENA_STATS
+
+#ifdef ARENA_REGION_CACHE
+// Regions of up to REGION_MAX_SIZE words are cached, large ones included, the
+// bigger large ones go straight back to ARENA_FREE
+static pthread_mutex_t arena__cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static ArenaRegion* arena__cache;
+static size_t arena__cache_bytes;
+
+// Takes a cached region of at least CAPACITY words, but no more than twice that
+static ArenaRegion* arena__cache_take(size_t capacity) {
+    if (capacity > REGION_MAX_SIZE) return NULL;
+
+    pthread_mutex_lock(&arena__cache_lock);
+    ArenaRegion** prev = &arena__cache;
+    ArenaRegion* r = arena__cache;
+    while (r != NULL && (r->capacity < capacity || r->capacity / 2 > capacity)) {
+        prev = &r->next;
+        r = r->next;
+    }
+    if (r != NULL) {
+        *prev = r->next;
+        arena__cache_bytes -= r->capacity * sizeof(uintptr_t);
+    }
+    pthread_mutex_unlock(&arena__cache_lock);
+    return r;
+}
+
+static bool arena__cache_give(ArenaRegion* r) {
+    if (r->capacity > REGION_MAX_SIZE) return false;
+
+    size_t bytes = r->capacity * sizeof(uintptr_t);
+    pthread_mutex_lock(&arena__cache_lock);
+    bool fits = arena__cache_bytes + bytes <= ARENA_REGION_CACHE_SIZE;
+    if (fits) {
+        r->next = arena__cache;
+        arena__cache = r;
+        arena__cache_bytes += bytes;
+    }
+    pthread_mutex_unlock(&arena__cache_lock);
+    return fits;
+}
+
+void arena_region_cache_clear(void) {
+    pthread_mutex_lock(&arena__cache_lock);
+    ArenaRegion* r = arena__cache;
+    arena__cache = NULL;
+    arena__cache_bytes = 0;
+    pthread_mutex_unlock(&arena__cache_lock);
+
+    while (r != NULL) {
+        ArenaRegion* n = r->next;
+        ARENA_FREE(r);
+        r = n;
+    }
+}
+#endif // ARENA_REGION_CACHE
+
+static void arena__release_region(ArenaRegion* r) {
+#ifdef ARENA_REGION_CACHE
+    if (arena__cache_give(r)) return;
+#endif // ARENA_REGION_CACHE
+    ARENA_FREE(r);
+}
+
+static ArenaRegion* arena__new_region(size_t capacity) {
+    ArenaRegion* r = NULL;
+#ifdef ARENA_REGION_CACHE
+    r = arena__cache_take(capacity);
+    if (r != NULL) capacity = r->capacity;
+#endif // ARENA_REGION_CACHE
+    if (r == NULL) r = ARENA_MALLOC(sizeof(*r) + capacity * sizeof(*r->data));
+    assert(r != NULL);
+    r->count = 0;
+    r->capacity = capacity;
+    r->next = NULL;
+    return r;
+}
+
+static size_t arena__next_capacity(Arena* self, size_t realsize) {
+    size_t capacity = REGION_DEFAULT_SIZE;
+    if (self->end != NULL) {
+        capacity = self->end->capacity * 2;
+        if (capacity > REGION_MAX_SIZE) capacity = REGION_MAX_SIZE;
+    }
+    return capacity < realsize ? realsize : capacity;
+}
+
+// Padding needed to align the next allocation in R, in words
+static size_t arena__padding(ArenaRegion* r, size_t align) {
+    uintptr_t p = (uintptr_t)(r->data + r->count);
+    return ((align - (p & (align - 1))) & (align - 1)) / sizeof(uintptr_t);
+}
+
+static size_t arena__vm_granularity(Arena* self) {
+    if ((self->vm_flags & ARENA_VM_HUGETLB) && ARENA_VM_COMMIT_SIZE < ARENA_VM_HUGE_PAGE_SIZE) {
+        return ARENA_VM_HUGE_PAGE_SIZE;
+    }
+    return ARENA_VM_COMMIT_SIZE;
+}
+
+// Makes the first END bytes of the reserved range usable
+static bool arena__vm_commit(Arena* self, size_t end) {
+    if (end <= self->committed) return true;
+
+    size_t granularity = arena__vm_granularity(self);
+    size_t target = (end + granularity - 1) / granularity * granularity;
+    if (mprotect((char*)self->start + self->committed, target - self->committed, PROT_READ | PROT_WRITE) < 0) {
+        fprintf(stderr, "Couldn't commit arena memory: %s\n", strerror(errno));
+        return false;
+    }
+
+    self->committed = target;
+    return true;
+}
+
+// Gives back committed memory past the first KEEP bytes, returns how much
+static size_t arena__vm_release(Arena* self, size_t keep) {
+    size_t granularity = arena__vm_granularity(self);
+    keep = (keep + granularity - 1) / granularity * granularity;
+    if (keep >= self->committed) return 0;
+
+    char* base = (char*)self->start;
+    size_t released = self->committed - keep;
+    madvise(base + keep, released, MADV_DONTNEED);
+    mprotect(base + keep, released, PROT_NONE);
+    self->committed = keep;
+    return released;
+}
+
+// Same as arena__vm_release, but never goes below ARENA_VM_RETAIN_SIZE
+static void arena__vm_decommit(Arena* self, size_t keep) {
+    if (keep < ARENA_VM_RETAIN_SIZE) keep = ARENA_VM_RETAIN_SIZE;
+    arena__vm_release(self, keep);
+}
+
+bool arena_init_vm(Arena* self, size_t reserve, int flags) {
+    assert(self->start == NULL && self->large == NULL && "arena_init_vm needs an unused arena");
+
+    self->vm_flags = flags | ARENA_VM;
+    size_t granularity = arena__vm_granularity(self);
+    reserve = (reserve + granularity - 1) / granularity * granularity;
+
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    void* base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (flags & ARENA_VM_HUGETLB) {
+        // Without MAP_NORESERVE the whole range is reserved from the pool up front,
+        // so an empty pool fails here instead of raising SIGBUS on first touch
+        base = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == MAP_FAILED) {
+            fprintf(stderr, "Couldn't map huge pages, falling back to regular pages: %s\n", strerror(errno));
+        }
+    }
+#endif // MAP_HUGETLB
+    if (base == MAP_FAILED) {
+        self->vm_flags &= ~ARENA_VM_HUGETLB;
+        base = mmap(NULL, reserve, PROT_NONE, map_flags, -1, 0);
+    }
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Couldn't reserve %zu bytes for arena: %s\n", reserve, strerror(errno));
+        self->vm_flags = 0;
+        return false;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (flags & ARENA_VM_HUGEPAGE) madvise(base, reserve, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+
+    self->start = base;
+    self->committed = 0;
+    if (!arena__vm_commit(self, sizeof(ArenaRegion))) {
+        munmap(base, reserve);
+        self->start = NULL;
+        self->vm_flags = 0;
+        return false;
+    }
+
+    self->start->count = 0;
+    self->start->capacity = (reserve - sizeof(ArenaRegion)) / sizeof(uintptr_t);
+    self->start->next = NULL;
+    self->end = self->start;
+    return true;
+}
+
+static void* arena__vm_alloc(Arena* self, size_t size, size_t align) {
+    size_t realsize = (size + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+    ArenaRegion* r = self->end;
+    size_t padding = arena__padding(r, align);
+    if (r->count + padding + realsize > r->capacity) {
+        fprintf(stderr, "Arena ran out of its %zu reserved bytes\n", r->capacity * sizeof(uintptr_t));
+        return NULL;
+    }
+
+    size_t end = sizeof(ArenaRegion) + (r->count + padding + realsize) * sizeof(uintptr_t);
+    if (!arena__vm_commit(self, end)) return NULL;
+
+    r->count += padding;
+    void* mem = r->data + r->count;
+    r->count += realsize;
+    ARENA__STAT(arena__stats_alloc(self, size, padding + realsize));
+    return mem;
+}
+
+void* arena_alloc_aligned(Arena* self, size_t size, size_t align) {
+    size_t word_size = sizeof(uintptr_t);
+    assert((align & (align - 1)) == 0 && "alignment must be a power of two");
+    if (align < word_size) align = word_size;
+
+    size_t realsize = (size + word_size - 1) / word_size;
+    // Worst case padding in a fresh region, in words
+    size_t slack = (align - word_size) / word_size;
+
+    if (self->vm_flags) {
+        return arena__vm_alloc(self, size, align);
+    }
+
+    if (realsize > ARENA_LARGE_ALLOC_SIZE) {
+        ArenaRegion* r = arena__new_region(realsize + slack);
+        void* mem = r->data + arena__padding(r, align);
+        r->count = r->capacity;
+        r->next = self->large;
+        self->large = r;
+        ARENA__STAT(self->stats.large_regions++);
+        ARENA__STAT(arena__stats_alloc(self, size, r->capacity));
+        return mem;
+    }
+
+    if (self->end == NULL) {
+        self->end = arena__new_region(arena__next_capacity(self, realsize + slack));
+        self->start = self->end;
+        ARENA__STAT(self->stats.regions++);
+    }
+
+    size_t padding = arena__padding(self->end, align);
+    if (self->end->count + padding + realsize > self->end->capacity) {
+        // Regions after end are always empty, so only the next one is worth checking
+        ArenaRegion* next = self->end->next;
+        if (next == NULL || realsize + slack > next->capacity) {
+            next = arena__new_region(arena__next_capacity(self, realsize + slack));
+            next->next = self->end->next;
+            self->end->next = next;
+            ARENA__STAT(self->stats.regions++);
+        }
+        ARENA__STAT(self->stats.tail_waste += (self->end->capacity - self->end->count) * sizeof(uintptr_t));
+        self->end = next;
+        padding = arena__padding(self->end, align);
+    }
+
+    self->end->count += padding;
+    void* mem = self->end->data + self->end->count;
+    self->end->count += realsize;
+    ARENA__STAT(arena__stats_alloc(self, size, padding + realsize));
+    return mem;
+}
+
+void* arena_alloc(Arena* self, size_t size) {
+    return arena_alloc_aligned(self, size, sizeof(uintptr_t));
+}
+
+// Whether PTR of SIZE bytes is the last allocation in R
+static bool arena__is_last(ArenaRegion* r, void* ptr, size_t size) {
+    size_t word_size = sizeof(uintptr_t);
+    uintptr_t p = (uintptr_t)ptr;
+    uintptr_t data = (uintptr_t)r->data;
+    return data <= p && p + (size + word_size - 1) / word_size * word_size == (uintptr_t)(r->data + r->count);
+}
+
+// Reallocations that have to move get ALIGN, same as the original allocation
+static void* arena__realloc_aligned(Arena* self, size_t oldsize, size_t newsize, void* ptr, size_t align) {
+    if (ptr == NULL) return arena_alloc_aligned(self, newsize, align);
+
+    ArenaRegion* r = self->end;
+    if (r != NULL && arena__is_last(r, ptr, oldsize)) {
+        size_t word_size = sizeof(uintptr_t);
+        size_t start = (uintptr_t*)ptr - r->data;
+        size_t end = start + (newsize + word_size - 1) / word_size;
+
+        bool fits = end <= r->capacity;
+        if (fits && self->vm_flags) fits = arena__vm_commit(self, sizeof(ArenaRegion) + end * word_size);
+        if (fits) {
+            ARENA__STAT(if (newsize > oldsize) arena__stats_alloc(self, newsize - oldsize, end - r->count));
+            r->count = end;
+            ARENA__STAT(arena__stats_recount(self));
+            return ptr;
+        }
+    }
+
+    void* newptr = arena_alloc_aligned(self, newsize, align);
+    if (newptr == NULL) return NULL;
+    return memcpy(newptr, ptr, oldsize < newsize ? oldsize : newsize);
+}
+
+void* arena_realloc(Arena* self, size_t oldsize, size_t newsize, void* ptr) {
+    return arena__realloc_aligned(self, oldsize, newsize, ptr, sizeof(uintptr_t));
+}
+
+bool arena_pop(Arena* self, void* ptr, size_t size) {
+    ArenaRegion* r = self->end;
+    if (r == NULL || !arena__is_last(r, ptr, size)) return false;
+
+    r->count = (uintptr_t*)ptr - r->data;
+    ARENA__STAT(arena__stats_recount(self));
+    return true;
+}
+
+// Bytes at the end of the current region that can be written right away
+static size_t arena__free_bytes(Arena* self) {
+    ArenaRegion* r = self->end;
+    if (r == NULL) return 0;
+
+    if (self->vm_flags) {
+        return self->committed - sizeof(ArenaRegion) - r->count * sizeof(uintptr_t);
+    }
+    return (r->capacity - r->count) * sizeof(uintptr_t);
+}
+
+char* arena_vsprintf(Arena* self, const char* fmt, va_list args) {
+    size_t room = arena__free_bytes(self);
+    char* start = room > 0 ? (char*)(self->end->data + self->end->count) : NULL;
+
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(start, room, fmt, copy);
+    va_end(copy);
+
+    if (n < 0) return NULL;
+
+    if ((size_t)n < room) {
+        size_t word_size = sizeof(uintptr_t);
+        size_t realsize = (n + 1 + word_size - 1) / word_size;
+        self->end->count += realsize;
+        ARENA__STAT(arena__stats_alloc(self, n + 1, realsize));
+        return start;
+    }
+
+    char* cstr = arena_alloc(self, n + 1);
+    if (cstr == NULL) return NULL;
+
+    vsnprintf(cstr, n + 1, fmt, args);
+    return cstr;
+}
+
+char* arena_sprintf(Arena* self, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char* cstr = arena_vsprintf(self, fmt, args);
+    va_end(args);
+    return cstr;
+}
+
+char* arena_strdup(Arena* self, const char* cstr) {
+    size_t len = strlen(cstr) + 1;
+    char* copy = arena_alloc(self, len);
+    return memcpy(copy, cstr, len);
+}
+
+char* arena_realpath(Arena* self, const char* path) {
+    char* real = realpath(path, NULL);
+    if (real == NULL) {
+        fprintf(stderr, "Couldn't get real path '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    char* out = arena_strdup(self, real);
+    free(real);
+    return out;
+}
+
+#ifdef ARENA_AUTO_TRIM
+// Bytes taken from the regular regions, alignment padding included
+static size_t arena__used_bytes(Arena* self) {
+    size_t used = 0;
+    for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
+        used += r->count * sizeof(uintptr_t);
+        if (r == self->end) break;
+    }
+    return used;
+}
+#endif // ARENA_AUTO_TRIM
+
+size_t arena_trim(Arena* self, size_t keep_bytes) {
+    if (self->start == NULL) return 0;
+
+    if (self->vm_flags) {
+        size_t used = sizeof(ArenaRegion) + self->start->count * sizeof(uintptr_t);
+        return arena__vm_release(self, used > keep_bytes ? used : keep_bytes);
+    }
+
+    // Regions up to end are in use and always stay, the empty ones after it
+    // stay until KEEP_BYTES are covered. The region that crosses KEEP_BYTES
+    // stays too, or a steady workload would free and malloc it every cycle
+    size_t kept = 0;
+    ArenaRegion* r = self->start;
+    while (r != self->end) {
+        kept += r->capacity * sizeof(uintptr_t);
+        r = r->next;
+    }
+    kept += r->capacity * sizeof(uintptr_t);
+
+    size_t released = 0;
+    ArenaRegion* prev = r;
+    r = r->next;
+    while (r != NULL) {
+        ArenaRegion* n = r->next;
+        size_t bytes = r->capacity * sizeof(uintptr_t);
+        if (kept < keep_bytes) {
+            kept += bytes;
+            prev = r;
+        } else {
+            prev->next = n;
+            released += bytes;
+            arena__release_region(r);
+        }
+        r = n;
+    }
+    return released;
+}
+
+static void arena__free_large(Arena* self, ArenaRegion* until) {
+    while (self->large != until) {
+        ArenaRegion* n = self->large->next;
+        arena__release_region(self->large);
+        self->large = n;
+    }
+}
+
+void arena_reset(Arena* self) {
+    arena__free_large(self, NULL);
+    ARENA__STAT(self->stats.resets++);
+    ARENA__STAT(self->stats.in_use = 0);
+
+    size_t keep = 0;
+#ifdef ARENA_AUTO_TRIM
+    // One huge cycle only moves the average by a fraction, so it can't pin its memory
+    size_t used = arena__used_bytes(self);
+    self->peak_avg = self->peak_avg - self->peak_avg / ARENA_TRIM_DECAY + used / ARENA_TRIM_DECAY;
+    keep = self->peak_avg;
+#endif // ARENA_AUTO_TRIM
+
+    for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
+        r->count = 0;
+    }
+
+    self->end = self->start;
+
+    if (self->vm_flags) {
+        arena__vm_decommit(self, sizeof(ArenaRegion) + keep);
+        return;
+    }
+
+#ifdef ARENA_AUTO_TRIM
+    arena_trim(self, keep);
+#endif // ARENA_AUTO_TRIM
+    (void)keep;
+}
+
+ArenaMark arena_mark(Arena* self) {
+    ArenaMark mark = {self->end, self->end != NULL ? self->end->count : 0, self->large};
+    return mark;
+}
+
+void arena_jumpback(Arena* self, ArenaMark mark) {
+    arena__free_large(self, mark.large);
+    ARENA__STAT(self->stats.jumpbacks++);
+
+    if (mark.r == NULL) {
+        for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
+            r->count = 0;
+        }
+        self->end = self->start;
+        ARENA__STAT(arena__stats_recount(self));
+        return;
+    }
+
+    mark.r->count = mark.count;
+    for (ArenaRegion* r = mark.r->next; r != NULL; r = r->next) {
+        r->count = 0;
+    }
+
+    self->end = mark.r;
+    ARENA__STAT(arena__stats_recount(self));
+
+    if (self->vm_flags) {
+        arena__vm_decommit(self, sizeof(ArenaRegion) + mark.count * sizeof(uintptr_t));
+    }
+}
+
+void arena_free(Arena* self) {
+    arena__free_large(self, NULL);
+
+    if (self->vm_flags) {
+        if (self->start != NULL) {
+            munmap(self->start, sizeof(ArenaRegion) + self->start->capacity * sizeof(uintptr_t));
+        }
+        self->start = NULL;
+        self->end = NULL;
+        self->vm_flags = 0;
+        self->committed = 0;
+        return;
+    }
+
+    ArenaRegion* r = self->start;
+    while (r != NULL) {
+        ArenaRegion* n = r->next;
+        arena__release_region(r);
+        r = n;
+    }
+    self->start = NULL;
+    self->end = NULL;
+}
+
+static void* arena__allocator_alloc(void* ctx, size_t size) {
+    return arena_alloc_aligned(ctx, size, _Alignof(max_align_t));
+}
+
+static void* arena__allocator_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    return arena__realloc_aligned(ctx, oldsize, newsize, ptr, _Alignof(max_align_t));
+}
+
+static void arena__allocator_free(void* ctx, void* ptr, size_t size) {
+    arena_pop(ctx, ptr, size);
+}
+
+Allocator arena_allocator(Arena* self) {
+    Allocator allocator = {arena__allocator_alloc, arena__allocator_realloc, arena__allocator_free, self};
+    return allocator;
+}
+
+static _Thread_local Arena arena__scratch[ARENA_SCRATCH_COUNT];
+static _Thread_local bool arena__scratch_registered;
+static pthread_key_t arena__scratch_key;
+static pthread_once_t arena__scratch_once = PTHREAD_ONCE_INIT;
+
+static void arena__scratch_destroy(void* scratch) {
+    Arena* arenas = scratch;
+    for (size_t i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+        arena_free(&arenas[i]);
+    }
+}
+
+static void arena__scratch_create_key(void) {
+    int err = pthread_key_create(&arena__scratch_key, arena__scratch_destroy);
+    assert(err == 0);
+    (void)err;
+}
+
+Arena* arena_scratch(Arena** conflicts, size_t conflicts_count) {
+    if (!arena__scratch_registered) {
+        // The key's destructor only runs for threads that set a value
+        pthread_once(&arena__scratch_once, arena__scratch_create_key);
+        pthread_setspecific(arena__scratch_key, arena__scratch);
+        arena__scratch_registered = true;
+    }
+
+    for (size_t i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+        bool conflicting = false;
+        for (size_t j = 0; j < conflicts_count; ++j) {
+            if (conflicts[j] == &arena__scratch[i]) {
+                conflicting = true;
+                break;
+            }
+        }
+
+        if (!conflicting) return &arena__scratch[i];
+    }
+
+    assert(0 && "every scratch arena conflicts, raise ARENA_SCRATCH_COUNT");
+    return NULL;
+}
+
+ArenaScratch arena_scratch_begin(Arena** conflicts, size_t conflicts_count) {
+    ArenaScratch scratch;
+    scratch.arena = arena_scratch(conflicts, conflicts_count);
+    scratch.mark = arena_mark(scratch.arena);
+    return scratch;
+}
+
+#ifdef ARENA_STATS
+void arena_stats_dump(Arena* self, FILE* sink) {
+    ArenaStats* stats = &self->stats;
+    fprintf(sink, "Arena stats:\n");
+    fprintf(sink, "    requested: %zu bytes\n", stats->requested);
+    fprintf(sink, "    consumed: %zu bytes\n", stats->consumed);
+    fprintf(sink, "    in use: %zu bytes (peak %zu bytes)\n", stats->in_use, stats->peak);
+    fprintf(sink, "    regions: %zu, large regions: %zu\n", stats->regions, stats->large_regions);
+    fprintf(sink, "    tail waste: %zu bytes (%zu bytes per region)\n",
+            stats->tail_waste, stats->regions > 0 ? stats->tail_waste / stats->regions : 0);
+    fprintf(sink, "    jumpbacks: %zu, resets: %zu\n", stats->jumpbacks, stats->resets);
+
+    fprintf(sink, "    size classes:\n");
+    for (size_t i = 0; i < ARENA_STATS_CLASSES; ++i) {
+        if (stats->size_classes[i] == 0) continue;
+
+        if (i <= 1) {
+            fprintf(sink, "        %zu: %zu\n", i, stats->size_classes[i]);
+        } else if (i == ARENA_STATS_CLASSES - 1) {
+            fprintf(sink, "        >= %zu: %zu\n", (size_t)1 << (i - 1), stats->size_classes[i]);
+        } else {
+            fprintf(sink, "        %zu-%zu: %zu\n", (size_t)1 << (i - 1), ((size_t)1 << i) - 1, stats->size_classes[i]);
+        }
+    }
+}
+#endif // ARENA_STATS
+#endif // ARENA_IMPLEMENTATION
+#ifndef POOL_H_
+#define POOL_H_
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifndef ARENA_H_
+#include "arena.h"
+#endif // ARENA_H_
+
+// Objects a PoolCache moves to and from the shared depot at once
+#ifndef POOL_BATCH_SIZE
+#define POOL_BATCH_SIZE 32
+#endif // POOL_BATCH_SIZE
+
+#ifndef POOL_ASSERT
+#include <assert.h>
+#define POOL_ASSERT assert
+#endif // POOL_ASSERT
+
+typedef struct pool_node_s {
+    struct pool_node_s* next;
+    // Links the first nodes of the batches in the depot
+    struct pool_node_s* next_batch;
+}PoolNode;
+
+// Fixed-size objects slab-allocated from an arena and recycled through free lists.
+// pool_alloc/pool_free are for a single thread. Other threads go through their
+// own PoolCache, which only locks the pool to trade whole batches with the depot.
+typedef struct {
+    Arena arena;
+    size_t item_size;
+    size_t item_align;
+
+    PoolNode* free;
+
+    pthread_mutex_t lock;
+    PoolNode* depot;
+}Pool;
+
+typedef struct {
+    Pool* pool;
+    PoolNode* free;
+    size_t count;
+}PoolCache;
+
+void pool_init(Pool* self, size_t item_size, size_t item_align);
+#define pool_init_for(pool, Type) pool_init(pool, sizeof(Type), _Alignof(Type))
+void* pool_alloc(Pool* self);
+void pool_free(Pool* self, void* item);
+// Frees the memory of every object at once
+void pool_destroy(Pool* self);
+
+PoolCache pool_cache_new(Pool* pool);
+void* pool_cache_alloc(PoolCache* self);
+void pool_cache_free(PoolCache* self, void* item);
+// Hands every cached object back to the depot, call it before the thread exits
+void pool_cache_flush(PoolCache* self);
+
+#endif // POOL_H_
+
+#ifdef POOL_IMPLEMENTATION
+#undef POOL_IMPLEMENTATION
+
+void pool_init(Pool* self, size_t item_size, size_t item_align) {
+    if (item_align < _Alignof(PoolNode)) item_align = _Alignof(PoolNode);
+    if (item_size < sizeof(PoolNode)) item_size = sizeof(PoolNode);
+    item_size = (item_size + item_align - 1) & ~(item_align - 1);
+
+    Arena arena = {0};
+    self->arena = arena;
+    self->item_size = item_size;
+    self->item_align = item_align;
+    self->free = NULL;
+    self->depot = NULL;
+    pthread_mutex_init(&self->lock, NULL);
+}
+
+// Takes a batch from the depot, or carves a new one from the arena. Needs the lock
+static PoolNode* pool__take_batch(Pool* self) {
+    PoolNode* batch = self->depot;
+    if (batch != NULL) {
+        self->depot = batch->next_batch;
+        return batch;
+    }
+
+    char* slab = arena_alloc_aligned(&self->arena, self->item_size * POOL_BATCH_SIZE, self->item_align);
+    POOL_ASSERT(slab != NULL);
+
+    for (size_t i = 0; i < POOL_BATCH_SIZE; ++i) {
+        PoolNode* node = (PoolNode*)(slab + i * self->item_size);
+        node->next = i + 1 < POOL_BATCH_SIZE ? (PoolNode*)(slab + (i + 1) * self->item_size) : NULL;
+    }
+    return (PoolNode*)slab;
+}
+
+static void pool__give_batch(Pool* self, PoolNode* batch) {
+    pthread_mutex_lock(&self->lock);
+    batch->next_batch = self->depot;
+    self->depot = batch;
+    pthread_mutex_unlock(&self->lock);
+}
+
+void* pool_alloc(Pool* self) {
+    if (self->free == NULL) {
+        pthread_mutex_lock(&self->lock);
+        self->free = pool__take_batch(self);
+        pthread_mutex_unlock(&self->lock);
+    }
+
+    PoolNode* node = self->free;
+    self->free = node->next;
+    return node;
+}
+
+void pool_free(Pool* self, void* item) {
+    PoolNode* node = item;
+    node->next = self->free;
+    self->free = node;
+}
+
+void pool_destroy(Pool* self) {
+    arena_free(&self->arena);
+    pthread_mutex_destroy(&self->lock);
+    self->free = NULL;
+    self->depot = NULL;
+}
+
+PoolCache pool_cache_new(Pool* pool) {
+    PoolCache cache = {pool, NULL, 0};
+    return cache;
+}
+
+void* pool_cache_alloc(PoolCache* self) {
+    if (self->free == NULL) {
+        pthread_mutex_lock(&self->pool->lock);
+        self->free = pool__take_batch(self->pool);
+        pthread_mutex_unlock(&self->pool->lock);
+
+        self->count = 0;
+        for (PoolNode* node = self->free; node != NULL; node = node->next) self->count++;
+    }
+
+    PoolNode* node = self->free;
+    self->free = node->next;
+    self->count--;
+    return node;
+}
+
+void pool_cache_free(PoolCache* self, void* item) {
+    PoolNode* node = item;
+    node->next = self->free;
+    self->free = node;
+    self->count++;
+
+    // Keep a batch around, so alternating alloc/free doesn't bounce on the depot
+    if (self->count >= 2 * POOL_BATCH_SIZE) {
+        PoolNode* batch = self->free;
+        PoolNode* last = batch;
+        for (size_t i = 1; i < POOL_BATCH_SIZE; ++i) last = last->next;
+
+        self->free = last->next;
+        self->count -= POOL_BATCH_SIZE;
+        last->next = NULL;
+        pool__give_batch(self->pool, batch);
+    }
+}
+
+void pool_cache_flush(PoolCache* self) {
+    if (self->free != NULL) pool__give_batch(self->pool, self->free);
+    self->free = NULL;
+    self->count = 0;
+}
+
+#endif // POOL_IMPLEMENTATION
+#ifndef PERF_H_
+#define PERF_H_
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+double clock_secs(clock_t start);
+double clock_msecs(clock_t start);
+long clock_nsecs(clock_t start);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // PERF_H_
+
+#ifdef CPERF_IMPLEMENTATION
+#undef CPERF_IMPLEMENTATION
+
+double clock_secs(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+double clock_msecs(clock_t start) {
+    return clock_secs(start) * 1000;
+}
+
+long clock_nsecs(clock_t start) {
+    return clock_secs(start) * 1000000;
+}
+
+#endif
+#ifndef DAH_H_
+#define DAH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef DAH_MALLOC
+#include <stdlib.h>
+#define DAH_MALLOC malloc
+#endif // DAH_MALLOC
+
+#ifndef DAH_REALLOC
+#include <stdlib.h>
+#define DAH_REALLOC realloc
+#endif // DAH_REALLOC
+
+#ifndef DAH_FREE
+#include <stdlib.h>
+#define DAH_FREE free
+#endif // DAH_FREE
+
+// Called with false when memory runs out or a size overflows. It must not return,
+// the array can't be used past that point, so dah aborts if it does (as under NDEBUG)
+#ifndef DAH_ASSERT
+#include <assert.h>
+#define DAH_ASSERT assert
+#endif // DAH_ASSERT
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
+typedef struct {
+    size_t count, capacity;
+    // NULL means DAH_MALLOC/DAH_REALLOC/DAH_FREE
+    const Allocator* allocator;
+    // DAH_INLINE while the items live in a DAH_SBO
+    size_t flags;
+    _Alignas(max_align_t) uint8_t data[];
+}DaHeader;
+
+#define DAH_INLINE (1 << 0)
+
+// Storage for N items inside the owning struct, so small arrays never allocate.
+// dah_sbo_init returns the array, which moves to the heap once it outgrows N.
+// The storage has to stay in place while the array points into it.
+#define DAH_SBO(Type, N) struct { DaHeader header; _Alignas(max_align_t) Type items[N]; }
+#define dah_sbo_init(sbo) dah__init_inline(&(sbo)->header, sizeof((sbo)->items) / sizeof((sbo)->items[0]))
+
+#ifndef DAH_INIT_CAPACITY
+#define DAH_INIT_CAPACITY 16
+#endif // DAH_INIT_CAPACITY
+
+// Capacity after CAP when an append doesn't fit. Define it as ((cap) + (cap)/2)
+// for 1.5x growth, which wastes less memory at the cost of more reallocs
+#ifndef DAH_GROW
+#define DAH_GROW(cap) ((cap) * 2)
+#endif // DAH_GROW
+
+// Arrays without an allocator move to their own mapping once they reach this
+// many bytes, and grow with mremap from there. 0 disables it, which is the
+// default when sys/mman.h has no mremap (glibc needs _GNU_SOURCE), since each
+// growth would copy the whole mapping where realloc can remap
+#ifndef DAH_MMAP_THRESHOLD
+#ifdef MREMAP_MAYMOVE
+#define DAH_MMAP_THRESHOLD (1 << 26)
+#else
+#define DAH_MMAP_THRESHOLD 0
+#endif // MREMAP_MAYMOVE
+#endif // DAH_MMAP_THRESHOLD
+
+// Radix sorts fall back to insertion sort below this many items
+#ifndef DAH_RADIX_INSERTION
+#define DAH_RADIX_INSERTION 64
+#endif // DAH_RADIX_INSERTION
+
+// Radix sorts use 8 bit digits below this many items, 11 bit ones below
+// DAH_RADIX_16BIT, and 16 bit ones past it, so bigger arrays take fewer passes
+#ifndef DAH_RADIX_11BIT
+#define DAH_RADIX_11BIT (1 << 12)
+#endif // DAH_RADIX_11BIT
+
+#ifndef DAH_RADIX_16BIT
+#define DAH_RADIX_16BIT (1 << 20)
+#endif // DAH_RADIX_16BIT
+
+typedef enum {
+    DAH_KEY_U32,
+    DAH_KEY_U64,
+    DAH_KEY_I32,
+    DAH_KEY_I64,
+    DAH_KEY_F32,
+    DAH_KEY_F64,
+}DahKeyType;
+
+// Decides whether dah_retain keeps ITEM
+typedef bool (*dah_predicate_t)(const void* item, void* ctx);
+
+#define dah_init(da) ((da) = (void*)dah__default_header(sizeof(*(da)), NULL)->data)
+// Starts an array whose memory comes from ALLOCATOR, which must outlive it
+#define dah_init_with(da, allocator) ((da) = (void*)dah__default_header(sizeof(*(da)), allocator)->data)
+
+#define dah_append(da, v) ((da) = dah__maybe_resize(da, 1, sizeof(*(da))), (da)[dah_getheader(da)->count++] = (v))
+// Grows at most once, to exactly fit when the items wouldn't fit the regular growth
+#define dah_append_many(da, vs, vcount) ((da) = dah__append_many(da, vs, vcount, sizeof(*(da))))
+#define dah_append_cstr(da, cstr) dah_append_many(da, cstr, strlen(cstr))
+#define dah_remove_unordered(da, i) ((da)[i] = (da)[--dah_getheader(da)->count])
+#define dah_remove_ordered(da, i) dah__remove_ordered(da, i, sizeof(*(da)))
+// Inserts N items at I, moving the items from I on once
+#define dah_insert_many(da, i, vs, n) ((da) = dah__insert_many(da, i, vs, n, sizeof(*(da))))
+#define dah_remove_range(da, i, n) dah__remove_range(da, i, n, sizeof(*(da)))
+// Keeps the items PRED returns true for, in order, in a single pass that moves
+// whole runs of kept items at once. Returns the new count
+#define dah_retain(da, pred, ctx) dah__retain(da, pred, ctx, sizeof(*(da)))
+// Same as dah_retain, but keeps item I when bit I % 64 of KEEP[I / 64] is set
+#define dah_retain_mask(da, keep) dah__retain_mask(da, keep, sizeof(*(da)))
+#define dah_reset(da) (dah_getheader(da)->count = 0)
+#define dah_free(da) ((da) = dah__free(da, sizeof(*(da))))
+// Makes room for CAPACITY items in total, so appending up to there never reallocs
+#define dah_reserve(da, capacity) ((da) = dah__reserve(da, capacity, sizeof(*(da))))
+// Gives back the capacity past the current count
+#define dah_shrink_to_fit(da) ((da) = dah__shrink_to_fit(da, sizeof(*(da))))
+
+// Stable LSD radix sorts of arrays of plain keys, in ascending order. Floats
+// sort by their IEEE bits, so -0.0 comes before 0.0 and NaNs go to the ends.
+// The items have to be as wide as the key, which is checked at compile time
+#define dah_radix_sort_u32(da) dah__radix_sort_keys(da, DAH_KEY_U32)
+#define dah_radix_sort_u64(da) dah__radix_sort_keys(da, DAH_KEY_U64)
+#define dah_radix_sort_i32(da) dah__radix_sort_keys(da, DAH_KEY_I32)
+#define dah_radix_sort_i64(da) dah__radix_sort_keys(da, DAH_KEY_I64)
+#define dah_radix_sort_f32(da) dah__radix_sort_keys(da, DAH_KEY_F32)
+#define dah_radix_sort_f64(da) dah__radix_sort_keys(da, DAH_KEY_F64)
+// Sorts an array of structs by FIELD, whose type is given by KEY_TYPE. KEY_TYPE
+// has to be a constant, the field's size is checked against it at compile time
+#define dah_radix_sort_by(da, field, key_type) \
+    (DAH__CHECK_KEY_SIZE(sizeof(((__typeof__(*(da))*)0)->field), key_type), \
+     dah__radix_sort(da, dah_getlen(da), sizeof(*(da)), offsetof(__typeof__(*(da)), field), key_type))
+
+#define DAH__KEY_SIZE(key_type) \
+    ((key_type) == DAH_KEY_U32 || (key_type) == DAH_KEY_I32 || (key_type) == DAH_KEY_F32 ? 4 : 8)
+// A static assert usable in an expression
+#define DAH__CHECK_KEY_SIZE(size, key_type) \
+    ((void)sizeof(struct { _Static_assert((size) == DAH__KEY_SIZE(key_type), "key size doesn't match the radix sort's key type"); int dah__unused; }))
+#define dah__radix_sort_keys(da, key_type) \
+    (DAH__CHECK_KEY_SIZE(sizeof(*(da)), key_type), dah__radix_sort(da, dah_getlen(da), sizeof(*(da)), 0, key_type))
+
+#define dah_for(da, counter) for (size_t counter = 0; counter < dah_getlen(da); ++counter)
+#define dah_foreach(da, Type, ptr) for (Type* ptr = (da); ptr < (da) + dah_getlen(da); ++ptr)
+
+DaHeader* dah_getheader(void* da);
+size_t dah_getlen(void* da);
+
+DaHeader* dah__default_header(size_t item_size, const Allocator* allocator);
+void* dah__init_inline(DaHeader* header, size_t capacity);
+void* dah__maybe_resize(void* da, size_t to_add, size_t item_size);
+void* dah__append_many(void* da, const void* items, size_t count, size_t item_size);
+void* dah__reserve(void* da, size_t capacity, size_t item_size);
+void* dah__shrink_to_fit(void* da, size_t item_size);
+void dah__remove_ordered(void* da, size_t i, size_t item_size);
+void* dah__insert_many(void* da, size_t i, const void* items, size_t count, size_t item_size);
+void dah__remove_range(void* da, size_t i, size_t count, size_t item_size);
+size_t dah__retain(void* da, dah_predicate_t pred, void* ctx, size_t item_size);
+size_t dah__retain_mask(void* da, const uint64_t* keep, size_t item_size);
+void* dah__free(void* da, size_t item_size);
+void dah__radix_sort(void* items, size_t count, size_t item_size, size_t key_offset, DahKeyType key_type);
+
+#endif // DAH_H_
+
+#ifdef DAH_IMPLEMENTATION
+#undef DAH_IMPLEMENTATION
+
+#include <string.h>
+
+#define dah__check(cond) do { if (!(cond)) { DAH_ASSERT(cond); abort(); } } while (0)
+
+DaHeader* dah__default_header(size_t item_size, const Allocator* allocator) {
+    size_t size = sizeof(DaHeader) + item_size * DAH_INIT_CAPACITY;
+    DaHeader* header = allocator != NULL ? allocator_alloc(allocator, size) : DAH_MALLOC(size);
+    dah__check(header != NULL);
+    header->count = 0;
+    header->capacity = DAH_INIT_CAPACITY;
+    header->allocator = allocator;
+    header->flags = 0;
+    return header;
+}
+
+void* dah__init_inline(DaHeader* header, size_t capacity) {
+    header->count = 0;
+    header->capacity = capacity;
+    header->allocator = NULL;
+    header->flags = DAH_INLINE;
+    return header->data;
+}
+
+// Reallocates HEADER to CAPACITY items. Nothing is written until the new memory is there
+static DaHeader* dah__set_capacity(DaHeader* header, size_t capacity, size_t item_size) {
+    dah__check(capacity <= (SIZE_MAX - sizeof(DaHeader)) / item_size);
+
+    size_t old_size = sizeof(DaHeader) + header->capacity * item_size;
+    size_t new_size = sizeof(DaHeader) + capacity * item_size;
+
+    DaHeader* resized;
+    if (header->flags & DAH_INLINE) {
+        // Inline storage never shrinks, and spills to the heap when it's outgrown
+        if (capacity <= header->capacity) return header;
+
+        resized = DAH_MALLOC(new_size);
+        if (resized != NULL) {
+            memcpy(resized, header, sizeof(DaHeader) + header->count * item_size);
+            resized->flags &= ~DAH_INLINE;
+        }
+    } else if (header->allocator != NULL) {
+        resized = allocator_realloc(header->allocator, header, old_size, new_size);
+#if DAH_MMAP_THRESHOLD > 0
+    } else if (new_size >= DAH_MMAP_THRESHOLD) {
+        resized = allocator_alloc(&mmap_allocator, new_size);
+        if (resized != NULL) {
+            memcpy(resized, header, sizeof(DaHeader) + header->count * item_size);
+            DAH_FREE(header);
+            resized->allocator = &mmap_allocator;
+        }
+#endif // DAH_MMAP_THRESHOLD
+    } else {
+        resized = DAH_REALLOC(header, new_size);
+    }
+    dah__check(resized != NULL);
+
+    resized->capacity = capacity;
+    return resized;
+}
+
+void* dah__maybe_resize(void* da, size_t to_add, size_t item_size) {
+    if (da == NULL) {
+        da = dah__default_header(item_size, NULL)->data;
+    }
+
+    DaHeader* header = (DaHeader*)da - 1;
+
+    size_t needed = header->count + to_add;
+    dah__check(needed >= to_add);
+    if (needed > header->capacity) {
+        size_t capacity = header->capacity == 0 ? DAH_INIT_CAPACITY : DAH_GROW(header->capacity);
+        if (capacity < needed) capacity = needed;
+        header = dah__set_capacity(header, capacity, item_size);
+    }
+
+    return header->data;
+}
+
+// Byte offset of ITEMS in the items of DA, or SIZE_MAX when they live somewhere else.
+// Items taken from the array itself have to be found again after it grows
+static size_t dah__offset_of(void* da, const void* items, size_t item_size) {
+    if (da == NULL || items == NULL) return SIZE_MAX;
+
+    uintptr_t p = (uintptr_t)items;
+    uintptr_t start = (uintptr_t)da;
+    if (p < start || p >= start + dah_getheader(da)->count * item_size) return SIZE_MAX;
+    return p - start;
+}
+
+void* dah__append_many(void* da, const void* items, size_t count, size_t item_size) {
+    size_t offset = dah__offset_of(da, items, item_size);
+    da = dah__maybe_resize(da, count, item_size);
+
+    DaHeader* header = dah_getheader(da);
+    if (offset != SIZE_MAX) items = header->data + offset;
+    if (count > 0) memcpy(header->data + header->count * item_size, items, count * item_size);
+    header->count += count;
+    return da;
+}
+
+void* dah__reserve(void* da, size_t capacity, size_t item_size) {
+    if (da == NULL) {
+        da = dah__default_header(item_size, NULL)->data;
+    }
+
+    DaHeader* header = dah_getheader(da);
+    if (capacity > header->capacity) {
+        header = dah__set_capacity(header, capacity, item_size);
+    }
+    return header->data;
+}
+
+void* dah__shrink_to_fit(void* da, size_t item_size) {
+    if (da == NULL) return NULL;
+
+    DaHeader* header = dah_getheader(da);
+    if (header->count < header->capacity) {
+        header = dah__set_capacity(header, header->count, item_size);
+    }
+    return header->data;
+}
+
+size_t dah_getlen(void* da) {
+    if (da == NULL) return 0;
+    return dah_getheader(da)->count;
+}
+
+DaHeader* dah_getheader(void* da) {
+    return (DaHeader*)da - 1;
+}
+
+void dah__remove_ordered(void* da, size_t i, size_t item_size) {
+    DaHeader* header = dah_getheader(da);
+
+    memmove(header->data + i * item_size, header->data + (i + 1) * item_size, (header->count - i - 1) * item_size);
+    header->count--;
+}
+
+void* dah__insert_many(void* da, size_t i, const void* items, size_t count, size_t item_size) {
+    DAH_ASSERT(i <= dah_getlen(da));
+    size_t offset = dah__offset_of(da, items, item_size);
+    da = dah__maybe_resize(da, count, item_size);
+
+    DaHeader* header = dah_getheader(da);
+    size_t at = i * item_size;
+    size_t size = count * item_size;
+    memmove(header->data + at + size, header->data + at, (header->count - i) * item_size);
+    if (offset == SIZE_MAX) {
+        if (count > 0) memcpy(header->data + at, items, size);
+    } else {
+        // Items from before I stayed put, the ones from I on moved up with the tail
+        size_t before = offset < at ? at - offset : 0;
+        if (before > size) before = size;
+        memcpy(header->data + at, header->data + offset, before);
+        memcpy(header->data + at + before, header->data + offset + before + size, size - before);
+    }
+    header->count += count;
+    return da;
+}
+
+void dah__remove_range(void* da, size_t i, size_t count, size_t item_size) {
+    if (count == 0) return;
+
+    DaHeader* header = dah_getheader(da);
+    DAH_ASSERT(i + count <= header->count);
+    memmove(header->data + i * item_size, header->data + (i + count) * item_size, (header->count - i - count) * item_size);
+    header->count -= count;
+}
+
+size_t dah__retain(void* da, dah_predicate_t pred, void* ctx, size_t item_size) {
+    if (da == NULL) return 0;
+
+    DaHeader* header = dah_getheader(da);
+    uint8_t* data = header->data;
+    size_t count = header->count;
+
+    // Kept items only ever move down, so the ones PRED hasn't seen stay where they are.
+    // PRED sees every item exactly once, and each run of kept items moves with one memmove
+    size_t kept = 0;
+    size_t start = 0;
+    bool in_run = false;
+    for (size_t i = 0; i <= count; ++i) {
+        bool keep = i < count && pred(data + i * item_size, ctx);
+        if (keep && !in_run) {
+            start = i;
+        } else if (!keep && in_run) {
+            if (start != kept) memmove(data + kept * item_size, data + start * item_size, (i - start) * item_size);
+            kept += i - start;
+        }
+        in_run = keep;
+    }
+
+    header->count = kept;
+    return kept;
+}
+
+// First I from FROM on whose bit in MASK is SET, or COUNT
+static size_t dah__find_bit(const uint64_t* mask, size_t from, size_t count, bool set) {
+    size_t i = from;
+    while (i < count) {
+        uint64_t word = set ? mask[i / 64] : ~mask[i / 64];
+        word &= ~(uint64_t)0 << (i % 64);
+        if (word != 0) {
+            i = i / 64 * 64 + __builtin_ctzll(word);
+            return i < count ? i : count;
+        }
+        i = (i / 64 + 1) * 64;
+    }
+    return count;
+}
+
+size_t dah__retain_mask(void* da, const uint64_t* keep, size_t item_size) {
+    if (da == NULL) return 0;
+
+    DaHeader* header = dah_getheader(da);
+    uint8_t* data = header->data;
+    size_t count = header->count;
+
+    size_t kept = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t start = dah__find_bit(keep, i, count, true);
+        i = dah__find_bit(keep, start, count, false);
+
+        if (start != kept) memmove(data + kept * item_size, data + start * item_size, (i - start) * item_size);
+        kept += i - start;
+    }
+
+    header->count = kept;
+    return kept;
+}
+
+void* dah__free(void* da, size_t item_size) {
+    if (da == NULL) return NULL;
+
+    DaHeader* header = dah_getheader(da);
+    if (header->flags & DAH_INLINE) {
+        return NULL;
+    } else if (header->allocator != NULL) {
+        allocator_free(header->allocator, header, sizeof(DaHeader) + header->capacity * item_size);
+    } else {
+        DAH_FREE(header);
+    }
+    return NULL;
+}
+
+// Loads the key of ITEM as an unsigned number that sorts in the same order
+static inline uint64_t dah__radix_key(const uint8_t* item, DahKeyType key_type) {
+    uint32_t k32;
+    uint64_t k64;
+    switch (key_type) {
+    case DAH_KEY_U32: memcpy(&k32, item, 4); return k32;
+    case DAH_KEY_U64: memcpy(&k64, item, 8); return k64;
+    case DAH_KEY_I32: memcpy(&k32, item, 4); return k32 ^ 0x80000000u;
+    case DAH_KEY_I64: memcpy(&k64, item, 8); return k64 ^ 0x8000000000000000ull;
+    case DAH_KEY_F32:
+        memcpy(&k32, item, 4);
+        return k32 & 0x80000000u ? ~k32 : k32 | 0x80000000u;
+    case DAH_KEY_F64:
+        memcpy(&k64, item, 8);
+        return k64 & 0x8000000000000000ull ? ~k64 : k64 | 0x8000000000000000ull;
+    }
+    return 0;
+}
+
+static inline void dah__radix_copy(uint8_t* dst, const uint8_t* src, size_t item_size) {
+    // Plain keys are the common case, and fixed size copies compile to a single move
+    switch (item_size) {
+    case 4: memcpy(dst, src, 4); break;
+    case 8: memcpy(dst, src, 8); break;
+    case 16: memcpy(dst, src, 16); break;
+    default: memcpy(dst, src, item_size); break;
+    }
+}
+
+static void dah__insertion_sort(uint8_t* items, size_t count, size_t item_size, size_t key_offset, DahKeyType key_type) {
+    uint8_t tmp[item_size];
+    for (size_t i = 1; i < count; ++i) {
+        uint64_t key = dah__radix_key(items + i * item_size + key_offset, key_type);
+        size_t j = i;
+        while (j > 0 && dah__radix_key(items + (j - 1) * item_size + key_offset, key_type) > key) --j;
+        if (j == i) continue;
+
+        memcpy(tmp, items + i * item_size, item_size);
+        memmove(items + (j + 1) * item_size, items + j * item_size, (i - j) * item_size);
+        memcpy(items + j * item_size, tmp, item_size);
+    }
+}
+
+void dah__radix_sort(void* da, size_t count, size_t item_size, size_t key_offset, DahKeyType key_type) {
+    uint8_t* items = da;
+    if (count < 2) return;
+    if (count < DAH_RADIX_INSERTION) {
+        dah__insertion_sort(items, count, item_size, key_offset, key_type);
+        return;
+    }
+
+    size_t key_bits = DAH__KEY_SIZE(key_type) * 8;
+    size_t digit_bits = count < DAH_RADIX_11BIT ? 8 : count < DAH_RADIX_16BIT ? 11 : 16;
+    size_t passes = (key_bits + digit_bits - 1) / digit_bits;
+    size_t buckets = (size_t)1 << digit_bits;
+
+    // Every histogram is counted in a single read of the keys
+    size_t* counts = DAH_MALLOC(passes * buckets * sizeof(size_t));
+    uint8_t* tmp = DAH_MALLOC(count * item_size);
+    dah__check(counts != NULL && tmp != NULL);
+    memset(counts, 0, passes * buckets * sizeof(size_t));
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = dah__radix_key(items + i * item_size + key_offset, key_type);
+        for (size_t p = 0; p < passes; ++p) {
+            counts[p * buckets + ((key >> (p * digit_bits)) & (buckets - 1))]++;
+        }
+    }
+
+    uint8_t* src = items;
+    uint8_t* dst = tmp;
+    for (size_t p = 0; p < passes; ++p) {
+        size_t* hist = counts + p * buckets;
+        size_t shift = p * digit_bits;
+
+        // Every key has the same digit, so the pass wouldn't move anything
+        size_t first = (dah__radix_key(src + key_offset, key_type) >> shift) & (buckets - 1);
+        if (hist[first] == count) continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            size_t n = hist[b];
+            hist[b] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* item = src + i * item_size;
+            size_t digit = (dah__radix_key(item + key_offset, key_type) >> shift) & (buckets - 1);
+            dah__radix_copy(dst + hist[digit]++ * item_size, item, item_size);
+        }
+
+        uint8_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != items) memcpy(items, src, count * item_size);
+    DAH_FREE(counts);
+    DAH_FREE(tmp);
+}
+
+#endif
+#ifndef DEQUE_H_
+#define DEQUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef DEQ_MALLOC
+#include <stdlib.h>
+#define DEQ_MALLOC malloc
+#endif // DEQ_MALLOC
+
+#ifndef DEQ_FREE
+#include <stdlib.h>
+#define DEQ_FREE free
+#endif // DEQ_FREE
+
+#ifndef DEQ_ASSERT
+#include <assert.h>
+#define DEQ_ASSERT assert
+#endif // DEQ_ASSERT
+
+// Has to be a power of two
+#ifndef DEQ_INIT_CAPACITY
+#define DEQ_INIT_CAPACITY 16
+#endif // DEQ_INIT_CAPACITY
+
+// A ring buffer behind a pointer to its items, like dah. The items wrap around
+// the end of the buffer, so use deq_at instead of indexing the pointer directly.
+// A NULL pointer is an empty deque.
+typedef struct {
+    size_t head, count;
+    // Always a power of two, so wrapping is a mask
+    size_t capacity;
+    _Alignas(max_align_t) uint8_t data[];
+}DeqHeader;
+
+#define deq_getheader(dq) ((DeqHeader*)(dq) - 1)
+#define deq_len(dq) ((dq) == NULL ? 0 : deq_getheader(dq)->count)
+#define deq_empty(dq) (deq_len(dq) == 0)
+#define deq__mask(dq) (deq_getheader(dq)->capacity - 1)
+
+// Item I counted from the front
+#define deq_at(dq, i) ((dq)[(deq_getheader(dq)->head + (i)) & deq__mask(dq)])
+#define deq_front(dq) deq_at(dq, 0)
+#define deq_back(dq) deq_at(dq, deq_getheader(dq)->count - 1)
+
+#define deq_push_back(dq, v) ((dq) = deq__grow(dq, 1, sizeof(*(dq))), (dq)[deq__push_back_slot(deq_getheader(dq))] = (v))
+#define deq_push_front(dq, v) ((dq) = deq__grow(dq, 1, sizeof(*(dq))), (dq)[deq__push_front_slot(deq_getheader(dq))] = (v))
+// Take the value out of the deque, which mustn't be empty
+#define deq_pop_front(dq) ((dq)[deq__pop_front_slot(deq_getheader(dq))])
+#define deq_pop_back(dq) ((dq)[deq__pop_back_slot(deq_getheader(dq))])
+
+// Copy N items in or out with at most two memcpys each.
+// The pops return how many items there were to take, up to N.
+#define deq_push_back_many(dq, items, n) ((dq) = deq__push_back_many(dq, items, n, sizeof(*(dq))))
+#define deq_pop_front_many(dq, out, n) deq__pop_front_many(dq, out, n, sizeof(*(dq)))
+
+// Makes room for CAPACITY items in total
+#define deq_reserve(dq, capacity) ((dq) = deq__reserve(dq, capacity, sizeof(*(dq))))
+#define deq_clear(dq) ((dq) == NULL ? (void)0 : (void)(deq_getheader(dq)->head = deq_getheader(dq)->count = 0))
+#define deq_free(dq) ((dq) = deq__free(dq))
+
+void* deq__grow(void* dq, size_t to_add, size_t item_size);
+void* deq__reserve(void* dq, size_t capacity, size_t item_size);
+size_t deq__push_back_slot(DeqHeader* header);
+size_t deq__push_front_slot(DeqHeader* header);
+size_t deq__pop_front_slot(DeqHeader* header);
+size_t deq__pop_back_slot(DeqHeader* header);
+void* deq__push_back_many(void* dq, const void* items, size_t n, size_t item_size);
+size_t deq__pop_front_many(void* dq, void* out, size_t n, size_t item_size);
+void* deq__free(void* dq);
+
+#endif // DEQUE_H_
+
+#ifdef DEQ_IMPLEMENTATION
+#undef DEQ_IMPLEMENTATION
+
+#include <string.h>
+
+// Moves the items to a buffer of CAPACITY, starting at its beginning
+static DeqHeader* deq__unwrap(DeqHeader* header, size_t capacity, size_t item_size) {
+    DeqHeader* fresh = DEQ_MALLOC(sizeof(DeqHeader) + capacity * item_size);
+    DEQ_ASSERT(fresh != NULL);
+    fresh->head = 0;
+    fresh->count = 0;
+    fresh->capacity = capacity;
+    if (header == NULL) return fresh;
+
+    size_t first = header->capacity - header->head;
+    if (first > header->count) first = header->count;
+    memcpy(fresh->data, header->data + header->head * item_size, first * item_size);
+    memcpy(fresh->data + first * item_size, header->data, (header->count - first) * item_size);
+    fresh->count = header->count;
+
+    DEQ_FREE(header);
+    return fresh;
+}
+
+void* deq__reserve(void* dq, size_t capacity, size_t item_size) {
+    DeqHeader* header = dq != NULL ? deq_getheader(dq) : NULL;
+    size_t current = header != NULL ? header->capacity : 0;
+    if (header != NULL && capacity <= current) return dq;
+
+    size_t fresh = DEQ_INIT_CAPACITY;
+    while (fresh < capacity) fresh *= 2;
+    return deq__unwrap(header, fresh, item_size)->data;
+}
+
+void* deq__grow(void* dq, size_t to_add, size_t item_size) {
+    if (dq != NULL && deq_getheader(dq)->count + to_add <= deq_getheader(dq)->capacity) return dq;
+    return deq__reserve(dq, deq_len(dq) + to_add, item_size);
+}
+
+size_t deq__push_back_slot(DeqHeader* header) {
+    return (header->head + header->count++) & (header->capacity - 1);
+}
+
+size_t deq__push_front_slot(DeqHeader* header) {
+    header->head = (header->head - 1) & (header->capacity - 1);
+    header->count++;
+    return header->head;
+}
+
+size_t deq__pop_front_slot(DeqHeader* header) {
+    DEQ_ASSERT(header->count > 0);
+    size_t slot = header->head;
+    header->head = (header->head + 1) & (header->capacity - 1);
+    header->count--;
+    return slot;
+}
+
+size_t deq__pop_back_slot(DeqHeader* header) {
+    DEQ_ASSERT(header->count > 0);
+    return (header->head + --header->count) & (header->capacity - 1);
+}
+
+void* deq__push_back_many(void* dq, const void* items, size_t n, size_t item_size) {
+    dq = deq__grow(dq, n, item_size);
+    DeqHeader* header = deq_getheader(dq);
+
+    size_t tail = (header->head + header->count) & (header->capacity - 1);
+    size_t first = header->capacity - tail;
+    if (first > n) first = n;
+    memcpy(header->data + tail * item_size, items, first * item_size);
+    memcpy(header->data, (const uint8_t*)items + first * item_size, (n - first) * item_size);
+
+    header->count += n;
+    return dq;
+}
+
+size_t deq__pop_front_many(void* dq, void* out, size_t n, size_t item_size) {
+    if (dq == NULL) return 0;
+
+    DeqHeader* header = deq_getheader(dq);
+    if (n > header->count) n = header->count;
+
+    size_t first = header->capacity - header->head;
+    if (first > n) first = n;
+    memcpy(out, header->data + header->head * item_size, first * item_size);
+    memcpy((uint8_t*)out + first * item_size, header->data, (n - first) * item_size);
+
+    header->head = (header->head + n) & (header->capacity - 1);
+    header->count -= n;
+    return n;
+}
+
+void* deq__free(void* dq) {
+    if (dq != NULL) DEQ_FREE(deq_getheader(dq));
+    return NULL;
+}
+
+#endif // DEQ_IMPLEMENTATION
+#ifndef HEAP_H_
+#define HEAP_H_
+#include <stddef.h>
+#include <assert.h>
+
+#ifndef DAH_H_
+#include "dah.h"
+#endif // DAH_H_
+
+// Priority queues over dah arrays, generated for an item type and a comparator:
+//
+//     #define timer_less(a, b) ((a).deadline < (b).deadline)
+//     HEAP_DECLARE(timers, Timer)                                  // in a header
+//     HEAP_IMPLEMENT(timers, Timer, timer_less, HEAP_NO_INDEX)     // in one .c file
+//
+// LESS(a, b) takes two items and puts the smallest on top. It's a macro or an
+// inline function, so comparisons get inlined. The heap is 4-ary, which halves
+// its depth and keeps the children of a node next to each other in memory.
+//
+// For decrease-key, SET_INDEX(item, i) is called every time an item lands on
+// index I. Store I in the item (or next to it) as its handle, change its key
+// and call prefix_update with it. Pass HEAP_NO_INDEX when nothing needs it.
+
+#define HEAP_ARITY 4
+#define HEAP_NO_INDEX(item, i) ((void)0)
+
+#define heap_len(heap) dah_getlen(heap)
+#define heap_peek(heap) (dah_getlen(heap) == 0 ? NULL : &(heap)[0])
+
+#define HEAP_DECLARE(prefix, Type) \
+void prefix##_push(Type** heap, Type item); \
+/* The heap mustn't be empty */ \
+Type prefix##_pop(Type* heap); \
+/* Pops up to K items into OUT, smallest first, returns how many it popped */ \
+size_t prefix##_pop_many(Type* heap, Type* out, size_t k); \
+/* Orders an array of items into a heap in O(n) */ \
+void prefix##_heapify(Type* heap); \
+/* Restores the order after the key of item I changed, either way */ \
+void prefix##_update(Type* heap, size_t i); \
+Type prefix##_remove(Type* heap, size_t i);
+
+#define HEAP_IMPLEMENT(prefix, Type, less, set_index) \
+/* Moves the hole at I up until ITEM fits in it */ \
+static void prefix##__sift_up(Type* heap, size_t i, Type item) { \
+    while (i > 0) { \
+        size_t parent = (i - 1) / HEAP_ARITY; \
+        if (!less(item, heap[parent])) break; \
+        heap[i] = heap[parent]; \
+        set_index(heap[i], i); \
+        i = parent; \
+    } \
+    heap[i] = item; \
+    set_index(heap[i], i); \
+} \
+\
+static void prefix##__sift_down(Type* heap, size_t count, size_t i, Type item) { \
+    while (true) { \
+        size_t first = i * HEAP_ARITY + 1; \
+        if (first >= count) break; \
+\
+        size_t last = first + HEAP_ARITY < count ? first + HEAP_ARITY : count; \
+        size_t best = first; \
+        for (size_t c = first + 1; c < last; ++c) { \
+            if (less(heap[c], heap[best])) best = c; \
+        } \
+\
+        if (!less(heap[best], item)) break; \
+        heap[i] = heap[best]; \
+        set_index(heap[i], i); \
+        i = best; \
+    } \
+    heap[i] = item; \
+    set_index(heap[i], i); \
+} \
+\
+void prefix##_push(Type** heap, Type item) { \
+    dah_append(*heap, item); \
+    prefix##__sift_up(*heap, dah_getlen(*heap) - 1, item); \
+} \
+\
+Type prefix##_pop(Type* heap) { \
+    DaHeader* header = dah_getheader(heap); \
+    assert(header->count > 0); \
+\
+    Type top = heap[0]; \
+    Type last = heap[--header->count]; \
+    if (header->count > 0) prefix##__sift_down(heap, header->count, 0, last); \
+    return top; \
+} \
+\
+size_t prefix##_pop_many(Type* heap, Type* out, size_t k) { \
+    size_t count = dah_getlen(heap); \
+    if (k > count) k = count; \
+    for (size_t i = 0; i < k; ++i) out[i] = prefix##_pop(heap); \
+    return k; \
+} \
+\
+void prefix##_heapify(Type* heap) { \
+    size_t count = dah_getlen(heap); \
+    if (count < 2) { \
+        if (count == 1) set_index(heap[0], 0); \
+        return; \
+    } \
+\
+    for (size_t i = (count - 2) / HEAP_ARITY + 1; i < count; ++i) set_index(heap[i], i); \
+    for (size_t i = (count - 2) / HEAP_ARITY + 1; i-- > 0;) { \
+        prefix##__sift_down(heap, count, i, heap[i]); \
+    } \
+} \
+\
+void prefix##_update(Type* heap, size_t i) { \
+    size_t count = dah_getlen(heap); \
+    assert(i < count); \
+\
+    Type item = heap[i]; \
+    if (i > 0 && less(item, heap[(i - 1) / HEAP_ARITY])) { \
+        prefix##__sift_up(heap, i, item); \
+    } else { \
+        prefix##__sift_down(heap, count, i, item); \
+    } \
+} \
+\
+Type prefix##_remove(Type* heap, size_t i) { \
+    DaHeader* header = dah_getheader(heap); \
+    assert(i < header->count); \
+\
+    Type removed = heap[i]; \
+    Type last = heap[--header->count]; \
+    if (i < header->count) { \
+        heap[i] = last; \
+        prefix##_update(heap, i); \
+    } \
+    return removed; \
+}
+
+#endif // HEAP_H_
+#ifndef SOA_H_
+#define SOA_H_
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Struct-of-arrays containers generated from a field list, so loops over one
+// field only touch that field's memory. A field list takes the expander as its
+// argument, in the form X(Type, name):
+//
+//     #define PARTICLE_FIELDS(X) X(float, x) X(float, y) X(int, id)
+//     SOA_DECLARE(Particles, particles, PARTICLE_FIELDS)   // in a header
+//     SOA_IMPLEMENT(Particles, particles, PARTICLE_FIELDS) // in one .c file
+//
+// Particles then has a pointer per column (self.x, self.y, self.id) and
+// ParticlesRow holds one record for particles_append/particles_get.
+
+// Every column starts at this alignment, in bytes
+#ifndef SOA_ALIGN
+#define SOA_ALIGN 64
+#endif // SOA_ALIGN
+
+#ifndef SOA_INIT_CAPACITY
+#define SOA_INIT_CAPACITY 16
+#endif // SOA_INIT_CAPACITY
+
+// Has to take sizes that are a multiple of SOA_ALIGN, like aligned_alloc
+#ifndef SOA_ALIGNED_ALLOC
+#define SOA_ALIGNED_ALLOC aligned_alloc
+#endif // SOA_ALIGNED_ALLOC
+
+#ifndef SOA_FREE
+#define SOA_FREE free
+#endif // SOA_FREE
+
+static inline size_t soa__align_up(size_t size) {
+    return (size + SOA_ALIGN - 1) & ~(size_t)(SOA_ALIGN - 1);
+}
+
+#define SOA__COLUMN(Type, name) Type* name;
+#define SOA__ROW_FIELD(Type, name) Type name;
+#define SOA__COLUMN_SIZE(Type, name) size = soa__align_up(size) + capacity * sizeof(Type);
+#define SOA__MOVE_COLUMN(Type, name) \
+    size = soa__align_up(size); \
+    if (self->count > 0) memcpy(block + size, self->name, self->count * sizeof(Type)); \
+    self->name = (Type*)(block + size); \
+    size += capacity * sizeof(Type);
+#define SOA__STORE(Type, name) self->name[i] = row.name;
+#define SOA__LOAD(Type, name) row.name = self->name[i];
+#define SOA__SWAP_LAST(Type, name) self->name[i] = self->name[self->count - 1];
+
+// Declares Name, NameRow and the prefix_ functions
+#define SOA_DECLARE(Name, prefix, FIELDS) \
+typedef struct { \
+    size_t count, capacity; \
+    /* Every column lives in this one allocation */ \
+    char* block; \
+    FIELDS(SOA__COLUMN) \
+}Name; \
+\
+typedef struct { \
+    FIELDS(SOA__ROW_FIELD) \
+}Name##Row; \
+\
+/* Makes room for CAPACITY records in total */ \
+void prefix##_reserve(Name* self, size_t capacity); \
+/* Returns the index of the new record */ \
+size_t prefix##_append(Name* self, Name##Row row); \
+Name##Row prefix##_get(Name* self, size_t i); \
+void prefix##_set(Name* self, size_t i, Name##Row row); \
+/* Moves the last record into I, so records don't keep their order */ \
+void prefix##_swap_remove(Name* self, size_t i); \
+void prefix##_free(Name* self);
+
+#define SOA_IMPLEMENT(Name, prefix, FIELDS) \
+void prefix##_reserve(Name* self, size_t capacity) { \
+    if (capacity <= self->capacity) return; \
+\
+    size_t size = 0; \
+    FIELDS(SOA__COLUMN_SIZE) \
+    char* block = (char*)SOA_ALIGNED_ALLOC(SOA_ALIGN, soa__align_up(size)); \
+    assert(block != NULL); \
+\
+    size = 0; \
+    FIELDS(SOA__MOVE_COLUMN) \
+    SOA_FREE(self->block); \
+    self->block = block; \
+    self->capacity = capacity; \
+} \
+\
+size_t prefix##_append(Name* self, Name##Row row) { \
+    if (self->count == self->capacity) { \
+        prefix##_reserve(self, self->capacity == 0 ? SOA_INIT_CAPACITY : self->capacity * 2); \
+    } \
+\
+    size_t i = self->count++; \
+    FIELDS(SOA__STORE) \
+    return i; \
+} \
+\
+Name##Row prefix##_get(Name* self, size_t i) { \
+    assert(i < self->count); \
+    Name##Row row; \
+    FIELDS(SOA__LOAD) \
+    return row; \
+} \
+\
+void prefix##_set(Name* self, size_t i, Name##Row row) { \
+    assert(i < self->count); \
+    FIELDS(SOA__STORE) \
+} \
+\
+void prefix##_swap_remove(Name* self, size_t i) { \
+    assert(i < self->count); \
+    FIELDS(SOA__SWAP_LAST) \
+    self->count--; \
+} \
+\
+void prefix##_free(Name* self) { \
+    SOA_FREE(self->block); \
+    memset(self, 0, sizeof(*self)); \
+}
+
+#endif // SOA_H_
+#ifndef EASINGS_H_
+#define EASINGS_H_
+#include <math.h>
+
+#ifndef PI
+#define PI 3.14159 
+#endif // PI
+
+#ifndef EASINGS_POWF
+#include <math.h>
+#define EASINGS_POWF powf
+#endif
+
+#ifndef EASINGS_SQRTF
+#include <math.h>
+#define EASINGS_SQRTF sqrtf
+#endif
+
+#ifndef EASINGS_EXP2F
+#include <math.h>
+#define EASINGS_EXP2F exp2f
+#endif
+
+float ease_in_sine(float t);
+float ease_out_sine(float t);
+float ease_in_out_sine(float t);
+
+float ease_in_quad(float t);
+float ease_out_quad(float t);
+float ease_in_out_quad(float t);
+
+float ease_in_cubic(float t);
+float ease_out_cubic(float t);
+float ease_in_out_cubic(float t);
+
+float ease_in_quart(float t);
+float ease_out_quart(float t);
+float ease_in_out_quart(float t);
+
+float ease_in_quint(float t);
+float ease_out_quint(float t);
+float ease_in_out_quint(float t);
+
+float ease_in_expo(float t);
+float ease_out_expo(float t);
+float ease_in_out_expo(float t);
+
+float ease_in_circ(float t);
+float ease_out_circ(float t);
+float ease_in_out_circ(float t);
+
+float ease_in_back(float t);
+float ease_out_back(float t);
+float ease_in_out_back(float t);
+
+float ease_in_elastic(float t);
+float ease_out_elastic(float t);
+float ease_in_out_elastic(float t);
+
+float ease_in_bounce(float t);
+float ease_out_bounce(float t);
+float ease_in_out_bounce(float t);
+
+#endif // EASINGS_H_
+
+#ifdef EASINGS_IMPLEMENTATION
+#undef EASINGS_IMPLEMENTATION
+
+float ease_in_sine(float t) {
+    return 1 - cos((t * PI) / 2);
+}
+
+float ease_out_sine(float t) {
+    return sin((t * PI) / 2);
+}
+
+float ease_in_out_sine(float t) {
+    return -(cos(PI * t) - 1) / 2;
+}
+
+float ease_in_quad(float t) {
+    return t * t;
+}
+
+float ease_out_quad(float t) {
+    return 1 - (1 - t) * (1 - t);
+}
+
+float ease_in_out_quad(float t) {
+    return t < 0.5 ? 2 * t * t : 1 - EASINGS_POWF(-2 * t + 2, 2) / 2;
+}
+
+float ease_in_cubic(float t) {
+    return t * t * t;
+}
+
+float ease_out_cubic(float t) {
+    return 1 - EASINGS_POWF(1 - t, 3);
+}
+
+float ease_in_out_cubic(float t) {
+    return t < 0.5 ? 4 * t * t * t : 1 - EASINGS_POWF(-2 * t + 2, 3) / 2;
+}
+
+float ease_in_quart(float t) {
+    return t * t * t * t;
+}
+
+float ease_out_quart(float t) {
+    return 1 - EASINGS_POWF(1 - t, 4);
+}
+
+float ease_in_out_quart(float t) {
+    return t < 0.5 ? 8 * t * t * t * t : 1 - EASINGS_POWF(-2 * t + 2, 4) / 2;
+}
+
+float ease_in_quint(float t) {
+    return t * t * t * t * t;
+}
+
+float ease_out_quint(float t) {
+    return 1 - EASINGS_POWF(1 - t, 5);
+}
+
+float ease_in_out_quint(float t) {
+    return t < 0.5 ? 16 * t * t * t * t * t : 1 - EASINGS_POWF(-2 * t + 2, 5) / 2;
+}
+
+float ease_in_expo(float t) {
+    return t == 0.0f ? 0.0f : EASINGS_EXP2F(10 * t - 10);
+}
+
+float ease_out_expo(float t) {
+    return t == 1.0f ? 1.0f : 1 - EASINGS_EXP2F(-10 * t);
+}
+
+float ease_in_out_expo(float t) {
+    if (t == 0) return 0;
+    else if (t == 1) return 1;
+    else if (t < 0.5) return EASINGS_EXP2F(20 * t - 10) / 2;
+    else return (2 - EASINGS_EXP2F(-20 * t + 10)) / 2;
+}
+
+float ease_in_circ(float t) {
+    return 1 - EASINGS_SQRTF(1 - t * t);
+}
+
+float ease_out_circ(float t) {
+    return EASINGS_SQRTF(1 - EASINGS_POWF(t - 1, 2));
+}
+
+float ease_in_out_circ(float t) {
+    if (t < 0.5) return (1 - EASINGS_SQRTF(1 - EASINGS_POWF(2 * t, 2))) / 2;
+    else return (EASINGS_SQRTF(1 - EASINGS_POWF(-2 * t + 2, 2)) + 1) / 2;
+}
+
+float ease_in_back(float t) {
+    float c1 = 1.70158f;
+    float c3 = c1 + 1;
+    return c3 * t * t * t - c1 * t * t;
+}
+
+float ease_out_back(float t) {
+    float c1 = 1.70158f;
+    float c3 = c1 + 1;
+    return 1 + c3 * EASINGS_POWF(t - 1, 3) + c1 * EASINGS_POWF(t - 1, 2);
+}
+
+float ease_in_out_back(float t) {
+    float c1 = 1.70158f;
+    float c3 = c1 + 1;
+
+    if (t < 0.5) return (EASINGS_POWF(2 * t, 2) * ((c3 + 1) * 2 * t - c3)) / 2;
+    else return (EASINGS_POWF(2 * t - 2, 2) * ((c3 + 1) * (t * 2 - 2) + c3) + 2) / 2;
+}
+
+float ease_in_elastic(float t) {
+    float c1 = (2 * PI) / 3;
+
+    return t == 0
+        ? 0
+        : t == 1
+        ? 1
+        : -EASINGS_POWF(2, 10 * t - 10) * sinf((t * 10 - 10.75) * c1);
+}
+
+float ease_out_elastic(float t) {
+    float c1 = (2 * PI) / 3;
+
+    return t == 0
+        ? 0
+        : t == 1
+        ? 1
+        : EASINGS_POWF(2, -10 * t) * sinf((t * 10 - 0.75) * c1) + 1;
+}
+
+float ease_in_out_elastic(float t) {
+    float c1 = (2 * PI) / 4.5;
+
+    return t == 0
+        ? 0
+        : t == 1
+        ? 1
+        : t < 0.5
+        ? -(EASINGS_POWF(2, 20 * t - 10) * sinf((20 * t - 11.125) * c1)) / 2
+        : (EASINGS_POWF(2, -20 * t + 10) * sinf((20 * t - 11.125) * c1)) / 2 + 1;
+}
+
+float ease_in_bounce(float t) {
+    return 1 - ease_out_bounce(1 - t);
+}
+
+float ease_out_bounce(float t) {
+    float n1 = 7.5625;
+    float d1 = 2.75;
+
+    if (t < 1 / d1) {
+        return n1 * t * t;
+    } else if (t < 2 / d1) {
+        t -= 1.5 / d1;
+        return n1 * t * t + 0.75;
+    } else if (t < 2.5 / d1) {
+        t -= 2.25 / d1;
+        return n1 * t * t + 0.9375;
+    } else {
+        t -= 2.625 / d1;
+        return n1 * t * t + 0.984375;
+    }
+}
+
+
+float ease_in_out_bounce(float t) {
+    return t < 0.5
+        ? (1 - ease_out_bounce(1 - 2 * t)) / 2
+        : (1 + ease_out_bounce(2 * t - 1)) / 2;
+}
+
+#endif // EASINGS_IMPLEMENTATION
+#ifndef FLAG_H_
+#define FLAG_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define FLAG_TYPE_LIST \
+    X(FLAG_OPTION, bool, option, flag_option) \
+    X(FLAG_STR, char*, cstr, flag_cstr) \
+    X(FLAG_INT, int, i, flag_int) \
+    X(FLAG_FLOAT, float, f, flag_float) \
+    X(FLAG_LONG, long, l, flag_long) \
+    X(FLAG_LLONG, long long, ll, flag_llong)
+
+#define X(flag_type, _1, _2, _3) flag_type,
+typedef enum {
+    FLAG_TYPE_LIST
+}FlagType;
+#undef X
+
+#define X(_1, Type, ufield_name, _3) Type ufield_name;
+typedef union {
+FLAG_TYPE_LIST
+}FlagAs;
+#undef X
+
+typedef struct {
+    FlagType type;
+    const char* name;
+    const char* desc;
+
+    FlagAs as;
+}Flag;
+
+#ifndef FLAG_ARR_CAP
+#define FLAG_ARR_CAP 128
+#endif // FLAG_ARR_CAP
+
+#define X(flag_type, Type, ufield_name, name_) Type* name_(const char* name, Type def, const char* desc);
+FLAG_TYPE_LIST
+#undef X
+
+// Print help for flags
+void flag_type_help(FILE* sink);
+
+// Parse flags. Implicitly adds -h to print help. Returns from the index from which point on forward are positional arguments
+int flag_parse(int argc, char** argv);
+
+#endif // FLAG_H_
+
+#ifdef FLAG_IMPLEMENTATION
+#undef FLAG_IMPLEMENTATION
+
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+
+static Flag flags[FLAG_ARR_CAP] = {0};
+static size_t flags_size = 0;
+
+Flag* flag__new(FlagType type, const char* name, const char* desc) {
+    assert(flags_size < FLAG_ARR_CAP);
+
+    Flag* flag = &flags[flags_size++];
+    flag->type = type;
+    flag->name = name;
+    flag->desc = desc;
+    return flag;
+}
+
+#define X(flag_type, Type, ufield_name, name_) \
+Type* name_(const char* name, Type def, const char* desc) { \
+    Flag* opt = flag__new(flag_type, name, desc); \
+    opt->as.ufield_name = def; \
+    return &opt->as.ufield_name; \
+}
+FLAG_TYPE_LIST
+#undef X
+
+char flag_tmp_buf[128] = {0};
+char* flag__tmp_sprintf(Flag* flag) {
+    switch (flag->type) {
+    case FLAG_OPTION:
+        return flag->as.option ? "true" : "false";
+    case FLAG_STR:
+        snprintf(flag_tmp_buf, sizeof(flag_tmp_buf), "\"%s\"", flag->as.cstr);
+        return flag_tmp_buf;
+    case FLAG_INT:
+        snprintf(flag_tmp_buf, sizeof(flag_tmp_buf), "%d", flag->as.i);
+        return flag_tmp_buf;
+    case FLAG_FLOAT:
+        snprintf(flag_tmp_buf, sizeof(flag_tmp_buf), "%f", flag->as.f);
+        return flag_tmp_buf;
+    case FLAG_LONG:
+        snprintf(flag_tmp_buf, sizeof(flag_tmp_buf), "%ld", flag->as.l);
+        return flag_tmp_buf;
+    case FLAG_LLONG:
+        snprintf(flag_tmp_buf, sizeof(flag_tmp_buf), "%lld", flag->as.ll);
+        return flag_tmp_buf;
+    }
+
+    assert(0 && "unreachable");
+}
+
+char* flag__shift_args(int* argc, char*** argv) {
+    assert(*argc > 0);
+
+    char* ret = **argv;
+    (*argv) += 1;
+    (*argc) -= 1;
+    return ret;
+}
+
+void flag_type_help(FILE* sink) {
+    fprintf(sink, "Flags:\n");
+    for (size_t i = 0; i < flags_size; ++i) {
+        fprintf(sink, "    -%s\n", flags[i].name);
+        fprintf(sink, "        %s (Default: %s)\n", flags[i].desc, flag__tmp_sprintf(&flags[i]));
+    }
+}
+
+int flag_parse(int argc, char** argv) {
+    int saved_argc = argc;
+
+    char* _program = flag__shift_args(&argc, &argv);
+    (void)_program;
+
+    while (argc > 0) {
+        char* arg = flag__shift_args(&argc, &argv);
+
+        if (arg[0] == '-') {
+            arg += 1;
+
+            if (strcmp(arg, "h") == 0) {
+                flag_type_help(stdout);
+                exit(0);
+            }
+
+            bool found = false;
+            for (size_t i = 0; i < flags_size; ++i) {
+                if (strcmp(flags[i].name, arg) == 0) {
+                    found = true;
+                    switch (flags[i].type) {
+                    case FLAG_OPTION:
+                        flags[i].as.option = true;
+                        break;
+                    case FLAG_STR:
+                        if (argc < 1) {
+                            fprintf(stderr, "ERROR: Missing argument for flag -%s\n", arg);
+                            exit(1);
+                        }
+
+                        flags[i].as.cstr = flag__shift_args(&argc, &argv);
+                        break;
+                    case FLAG_INT:
+                        if (argc < 1) {
+                            fprintf(stderr, "ERROR: Missing argument for flag -%s\n", arg);
+                            exit(1);
+                        }
+
+                        flags[i].as.i = atoi(flag__shift_args(&argc, &argv));
+                        break;
+                    case FLAG_FLOAT:
+                        if (argc < 1) {
+                            fprintf(stderr, "ERROR: Missing argument for flag -%s\n", arg);
+                            exit(1);
+                        }
+
+                        flags[i].as.f = atof(flag__shift_args(&argc, &argv));
+                        break;
+                    case FLAG_LONG:
+                        if (argc < 1) {
+                            fprintf(stderr, "ERROR: Missing argument for flag -%s\n", arg);
+                            exit(1);
+                        }
+
+                        flags[i].as.l = atol(flag__shift_args(&argc, &argv));
+                        break;
+                    case FLAG_LLONG:
+                        if (argc < 1) {
+                            fprintf(stderr, "ERROR: Missing argument for flag -%s\n", arg);
+                            exit(1);
+                        }
+
+                        flags[i].as.ll = atoll(flag__shift_args(&argc, &argv));
+                        break;
+                    default:
+                        assert(0 && "unreachable");
+                        break;
+                    }
+                }
+            }
+
+            if (!found) {
+                fprintf(stderr, "ERROR: Unknown flag -%s\n", arg);
+                exit(1);
+            }
+        } else {
+            return saved_argc - argc;
+        }
+    }
+
+    return saved_argc - argc;
+}
+
+
+#endif
+#ifndef LINEAR_H_
+#define LINEAR_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifndef LINEAR_DEFAULT_CAPACITY
+#define LINEAR_DEFAULT_CAPACITY (1 << 20)
+#endif // LINEAR_DEFAULT_CAPACITY
+
+// Capacity of every chunk of a SharedLinear, in bytes
+#ifndef SHARED_LINEAR_CHUNK_SIZE
+#define SHARED_LINEAR_CHUNK_SIZE (1 << 20)
+#endif // SHARED_LINEAR_CHUNK_SIZE
+
+#ifndef LINEAR_CACHE_LINE
+#define LINEAR_CACHE_LINE 64
+#endif // LINEAR_CACHE_LINE
+
+#ifndef LINEAR_ASSERT
+#include <assert.h>
+#define LINEAR_ASSERT(expr) assert(expr)
+#endif // LINEAR_ASSERT
+
+#ifndef LINEAR_THREAD_LOCAL
+#ifdef __cplusplus
+#define LINEAR_THREAD_LOCAL thread_local
+#else // __cplusplus
+#define LINEAR_THREAD_LOCAL _Thread_local
+#endif // __cplusplus
+#endif // LINEAR_THREAD_LOCAL
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
+#ifndef cast
+#ifdef __cplusplus
+#define cast(Type, thing) reinterpret_cast<Type>(thing)
+#else // __cplusplus
+#define cast(Type, thing) (Type)(thing)
+#endif // __cplusplus
+#endif // cast
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifdef LINEAR_STATS
+typedef struct {
+    // Bytes asked for by the caller
+    size_t requested;
+    // Bytes taken from the buffer, including rounding and alignment padding
+    size_t consumed;
+    size_t peak;
+    size_t rewinds;
+    // Allocations that didn't fit
+    size_t failed;
+}LinearStats;
+#endif // LINEAR_STATS
+
+typedef struct {
+    size_t size;
+    size_t capacity;
+    uintptr_t* mem;
+    // Length of the file mapping MEM lives in, 0 when it was malloc'd
+    size_t mapped;
+
+#ifdef LINEAR_STATS
+    LinearStats stats;
+#endif // LINEAR_STATS
+}Linear;
+
+#define linear_alloc(linear, Type) (Type*)linear_allocb(linear, sizeof(Type))
+#define linear_calloc(linear, Type) (Type*)linear_callocb(linear, sizeof(Type))
+
+#define linear_alloc_array(linear, n, Type) (Type*)linear_allocb(linear, sizeof(Type) * (n))
+#define linear_calloc_array(linear, n, Type) (Type*)linear_callocb(linear, sizeof(Type) * (n))
+
+#define linear_alloc_aligned_array(linear, n, Type, align) (Type*)linear_alloc_aligned(linear, sizeof(Type) * (n), align)
+#define linear_calloc_aligned_array(linear, n, Type, align) (Type*)linear_calloc_aligned(linear, sizeof(Type) * (n), align)
+// Allocates whole cache lines, so the memory doesn't share a line with any other allocation
+#define linear_alloc_cacheline(linear, size) \
+    linear_alloc_aligned(linear, ((size) + LINEAR_CACHE_LINE - 1) & ~(size_t)(LINEAR_CACHE_LINE - 1), LINEAR_CACHE_LINE)
+
+#define linear_occupied(linear) (LINEAR_ASSERT((linear) != NULL), (linear)->size*sizeof(uintptr_t))
+#define linear_can_alloc(linear, Type) linear_can_allocb(linear, sizeof(Type))
+
+Linear linear_new(size_t capacity);
+void linear_prealloc(Linear* self, size_t capacity);
+char* linear_strdup(Linear* self, const char* cstr);
+// Formats straight into the free space, returns NULL if the string doesn't fit
+__attribute__((format(printf, 2, 3)))
+char* linear_sprintf(Linear* self, const char* fmt, ...);
+char* linear_vsprintf(Linear* self, const char* fmt, va_list args);
+
+size_t linear_snapshot(Linear* self);
+void linear_rewind(Linear* self, size_t offset);
+
+void linear_free(Linear* self);
+#ifdef LINEAR_STATS
+void linear_stats_dump(Linear* self, FILE* sink);
+#endif // LINEAR_STATS
+#define linear_reset(linear) ((linear)->size = 0)
+
+void* linear_allocb(Linear* self, size_t size);
+void* linear_callocb(Linear* self, size_t size);
+// Grows or shrinks PTR in place when it's the last allocation, otherwise copies it to new memory
+void* linear_reallocb(Linear* self, size_t oldsize, size_t newsize, void* ptr);
+
+// Allocator for containers that live on SELF. Freeing only reclaims the last allocation
+Allocator linear_allocator(Linear* self);
+// Allocates memory aligned to ALIGN, which must be a power of two
+void* linear_alloc_aligned(Linear* self, size_t size, size_t align);
+void* linear_calloc_aligned(Linear* self, size_t size, size_t align);
+void* linear_memdupb(Linear* self, void* mem, size_t size);
+bool linear_can_allocb(Linear* self, size_t size);
+
+// Byte offsets of memory inside SELF, they stay the same after saving and loading
+size_t linear_get_offset(Linear* self, void* thing);
+void* linear_from_offset(Linear* self, size_t offset);
+void* linear_exportb(Linear* self, size_t offset, size_t size);
+
+#define LINEAR_FILE_MAGIC 0x3152414e494c /* "LINAR1" */
+#define LINEAR_FILE_VERSION 1
+// Keeps the buffer cache line aligned after the header in the mapping
+#define LINEAR_FILE_HEADER_SIZE 64
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t word_size;
+    // Bytes of the buffer following the header
+    uint64_t size;
+    // FNV-1a of those bytes
+    uint64_t checksum;
+}LinearFileHeader;
+
+// Flags for linear_load
+#define LINEAR_LOAD_COW (1 << 0) // Writable, changes stay in this process
+#define LINEAR_LOAD_VERIFY (1 << 1) // Checks the checksum, which reads the whole file
+
+// Writes the used part of SELF to FILEPATH
+bool linear_save(Linear* self, const char* filepath);
+// Maps a file written by linear_save, read-only unless LINEAR_LOAD_COW is given.
+// Pages are read on first touch. The loaded Linear is full, linear_free unmaps it.
+// Whatever SELF held before is freed once the load succeeds, and kept if it fails.
+bool linear_load(Linear* self, const char* filepath, int flags);
+
+// Pointers stored as the distance from themselves, so they stay valid wherever the
+// buffer is mapped. Both ends have to live in the same buffer, 0 is NULL.
+#define LinearRel(Type) union { ptrdiff_t offset; Type* type_; }
+#define linear_rel_set(rel, ptr) \
+    ((rel).offset = (ptr) == NULL ? 0 : cast(char*, ptr) - cast(char*, &(rel)))
+#define linear_rel_get(rel) \
+    cast(__typeof__((rel).type_), (rel).offset == 0 ? NULL : cast(char*, &(rel)) + (rel).offset)
+
+// Every thread gets its own temp_linear, freed when the thread exits
+extern LINEAR_THREAD_LOCAL Linear temp_linear;
+Linear* linear_temp(void);
+#define temp_prealloc(size) linear_prealloc(linear_temp(), size)
+#define temp_alloc(Type) linear_alloc(linear_temp(), Type)
+#define temp_allocb(size) linear_allocb(linear_temp(), size)
+#define temp_sprintf(...) linear_sprintf(linear_temp(), __VA_ARGS__)
+#define temp_snapshot() linear_snapshot(&temp_linear)
+#define temp_rewind(offset) linear_rewind(&temp_linear, offset)
+#define temp_free() linear_free(&temp_linear)
+
+typedef struct linear_chunk_s {
+    struct linear_chunk_s* next;
+    size_t capacity;
+    // Reserved words, runs past capacity once the chunk is full
+    size_t size;
+    // Words handed out before the chunk filled up, set by the reservation that didn't fit
+    size_t used;
+    uintptr_t mem[];
+}LinearChunk;
+
+// A bump allocator many threads can allocate from at once.
+// Space is reserved with an atomic add, and a full chunk is replaced with a
+// compare-and-swap, so allocating never takes a lock.
+typedef struct {
+    // Newest first
+    LinearChunk* chunks;
+}SharedLinear;
+
+typedef struct {
+    LinearChunk* chunk;
+    size_t size;
+}SharedLinearSnapshot;
+
+#define shared_linear_alloc(shared, Type) (Type*)shared_linear_allocb(shared, sizeof(Type))
+#define shared_linear_alloc_array(shared, n, Type) (Type*)shared_linear_allocb(shared, sizeof(Type) * (n))
+// Bytes handed out from a chunk
+#define linear_chunk_occupied(chunk) \
+    (((chunk)->size <= (chunk)->capacity ? (chunk)->size : (chunk)->used)*sizeof(uintptr_t))
+
+void* shared_linear_allocb(SharedLinear* self, size_t size);
+
+// The following need every thread to be done allocating from SELF
+SharedLinearSnapshot shared_linear_snapshot(SharedLinear* self);
+void shared_linear_rewind(SharedLinear* self, SharedLinearSnapshot snapshot);
+void shared_linear_reset(SharedLinear* self);
+void shared_linear_free(SharedLinear* self);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // LINEAR_H_
+
+#ifdef LINEAR_IMPLEMENTATION
+#undef LINEAR_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#ifndef __cplusplus
+#include <stdalign.h>
+#endif // __cplusplus
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+LINEAR_THREAD_LOCAL Linear temp_linear = {0};
+static LINEAR_THREAD_LOCAL bool linear__temp_registered = false;
+static pthread_key_t linear__temp_key;
+static pthread_once_t linear__temp_once = PTHREAD_ONCE_INIT;
+
+static void linear__temp_destroy(void* temp) {
+    linear_free(cast(Linear*, temp));
+}
+
+static void linear__temp_create_key(void) {
+    int err = pthread_key_create(&linear__temp_key, linear__temp_destroy);
+    LINEAR_ASSERT(err == 0);
+    (void)err;
+}
+
+Linear* linear_temp(void) {
+    if (!linear__temp_registered) {
+        // The key's destructor only runs for threads that set a value
+        pthread_once(&linear__temp_once, linear__temp_create_key);
+        pthread_setspecific(linear__temp_key, &temp_linear);
+        linear__temp_registered = true;
+    }
+    return &temp_linear;
+}
+
+#ifdef LINEAR_STATS
+#define LINEAR__STAT(stmt) stmt
+
+static void linear__stats_alloc(Linear* self, size_t size, size_t before) {
+    LinearStats* stats = &self->stats;
+    stats->requested += size;
+    stats->consumed += (self->size - before)*sizeof(uintptr_t);
+    if (self->size*sizeof(uintptr_t) > stats->peak) stats->peak = self->size*sizeof(uintptr_t);
+}
+#else
+#define LINEAR__STAT(stmt)
+#endif // LINEAR_STATS
+
+Linear linear_new(size_t capacity) {
+    Linear a = {0};
+    linear_prealloc(&a, capacity);
+    return a;
+}
+
+void linear_prealloc(Linear* self, size_t capacity) {
+    size_t word_size = sizeof(uintptr_t);
+    size_t real_capacity = (capacity + word_size - 1)/word_size;
+
+    self->mem = cast(uintptr_t*, malloc(real_capacity * word_size));
+    self->size = 0;
+    self->capacity = real_capacity;
+}
+
+size_t linear_snapshot(Linear* self) {
+    return self->size;
+}
+
+void linear_rewind(Linear* self, size_t offset) {
+    LINEAR__STAT(self->stats.rewinds++);
+    self->size = offset;
+}
+
+void* linear_allocb(Linear* self, size_t size) {
+    if (self->mem == NULL) linear_prealloc(self, LINEAR_DEFAULT_CAPACITY);
+
+    size_t word_size = sizeof(uintptr_t);
+    size_t real_size = (size + word_size - 1)/word_size;
+
+    if (self->size + real_size > self->capacity) {
+        LINEAR__STAT(self->stats.failed++);
+        return NULL;
+    }
+
+    size_t i = self->size;
+    self->size += real_size;
+    LINEAR__STAT(linear__stats_alloc(self, size, i));
+    return cast(void*, self->mem + i);
+}
+
+// Reallocations that have to move get ALIGN, same as the original allocation
+static void* linear__realloc_aligned(Linear* self, size_t oldsize, size_t newsize, void* ptr, size_t align) {
+    if (ptr == NULL) return linear_alloc_aligned(self, newsize, align);
+
+    size_t word_size = sizeof(uintptr_t);
+    uintptr_t* p = cast(uintptr_t*, ptr);
+    if (p + (oldsize + word_size - 1)/word_size == self->mem + self->size) {
+        size_t end = (p - self->mem) + (newsize + word_size - 1)/word_size;
+        if (end > self->capacity) {
+            LINEAR__STAT(self->stats.failed++);
+            return NULL;
+        }
+
+        LINEAR__STAT(size_t before = self->size);
+        self->size = end;
+        LINEAR__STAT(if (end > before) linear__stats_alloc(self, newsize - oldsize, before));
+        return ptr;
+    }
+
+    void* newptr = linear_alloc_aligned(self, newsize, align);
+    if (newptr == NULL) return NULL;
+
+    memcpy(newptr, ptr, oldsize < newsize ? oldsize : newsize);
+    return newptr;
+}
+
+void* linear_reallocb(Linear* self, size_t oldsize, size_t newsize, void* ptr) {
+    return linear__realloc_aligned(self, oldsize, newsize, ptr, sizeof(uintptr_t));
+}
+
+static void* linear__allocator_alloc(void* ctx, size_t size) {
+    return linear_alloc_aligned(cast(Linear*, ctx), size, alignof(max_align_t));
+}
+
+static void* linear__allocator_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    return linear__realloc_aligned(cast(Linear*, ctx), oldsize, newsize, ptr, alignof(max_align_t));
+}
+
+static void linear__allocator_free(void* ctx, void* ptr, size_t size) {
+    Linear* self = cast(Linear*, ctx);
+    size_t word_size = sizeof(uintptr_t);
+    uintptr_t* p = cast(uintptr_t*, ptr);
+    if (p != NULL && p + (size + word_size - 1)/word_size == self->mem + self->size) {
+        self->size = p - self->mem;
+    }
+}
+
+Allocator linear_allocator(Linear* self) {
+    Allocator allocator = {linear__allocator_alloc, linear__allocator_realloc, linear__allocator_free, self};
+    return allocator;
+}
+
+void* linear_alloc_aligned(Linear* self, size_t size, size_t align) {
+    if (self->mem == NULL) linear_prealloc(self, LINEAR_DEFAULT_CAPACITY);
+
+    size_t word_size = sizeof(uintptr_t);
+    LINEAR_ASSERT((align & (align - 1)) == 0 && "alignment must be a power of two");
+    if (align < word_size) align = word_size;
+
+    uintptr_t p = cast(uintptr_t, self->mem + self->size);
+    size_t padding = ((align - (p & (align - 1))) & (align - 1))/word_size;
+    size_t real_size = (size + word_size - 1)/word_size;
+
+    if (self->size + padding + real_size > self->capacity) {
+        LINEAR__STAT(self->stats.failed++);
+        return NULL;
+    }
+
+    LINEAR__STAT(size_t before = self->size);
+    size_t i = self->size + padding;
+    self->size = i + real_size;
+    LINEAR__STAT(linear__stats_alloc(self, size, before));
+    return cast(void*, self->mem + i);
+}
+
+void* linear_calloc_aligned(Linear* self, size_t size, size_t align) {
+    void* p = linear_alloc_aligned(self, size, align);
+    if (p == NULL) return NULL;
+
+    memset(p, 0, size);
+    return p;
+}
+
+void* linear_callocb(Linear* self, size_t size) {
+    void* p = linear_allocb(self, size);
+    memset(p, 0, size);
+    return p;
+}
+
+void* linear_memdupb(Linear* self, void* mem, size_t size) {
+    void* dup = linear_allocb(self, size);
+    if (dup == NULL) return NULL;
+
+    memcpy(dup, mem, size);
+    return dup;
+}
+
+char* linear_strdup(Linear* self, const char* cstr) {
+    size_t size = strlen(cstr);
+    char* dup = linear_alloc_array(self, size, char);
+    if (dup == NULL) return NULL;
+
+    memcpy(dup, cstr, size);
+    return dup;
+}
+
+char* linear_vsprintf(Linear* self, const char* fmt, va_list args) {
+    if (self->mem == NULL) linear_prealloc(self, LINEAR_DEFAULT_CAPACITY);
+
+    char* start = cast(char*, self->mem + self->size);
+    size_t room = (self->capacity - self->size)*sizeof(uintptr_t);
+    int n = vsnprintf(start, room, fmt, args);
+    if (n < 0 || (size_t)n >= room) {
+        LINEAR__STAT(self->stats.failed++);
+        return NULL;
+    }
+
+    // The string is already in place, this only claims it
+    return linear_alloc_array(self, n + 1, char);
+}
+
+char* linear_sprintf(Linear* self, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char* cstr = linear_vsprintf(self, fmt, args);
+    va_end(args);
+    return cstr;
+}
+
+size_t linear_get_offset(Linear* self, void* thing) {
+    LINEAR_ASSERT(cast(char*, self->mem) <= cast(char*, thing) &&
+                  cast(char*, thing) <= cast(char*, self->mem + self->capacity));
+
+    return cast(char*, thing) - cast(char*, self->mem);
+}
+
+void* linear_from_offset(Linear* self, size_t offset) {
+    LINEAR_ASSERT(offset <= self->capacity*sizeof(uintptr_t));
+    return cast(char*, self->mem) + offset;
+}
+
+void* linear_exportb(Linear* self, size_t offset, size_t size) {
+    void* mem = malloc(size);
+    memcpy(mem, linear_from_offset(self, offset), size);
+    return mem;
+}
+
+static uint64_t linear__checksum(const void* data, size_t size) {
+    const unsigned char* bytes = cast(const unsigned char*, data);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool linear_save(Linear* self, const char* filepath) {
+    size_t size = self->size*sizeof(uintptr_t);
+
+    char header[LINEAR_FILE_HEADER_SIZE] = {0};
+    LinearFileHeader info = {LINEAR_FILE_MAGIC, LINEAR_FILE_VERSION, sizeof(uintptr_t), size, 0};
+    info.checksum = linear__checksum(self->mem, size);
+    memcpy(header, &info, sizeof(info));
+
+    FILE* f = fopen(filepath, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    if (fwrite(header, 1, sizeof(header), f) != sizeof(header) ||
+        (size > 0 && fwrite(self->mem, 1, size, f) != size)) {
+        fprintf(stderr, "Couldn't write %s: %s\n", filepath, strerror(errno));
+        fclose(f);
+        return false;
+    }
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Couldn't write %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool linear_load(Linear* self, const char* filepath, int flags) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Couldn't open %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        fprintf(stderr, "Couldn't stat %s: %s\n", filepath, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    LinearFileHeader info = {0};
+    if ((size_t)st.st_size < LINEAR_FILE_HEADER_SIZE || read(fd, &info, sizeof(info)) != sizeof(info)) {
+        fprintf(stderr, "Couldn't load %s: file is too short\n", filepath);
+        close(fd);
+        return false;
+    }
+
+    if (info.magic != LINEAR_FILE_MAGIC || info.version != LINEAR_FILE_VERSION || info.word_size != sizeof(uintptr_t)) {
+        fprintf(stderr, "Couldn't load %s: not a linear buffer of this version\n", filepath);
+        close(fd);
+        return false;
+    }
+
+    size_t length = LINEAR_FILE_HEADER_SIZE + info.size;
+    if ((size_t)st.st_size < length) {
+        fprintf(stderr, "Couldn't load %s: file is truncated\n", filepath);
+        close(fd);
+        return false;
+    }
+
+    int prot = flags & LINEAR_LOAD_COW ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* map = mmap(NULL, length, prot, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Couldn't map %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    uintptr_t* mem = cast(uintptr_t*, cast(char*, map) + LINEAR_FILE_HEADER_SIZE);
+    if (flags & LINEAR_LOAD_VERIFY && linear__checksum(mem, info.size) != info.checksum) {
+        fprintf(stderr, "Couldn't load %s: checksum mismatch\n", filepath);
+        munmap(map, length);
+        return false;
+    }
+
+    linear_free(self);
+    self->mem = mem;
+    self->size = info.size/sizeof(uintptr_t);
+    self->capacity = self->size;
+    self->mapped = length;
+    return true;
+}
+
+
+bool linear_can_allocb(Linear* a, size_t size) {
+    size_t word_size = sizeof(uintptr_t);
+    size_t real_size = (size + word_size - 1)/word_size;
+    return a->size + real_size < a->capacity;
+}
+
+#ifdef LINEAR_STATS
+void linear_stats_dump(Linear* self, FILE* sink) {
+    LinearStats* stats = &self->stats;
+    fprintf(sink, "Linear stats:\n");
+    fprintf(sink, "    requested: %zu bytes\n", stats->requested);
+    fprintf(sink, "    consumed: %zu bytes\n", stats->consumed);
+    fprintf(sink, "    in use: %zu of %zu bytes (peak %zu bytes)\n",
+            self->size*sizeof(uintptr_t), self->capacity*sizeof(uintptr_t), stats->peak);
+    fprintf(sink, "    rewinds: %zu, failed allocations: %zu\n", stats->rewinds, stats->failed);
+}
+#endif // LINEAR_STATS
+
+void linear_free(Linear* self) {
+    if (self->mapped > 0) {
+        munmap(cast(char*, self->mem) - LINEAR_FILE_HEADER_SIZE, self->mapped);
+    } else {
+        free(self->mem);
+    }
+    self->mem = NULL;
+    self->mapped = 0;
+    self->size = 0;
+    self->capacity = 0;
+}
+
+void* shared_linear_allocb(SharedLinear* self, size_t size) {
+    size_t word_size = sizeof(uintptr_t);
+    size_t real_size = (size + word_size - 1)/word_size;
+
+    LinearChunk* chunk = __atomic_load_n(&self->chunks, __ATOMIC_ACQUIRE);
+    while (true) {
+        if (chunk != NULL) {
+            // A failed reservation leaves size past capacity, which seals the chunk for everyone
+            size_t i = __atomic_fetch_add(&chunk->size, real_size, __ATOMIC_RELAXED);
+            if (i + real_size <= chunk->capacity) return cast(void*, chunk->mem + i);
+            // Only the first reservation that doesn't fit starts at or before capacity
+            if (i <= chunk->capacity) __atomic_store_n(&chunk->used, i, __ATOMIC_RELAXED);
+        }
+
+        size_t capacity = SHARED_LINEAR_CHUNK_SIZE/word_size;
+        if (capacity < real_size) capacity = real_size;
+
+        LinearChunk* fresh = cast(LinearChunk*, malloc(sizeof(LinearChunk) + capacity*word_size));
+        LINEAR_ASSERT(fresh != NULL);
+        fresh->next = chunk;
+        fresh->capacity = capacity;
+        fresh->size = real_size;
+        fresh->used = 0;
+
+        if (__atomic_compare_exchange_n(&self->chunks, &chunk, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return cast(void*, fresh->mem);
+        }
+
+        // Another thread replaced the chunk first, CHUNK now holds its one
+        free(fresh);
+    }
+}
+
+SharedLinearSnapshot shared_linear_snapshot(SharedLinear* self) {
+    SharedLinearSnapshot snapshot = {self->chunks, 0};
+    if (snapshot.chunk != NULL) {
+        snapshot.size = linear_chunk_occupied(snapshot.chunk)/sizeof(uintptr_t);
+    }
+    return snapshot;
+}
+
+void shared_linear_rewind(SharedLinear* self, SharedLinearSnapshot snapshot) {
+    while (self->chunks != snapshot.chunk) {
+        LinearChunk* next = self->chunks->next;
+        free(self->chunks);
+        self->chunks = next;
+    }
+
+    if (self->chunks != NULL) self->chunks->size = snapshot.size;
+}
+
+void shared_linear_reset(SharedLinear* self) {
+    if (self->chunks == NULL) return;
+
+    LinearChunk* chunk = self->chunks->next;
+    while (chunk != NULL) {
+        LinearChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    self->chunks->next = NULL;
+    self->chunks->size = 0;
+}
+
+void shared_linear_free(SharedLinear* self) {
+    shared_linear_reset(self);
+    free(self->chunks);
+    self->chunks = NULL;
+}
+#endif // LINEAR_IMPLEMENTATION
+
+#ifndef LOG_H_
+#define LOG_H_
+#include <stdio.h>
+
+typedef enum {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+
+    LOG_COUNT_,
+}LogLevel;
+
+typedef struct {
+    LogLevel level;
+    FILE* log_file;
+}Logger;
+
+extern Logger global_logger;
+
+void logger_log(Logger* self, LogLevel level, const char* fmt, ...);
+#define logger_info(logger, ...) logger_log(logger, LOG_INFO, __VA_ARGS__)
+#define logger_warn(logger, ...) logger_log(logger, LOG_WARN, __VA_ARGS__)
+#define logger_debug(logger, ...) logger_log(logger, LOG_DEBUG, __VA_ARGS__)
+#define logger_error(logger, ...) logger_log(logger, LOG_ERROR, __VA_ARGS__)
+
+#endif // LOG_H_
+
+#ifdef LOG_IMPLEMENTATION
+#include <stdarg.h>
+#include <assert.h>
+
+Logger global_logger;
+
+_Static_assert(LOG_COUNT_ == 4, "New log level was added");
+const char* log_levels_as_str[] = {
+    [LOG_DEBUG] = "DEBUG",
+    [LOG_INFO] = "INFO",
+    [LOG_WARN] = "WARN",
+    [LOG_ERROR] = "ERROR",
+};
+
+void logger_log(Logger* self, LogLevel level, const char* fmt, ...) {
+    if (self == &global_logger && self->log_file == NULL) self->log_file = stdout;
+    if (self->level > level) return;
+
+    assert(self->log_file != NULL && "log_file must not be NULL");
+
+    va_list args;
+    va_start(args, fmt);
+
+    fprintf(self->log_file, "[%s] ", log_levels_as_str[level]);
+    vfprintf(self->log_file, fmt, args);
+
+    va_end(args);
+}
+
+#endif
+#ifndef PROCESS_H_
+#define PROCESS_H_
+#endif // PROCESS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+
+#ifndef PROCESS_MALLOC
+#include <stdlib.h>
+#define PROCESS_MALLOC malloc
+#endif // PROCESS_MALLOC
+
+#ifndef PROCESS_FREE
+#include <stdlib.h>
+#define PROCESS_FREE free
+#endif // PROCESS_FREE
+
+#ifndef PROCESS_ASSERT
+#include <assert.h>
+#define PROCESS_ASSERT assert
+#endif // PROCESS_ASSERT
+
+#define PIPE_READ 0
+#define PIPE_WRITE 1
+
+bool process_close(int fd);
+bool process_dup2(int fd1, int fd2);
+bool process_pipe(int pipefd[2]);
+
+bool process_wait_for_exit(pid_t pid);
+int process_start(const char* args[], size_t args_count);
+
+bool process_run(const char* args[], size_t args_count);
+
+typedef struct {
+    int pid;
+    int in_pipe[2];
+    int out_pipe[2];
+}Proc;
+
+#define PROCESS_PIPE_STDIN (1 << 0)
+#define PROCESS_PIPE_STDOUT (1 << 1)
+#define PROCESS_PIPE_STDERR (1 << 2)
+#define PROCESS_PIPE_ALL (PROCESS_PIPE_STDIN | PROCESS_PIPE_STDOUT | PROCESS_PIPE_STDERR)
+
+Proc process_start_ex(const char* args[], size_t args_count, uint8_t pipe_flags);
+bool prcess_proc_destroy(Proc* proc);
+
+#ifdef PROCESS_IMPLEMENTATION
+#undef PROCESS_IMPLEMENTATION
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+bool process_close(int fd) {
+    if (close(fd) < 0) {
+        fprintf(stderr, "Couldn't close %d: %s\n", fd, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool process_dup2(int fd1, int fd2) {
+    if (dup2(fd1, fd2) < 0) {
+        fprintf(stderr, "Couldn't dup2: %s\n", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool process_pipe(int pipefd[2]) {
+    if (pipe(pipefd) < 0) {
+        fprintf(stderr, "Couldn't create pipe: %s\n", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool process_wait_for_exit(pid_t pid) {
+    while (1) {
+        int wstatus = 0;
+        if (waitpid(pid, &wstatus, 0) < 0) {
+            fprintf(stderr, "Couldn't wait for process: %s\n", strerror(errno));
+            return false;
+        }
+
+        if (WIFEXITED(wstatus)) {
+            int estatus = WEXITSTATUS(wstatus);
+            if (estatus) {
+                fprintf(stderr, "Process exited with status %d\n", estatus);
+                return false;
+            }
+
+            return true;
+        }
+
+        if (WIFSIGNALED(wstatus)) {
+            fprintf(stderr, "Process was terminated by signal %d (%s)\n", WTERMSIG(wstatus), strsignal(WTERMSIG(wstatus)));
+            return false;
+        }
+    }
+    assert(0);
+}
+
+int process_start(const char* args[], size_t args_count) {
+    char** args_copy = PROCESS_MALLOC((args_count + 1) * sizeof(char*));
+    PROCESS_ASSERT(args_copy != NULL);
+
+    memcpy(args_copy, args, args_count * sizeof(char*));
+    args_copy[args_count] = NULL;
+
+    int pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Couldn't fork: %s\n", strerror(errno));
+        PROCESS_FREE(args_copy);
+
+        return -1;
+    } else if (pid == 0) {
+        execvp(args_copy[0], args_copy);
+
+        fprintf(stderr, "Couldn't exec %s: %s\n", args_copy[0], strerror(errno));
+        exit(1);
+    }
+
+    PROCESS_FREE(args_copy);
+    return pid;
+}
+
+bool process_run(const char* args[], size_t args_count) {
+    int pid = process_start(args, args_count);
+    return process_wait_for_exit(pid);
+}
+
+Proc process_start_ex(const char* args[], size_t args_count, uint8_t pipe_flags) {
+    Proc proc;
+    proc.pid = -1;
+
+    char** args_copy = PROCESS_MALLOC((args_count + 1) * sizeof(char*));
+    PROCESS_ASSERT(args_copy != NULL);
+
+    memcpy(args_copy, args, args_count * sizeof(char*));
+    args_copy[args_count] = NULL;
+
+    bool should_pipe_in = (pipe_flags & PROCESS_PIPE_STDIN) != 0;
+    bool should_pipe_out = (pipe_flags & PROCESS_PIPE_STDOUT) != 0;
+    bool should_pipe_errout = (pipe_flags & PROCESS_PIPE_STDERR) != 0;
+
+    if (should_pipe_in) {
+        if (!process_pipe(proc.in_pipe)) return proc;
+    }
+
+    if (should_pipe_out || should_pipe_errout) {
+        if (!process_pipe(proc.out_pipe)) return proc;
+    }
+
+    proc.pid = fork();
+    if (proc.pid < 0) {
+        fprintf(stderr, "Couldn't fork: %s\n", strerror(errno));
+        return proc;
+    } else if (proc.pid == 0) {
+        if (should_pipe_in) {
+            if (!process_dup2(proc.in_pipe[PIPE_READ], STDIN_FILENO)) exit(1);
+            if (!process_close(proc.in_pipe[PIPE_WRITE])) exit(1);
+        }
+
+        if (should_pipe_out) {
+            if (!process_dup2(proc.out_pipe[PIPE_WRITE], STDOUT_FILENO)) exit(1);
+        }
+
+        if (should_pipe_errout) {
+            if (!process_dup2(proc.out_pipe[PIPE_WRITE], STDERR_FILENO)) exit(1);
+        }
+
+        if (should_pipe_out || should_pipe_errout) {
+            if (!process_close(proc.out_pipe[PIPE_READ])) exit(1);
+        }
+
+        execvp(args_copy[0], args_copy);
+
+        fprintf(stderr, "Couldn't exec %s: %s\n", args_copy[0], strerror(errno));
+        exit(1);
+    }
+
+    if (should_pipe_in) {
+        if (!process_close(proc.in_pipe[PIPE_READ])) exit(1);
+    }
+
+    if (should_pipe_out || should_pipe_errout) {
+        if (!process_close(proc.out_pipe[PIPE_WRITE])) exit(1);
+    }
+
+    PROCESS_FREE(args_copy);
+    return proc;
+}
+
+bool process_proc_destroy(Proc* proc) {
+    if (!process_close(proc->in_pipe[PIPE_WRITE])) return false;
+    if (!process_close(proc->out_pipe[PIPE_READ])) return false;
+    return true;
+}
+
+#endif // PROCESS_IMPLEMENTATION
+#ifndef STRING_BUILDER_H_
+#define STRING_BUILDER_H_
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct {
+    char* items;
+    size_t count;
+    size_t capacity;
+    // NULL means realloc/free
+    const Allocator* allocator;
+    // ITEMS points into the buffer of an SB_SBO
+    bool inline_items;
+    // ITEMS is a mapping of its own, from growing past SB_MMAP_THRESHOLD
+    bool mapped_items;
+}StringBuilder;
+typedef StringBuilder SB;
+
+// A string builder with N bytes of storage inside the owning struct, so short
+// strings never allocate. sb_sbo_init returns the builder, which moves to the
+// heap once it outgrows the buffer.
+#define SB_SBO(N) struct { StringBuilder sb; char buffer[N]; }
+#define sb_sbo_init(sbo) sb__init_inline(&(sbo)->sb, (sbo)->buffer, sizeof((sbo)->buffer))
+StringBuilder* sb__init_inline(StringBuilder* sb, char* buffer, size_t size);
+
+// Resizes a string builder 
+void sb_maybe_resize(StringBuilder* sb, size_t to_append_len);
+
+// Pushes a character to a string builder 
+void sb_push(StringBuilder* sb, char c);
+
+#define sb_push_null(sb) sb_push(sb, 0)
+
+void sb_push_str_null(StringBuilder* sb, ...);
+// Pushes a variadic amount of null-terminated strings to a string builder 
+#define sb_push_str(sb, ...) sb_push_str_null(sb, __VA_ARGS__, NULL)
+
+// Pushes a formatted string to a string builder
+__attribute__((format(printf, 2, 3)))
+void sb_push_sprintf(StringBuilder* sb, const char* fmt, ...);
+
+// Pushes a sized string of certain length to a string builder 
+#define sb_push_nstr(self, str, len) sb_push_bytes(self, str, len)
+
+// Pushes bytes of certain length to a string builder 
+void sb_push_bytes(StringBuilder* self, void* data, size_t sizeb);
+
+// Writes the contents of a string builder to a file descriptor
+#define sb_write(sb, fd) write(fd, sb.items, sb.count)
+// Writes the contents of a string builder to a file handle
+#define sb_fwrite(sb, f) fwrite((sb)->items, 1, (sb)->count, f)
+// Writes the contents of a string builder to a file
+bool sb_write_file(StringBuilder* self, const char* filepath);
+
+bool sb_read(StringBuilder* sb, int fd, size_t n);
+bool sb_fread(StringBuilder* sb, FILE* f, size_t n);
+
+// Reads the provided file and appends its contents into the provided SB.
+bool sb_read_file(StringBuilder* sb, const char* filepath); 
+
+#ifndef SB_NO_CURL
+// Downloads file with CURL
+bool sb_download_file(StringBuilder* sb, const char* url);
+#endif // SB_NO_CURL
+
+// Reads the provided file in batches and appends its contents into the provided SB.
+bool sb_read_file_batches(StringBuilder* sb, const char* filepath);
+
+// Exports the contents of a string builder to heap memory 
+char* sb_export(StringBuilder const* sb);
+
+// Exports the contents of a string builder to to provided DST 
+void sb_export_inplace(StringBuilder const* sb, char dst[sb->count]);
+
+// Frees a string builder
+void sb_free(StringBuilder* sb);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // STRING_BUILDER_H_
+
+#ifdef SB_IMPLEMENTATION
+#undef SB_IMPLEMENTATION
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef SB_NO_CURL
+#include <curl/curl.h>
+#endif // SB_NO_CURL
+#include <errno.h>
+#include <unistd.h>
+
+#ifndef SB_MALLOC
+    #define SB_MALLOC malloc
+#endif // SB_MALLOC
+
+#ifndef SB_INIT_CAP
+#define SB_INIT_CAP 8
+#endif // SB_INIT_CAP
+
+// Builders without an allocator move to their own mapping once they reach this
+// many bytes, and grow with mremap from there. 0 disables it, which is the
+// default when sys/mman.h has no mremap (glibc needs _GNU_SOURCE), since each
+// growth would copy the whole mapping where realloc can remap
+#ifndef SB_MMAP_THRESHOLD
+#ifdef MREMAP_MAYMOVE
+#define SB_MMAP_THRESHOLD (1 << 26)
+#else
+#define SB_MMAP_THRESHOLD 0
+#endif // MREMAP_MAYMOVE
+#endif // SB_MMAP_THRESHOLD
+
+size_t __curl_sb(void *contents, size_t sz, size_t nmemb, void *ctx) {
+    size_t realsize = sz * nmemb;
+
+    sb_maybe_resize(ctx, realsize);
+    sb_push_nstr(ctx, contents, realsize);
+
+    return realsize;
+}
+
+void sb_maybe_resize(StringBuilder* sb, size_t to_append_len) {
+    if (sb->count + to_append_len >= sb->capacity) {
+        size_t old_size = sizeof(sb->items[0]) * sb->capacity;
+        if (sb->capacity == 0) sb->capacity = SB_INIT_CAP;
+        while (sb->count + to_append_len >= sb->capacity) {
+            sb->capacity *= 2;
+        }
+
+        size_t new_size = sizeof(sb->items[0]) * sb->capacity;
+        if (sb->inline_items) {
+            char* items = sb->allocator != NULL ? allocator_alloc(sb->allocator, new_size) : malloc(new_size);
+            assert(items != NULL);
+            memcpy(items, sb->items, sb->count);
+            sb->items = items;
+            sb->inline_items = false;
+        } else if (sb->allocator != NULL) {
+            sb->items = sb->items == NULL
+                ? allocator_alloc(sb->allocator, new_size)
+                : allocator_realloc(sb->allocator, sb->items, old_size, new_size);
+        } else if (sb->mapped_items) {
+            sb->items = allocator_realloc(&mmap_allocator, sb->items, old_size, new_size);
+#if SB_MMAP_THRESHOLD > 0
+        } else if (new_size >= SB_MMAP_THRESHOLD) {
+            char* mapped = allocator_alloc(&mmap_allocator, new_size);
+            assert(mapped != NULL);
+            if (sb->count > 0) memcpy(mapped, sb->items, sb->count);
+            free(sb->items);
+            sb->items = mapped;
+            sb->mapped_items = true;
+#endif // SB_MMAP_THRESHOLD
+        } else {
+            sb->items = realloc(sb->items, new_size);
+        }
+        assert(sb->items != NULL);
+    }
+}
+
+StringBuilder* sb__init_inline(StringBuilder* sb, char* buffer, size_t size) {
+    sb->items = buffer;
+    sb->count = 0;
+    sb->capacity = size;
+    sb->allocator = NULL;
+    sb->inline_items = true;
+    sb->mapped_items = false;
+    return sb;
+}
+
+void sb_push(StringBuilder* sb, char c) {
+    sb_maybe_resize(sb, 1);
+    sb->items[sb->count++] = c;
+}
+
+void sb_push_str_null(StringBuilder* sb, ...) {
+    va_list list;
+    va_start(list, sb);
+
+    const char* cstr = va_arg(list, const char*);
+    while (cstr != NULL) {
+        int len = strlen(cstr);
+        sb_maybe_resize(sb, len);
+        memcpy(sb->items + sb->count, cstr, len);
+        sb->count += len;
+        cstr = va_arg(list, char*);
+    }
+
+    va_end(list);
+}
+
+void sb_push_bytes(StringBuilder* self, void* data, size_t sizeb) {
+    sb_maybe_resize(self, sizeb);
+    memcpy(self->items + self->count, data, sizeb);
+    self->count += sizeb;
+}
+
+void sb_push_sprintf(StringBuilder* sb, const char* restrict fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+
+    va_start(args, fmt);
+
+    sb_maybe_resize(sb, n + 1);
+    int n_ = vsnprintf(sb->items + sb->count, n + 1, fmt, args);
+    assert(n == n_);
+    sb->count += n;
+
+    va_end(args);
+}
+
+bool sb_read_file(StringBuilder* sb, const char* filepath) {
+    FILE* f = fopen(filepath, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size_t n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    sb_maybe_resize(sb, n);
+    int n_ = fread(sb->items, 1, n, f);
+    assert(n_ == (int)n);
+    sb->count += n_;
+
+    fclose(f);
+    return true;
+} 
+
+bool sb_fread(StringBuilder* sb, FILE* f, size_t n) {
+    sb_maybe_resize(sb, n);
+
+    errno = 0;
+    size_t n_ = fread(sb->items + sb->count, 1, n, f);
+    if (errno != 0) {
+        fprintf(stderr, "Error reading file: %s\n", strerror(errno));
+        return false;
+    }
+
+    sb->count += n;
+    return n_ == n;
+}
+
+#ifndef SB_NO_CURL
+bool sb_download_file(StringBuilder* sb, const char* url) {
+    CURL* h = curl_easy_init();
+    if (h == NULL) {
+        fprintf(stderr, "Couldn't init CURL context\n");
+        return false;
+    }
+
+    curl_easy_setopt(h, CURLOPT_URL, url);
+    curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, __curl_sb);
+    curl_easy_setopt(h, CURLOPT_WRITEDATA, sb);
+
+    CURLcode ret = curl_easy_perform(h);
+    if (ret != CURLE_OK) {
+        fprintf(stderr, "Couldn't download %s: %s\n", url, curl_easy_strerror(ret));
+        curl_easy_cleanup(h);
+        return false;
+    }
+
+    curl_easy_cleanup(h);
+    return true;
+}
+#endif // SB_NO_CURL
+
+bool sb_read(StringBuilder* sb, int fd, size_t n) {
+    sb_maybe_resize(sb, n);
+    read(fd, sb->items + sb->count, n);
+    sb->count += n;
+    return true;
+}
+
+bool sb_write_file(StringBuilder* self, const char* filepath) {
+    FILE* f = fopen(filepath, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    int n = sb_fwrite(self, f);
+    assert(n == (int)self->count);
+
+    fclose(f);
+
+    return true;
+}
+
+bool sb_read_file_batches(StringBuilder* sb, const char* filepath) {
+    FILE* f = fopen(filepath, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    char buf[1024] = {0};
+    size_t n = 0;
+
+    errno = 0;
+    while ((n = fread(buf, 1, 1024, f)) > 0) {
+        if (errno != 0) {
+            fprintf(stderr, "Error reading file: %s\n", strerror(errno));
+            fclose(f);
+            return false;
+        }
+
+        sb_maybe_resize(sb, n);
+        sb_push_nstr(sb, buf, n);
+
+        errno = 0;
+    }
+
+    fclose(f);
+    return true;
+} 
+
+char* sb_export(StringBuilder const* sb) {
+    char* out = SB_MALLOC(sizeof(char) * (sb->count + 1));
+    memcpy(out, sb->items, sb->count);
+    out[sb->count] = 0;
+    return out;
+}
+
+void sb_export_inplace(StringBuilder const* sb, char dst[sb->count]) {
+    memcpy(dst, sb->items, sb->count);
+}
+
+void sb_free(StringBuilder* sb) {
+    if (sb->inline_items) {
+        // The buffer belongs to the owning struct
+    } else if (sb->allocator != NULL) {
+        if (sb->items != NULL) allocator_free(sb->allocator, sb->items, sizeof(sb->items[0]) * sb->capacity);
+    } else if (sb->mapped_items) {
+        allocator_free(&mmap_allocator, sb->items, sizeof(sb->items[0]) * sb->capacity);
+    } else {
+        free(sb->items);
+    }
+    sb->items = NULL;
+    sb->count = 0;
+    sb->capacity = 0;
+    sb->inline_items = false;
+    // A freed builder starts over on the heap
+    sb->mapped_items = false;
+}
+
+#endif // STRING_BUILDER_IMPLENTATION
+
+#ifndef STRING_VIEW_H_
+#define STRING_VIEW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
+#define SV_FMT "%.*s"
+#define SV_F(sv) (int)(sv).len, (sv).start
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef bool (*sv_predicate_t)(char c);
+
+typedef struct {
+    const char* start;
+    size_t len;
+}StringView;
+
+typedef struct {
+    StringView* items;
+    size_t count;
+    size_t capacity;
+    // NULL means realloc/free
+    const Allocator* allocator;
+}StringSplit;
+
+// A set of delimiter bytes for sv_chop_by_any, made by sv_delims
+typedef struct {
+    // A byte is a delimiter when lo[byte & 15] & hi[byte >> 4] isn't 0, which
+    // SIMD shuffles can look up 16 or 32 bytes at once
+    uint8_t lo[16], hi[16];
+    // False with more than 8 delimiters, which the nibble tables can't tell apart
+    bool nibbles;
+    bool table[256];
+}SvDelims;
+
+// Walks the fields of a StringView one at a time, without allocating.
+// Set the options after sv_split_iter_init, before the first sv_split_iter_next.
+typedef struct {
+    StringView rest;
+    char delim;
+    // Splits on any of these instead of DELIM when not NULL
+    const SvDelims* delims;
+    bool skip_empty;
+    // Fields split off before the rest comes out as the last one, 0 means no limit
+    size_t max_splits;
+    size_t splits;
+}SvSplitIter;
+
+// Creates a StringView from a C string
+StringView sv_from_parts(const char* start, size_t len);
+#define sv_from_cstr(str) sv_from_parts(str, strlen(str))
+
+void sv_step(StringView* self);
+
+StringView sv_chop_by_c(StringView* sv, char delim);
+StringView sv_trim_left(StringView sv);
+StringView sv_trim_right(StringView sv);
+StringView sv_trim(StringView sv);
+
+StringView sv_chop_by_pred(StringView* sv, sv_predicate_t pred);
+StringView sv_trim_left_pred(StringView sv, sv_predicate_t pred);
+StringView sv_trim_right_pred(StringView sv, sv_predicate_t pred);
+StringView sv_trim_pred(StringView sv, sv_predicate_t pred);
+
+long sv_to_long(StringView* sv, int base);
+size_t sv_to_ulong(StringView* sv, int base);
+float sv_to_float(StringView* sv);
+double sv_to_double(StringView* sv);
+long long sv_to_longlong(StringView* sv, int base);
+unsigned long long sv_to_ulonglong(StringView* sv, int base);
+
+SvDelims sv_delims(const char* delims);
+// Same as sv_chop_by_c, but stops at any of DELIMS
+StringView sv_chop_by_any(StringView* sv, const SvDelims* delims);
+
+// Fields come out the same as the pieces of sv_split
+SvSplitIter sv_split_iter_init(StringView sv, char delim);
+SvSplitIter sv_split_iter_init_any(StringView sv, const SvDelims* delims);
+bool sv_split_iter_next(SvSplitIter* self, StringView* field);
+// Splits into at most CAPACITY fields, the last of which takes the rest of SV.
+// Returns how many fields it wrote
+size_t sv_split_fixed(StringView sv, char delim, StringView* fields, size_t capacity);
+
+StringSplit sv_split(StringView sv, char c);
+StringSplit sv_split_any(StringView sv, const SvDelims* delims);
+void sv_split_any_append(StringSplit* split, StringView sv, const SvDelims* delims);
+StringSplit sv_split_pred(StringView sv, sv_predicate_t pred);
+// Appends the pieces to SPLIT, whose items come from its allocator if it has one
+void sv_split_append(StringSplit* split, StringView sv, char c);
+void sv_split_pred_append(StringSplit* split, StringView sv, sv_predicate_t pred);
+void sv_split_free(StringSplit* split);
+
+bool sv_cmpc(StringView sv, const char* cstr);
+bool sv_cmpsv(StringView sv, StringView that);
+bool sv_ends_with(StringView self, StringView suffix);
+bool sv_starts_with(StringView self, StringView prefix);
+
+char* sv_to_cstr(StringView sv);
+char* sv_to_cstr_inplace(StringView sv, char buf[sv.len + 1]);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // STRING_VIEW_H_
+
+#ifdef SV_IMPLEMENTATION
+#undef SV_IMPLEMENTATION
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#ifndef SV_MALLOC
+#define SV_MALLOC malloc
+#endif // SV_MALLOC
+
+static void split_maybe_resize(StringSplit* split) {
+    if (split->count == split->capacity) {
+        size_t old_size = sizeof(*split->items) * split->capacity;
+        split->capacity = split->capacity == 0? 2 : split->capacity * 2;
+
+        size_t new_size = sizeof(*split->items) * split->capacity;
+        if (split->allocator != NULL) {
+            split->items = split->items == NULL
+                ? allocator_alloc(split->allocator, new_size)
+                : allocator_realloc(split->allocator, split->items, old_size, new_size);
+        } else {
+            split->items = realloc(split->items, new_size);
+        }
+        assert(split->items != NULL);
+    }
+}
+
+static void split_append(StringSplit* split, StringView sv) {
+    split_maybe_resize(split);
+    split->items[split->count++] = sv;
+}
+
+StringView sv_from_parts(const char* start, size_t len) {
+    return (StringView) { .start = start, .len = len };
+}
+
+void sv_step(StringView* self) {
+    self->start += 1;
+    self->len -= 1;
+}
+
+// Cuts SV at I, the index of a delimiter or SV->len if there's none
+static StringView sv__chop_at(StringView* sv, size_t i) {
+    StringView out = { sv->start, i };
+
+    if (i < sv->len) {
+        sv->start += i + 1;
+        sv->len -= i + 1;
+    } else {
+        // Callers rely on start ending up on the last byte
+        sv->start = &sv->start[sv->len - 1];
+        sv->len = 0;
+    }
+
+    return out;
+}
+
+StringView sv_chop_by_c(StringView* sv, char delim) {
+    // memchr is vectorized and picks the widest instructions at runtime
+    const char* found = sv->len > 0 ? memchr(sv->start, delim, sv->len) : NULL;
+    return sv__chop_at(sv, found != NULL ? (size_t)(found - sv->start) : sv->len);
+}
+
+SvDelims sv_delims(const char* delims) {
+    SvDelims set;
+    memset(&set, 0, sizeof(set));
+
+    size_t count = 0;
+    for (const unsigned char* d = (const unsigned char*)delims; *d; ++d) {
+        if (set.table[*d]) continue;
+        set.table[*d] = true;
+
+        if (count < 8) {
+            set.lo[*d & 15] |= 1 << count;
+            set.hi[*d >> 4] |= 1 << count;
+        }
+        count++;
+    }
+
+    set.nibbles = count <= 8;
+    return set;
+}
+
+static size_t sv__find_any_scalar(const unsigned char* s, size_t len, const SvDelims* delims) {
+    for (size_t i = 0; i < len; ++i) {
+        if (delims->table[s[i]]) return i;
+    }
+    return len;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(SV_NO_SIMD)
+#include <immintrin.h>
+#define SV__SIMD
+
+__attribute__((target("ssse3")))
+static size_t sv__find_any_ssse3(const unsigned char* s, size_t len, const SvDelims* delims) {
+    __m128i lo = _mm_loadu_si128((const __m128i*)delims->lo);
+    __m128i hi = _mm_loadu_si128((const __m128i*)delims->hi);
+    __m128i nibble = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i lo_class = _mm_shuffle_epi8(lo, _mm_and_si128(bytes, nibble));
+        __m128i hi_class = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        __m128i none = _mm_cmpeq_epi8(_mm_and_si128(lo_class, hi_class), _mm_setzero_si128());
+
+        unsigned mask = ~_mm_movemask_epi8(none) & 0xffff;
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return i + sv__find_any_scalar(s + i, len - i, delims);
+}
+
+__attribute__((target("avx2")))
+static size_t sv__find_any_avx2(const unsigned char* s, size_t len, const SvDelims* delims) {
+    // vpshufb looks up each 128 bit lane separately, so both lanes get the tables
+    __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)delims->lo));
+    __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)delims->hi));
+    __m256i nibble = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i lo_class = _mm256_shuffle_epi8(lo, _mm256_and_si256(bytes, nibble));
+        __m256i hi_class = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+        __m256i none = _mm256_cmpeq_epi8(_mm256_and_si256(lo_class, hi_class), _mm256_setzero_si256());
+
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(none);
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    // The 16 byte step stays VEX encoded here. Calling the SSSE3 version with
+    // the upper halves dirty would pay an SSE/AVX transition on every call
+    if (i + 16 <= len) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i lo_class = _mm_shuffle_epi8(_mm256_castsi256_si128(lo), _mm_and_si128(bytes, _mm256_castsi256_si128(nibble)));
+        __m128i hi_class = _mm_shuffle_epi8(_mm256_castsi256_si128(hi),
+            _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm256_castsi256_si128(nibble)));
+        __m128i none = _mm_cmpeq_epi8(_mm_and_si128(lo_class, hi_class), _mm_setzero_si128());
+
+        unsigned mask = ~_mm_movemask_epi8(none) & 0xffff;
+        if (mask != 0) return i + __builtin_ctz(mask);
+        i += 16;
+    }
+    return i + sv__find_any_scalar(s + i, len - i, delims);
+}
+#endif // SIMD
+
+// Index of the first byte of S that's in DELIMS, or LEN
+static size_t sv__find_any(const unsigned char* s, size_t len, const SvDelims* delims) {
+#ifdef SV__SIMD
+    if (delims->nibbles && len >= 16) {
+        if (__builtin_cpu_supports("avx2")) return sv__find_any_avx2(s, len, delims);
+        if (__builtin_cpu_supports("ssse3")) return sv__find_any_ssse3(s, len, delims);
+    }
+#endif // SV__SIMD
+    return sv__find_any_scalar(s, len, delims);
+}
+
+StringView sv_chop_by_any(StringView* sv, const SvDelims* delims) {
+    return sv__chop_at(sv, sv__find_any((const unsigned char*)sv->start, sv->len, delims));
+}
+
+StringView sv_trim_left(StringView sv) {
+    while (sv.len > 0 && isspace(sv.start[0])) {
+        ++sv.start;
+        --sv.len;
+    }
+
+    return sv;
+}
+
+StringView sv_trim_right(StringView sv) {
+    while (sv.len > 0 && isspace(sv.start[sv.len - 1])) {
+        --sv.len;
+    }
+
+    return sv;
+}
+
+StringView sv_trim(StringView sv) {
+    return sv_trim_left(sv_trim_right(sv));
+}
+
+long sv_to_long(StringView* sv, int base) {
+    char* end = NULL;
+    long num = strtol(sv->start, &end, base);
+    sv->len -= end - sv->start;
+    sv->start = end;
+    return num;
+}
+
+size_t sv_to_ulong(StringView* sv, int base) {
+    char* end = NULL;
+    size_t num = strtoul(sv->start, &end, base);
+    sv->len -= end - sv->start;
+    sv->start = end;
+    return num;
+}
+
+double sv_to_double(StringView* sv) {
+    char* end = NULL;
+    double num = strtod(sv->start, &end);
+    sv->len -= end - sv->start;
+    sv->start = end;
+    return num;
+}
+
+float sv_to_float(StringView* sv) {
+    char* end = NULL;
+    float num = strtof(sv->start, &end);
+    sv->len -= end - sv->start;
+    sv->start = end;
+    return num;
+}
+
+unsigned long long sv_to_ulonglong(StringView* sv, int base) {
+    char* end = NULL;
+    unsigned long long num = strtoull(sv->start, &end, base);
+    sv->len -= end - sv->start;
+    sv->start = end;
+    return num;
+}
+
+long long sv_to_longlong(StringView* sv, int base) {
+    char* end = NULL;
+    long long num = strtoll(sv->start, &end, base);
+    sv->len -= end - sv->start;
+    sv->start = end;
+    return num;
+}
+
+StringSplit sv_split(StringView sv, char c) {
+    StringSplit split = {};   
+    sv_split_append(&split, sv, c);
+    return split;
+}
+
+void sv_split_append(StringSplit* split, StringView sv, char c) {
+    while (sv.len > 0) {
+        split_append(split, sv_chop_by_c(&sv, c));
+    }
+}
+
+SvSplitIter sv_split_iter_init(StringView sv, char delim) {
+    SvSplitIter iter = { sv, delim, NULL, false, 0, 0 };
+    return iter;
+}
+
+SvSplitIter sv_split_iter_init_any(StringView sv, const SvDelims* delims) {
+    SvSplitIter iter = { sv, 0, delims, false, 0, 0 };
+    return iter;
+}
+
+bool sv_split_iter_next(SvSplitIter* self, StringView* field) {
+    while (self->rest.len > 0) {
+        if (self->max_splits != 0 && self->splits == self->max_splits) {
+            *field = self->rest;
+            self->rest.start += self->rest.len;
+            self->rest.len = 0;
+            return true;
+        }
+
+        StringView piece = self->delims != NULL
+            ? sv_chop_by_any(&self->rest, self->delims)
+            : sv_chop_by_c(&self->rest, self->delim);
+        if (self->skip_empty && piece.len == 0) continue;
+
+        self->splits++;
+        *field = piece;
+        return true;
+    }
+
+    return false;
+}
+
+size_t sv_split_fixed(StringView sv, char delim, StringView* fields, size_t capacity) {
+    if (capacity == 0 || sv.len == 0) return 0;
+    // A max_splits of 0 would mean no limit
+    if (capacity == 1) {
+        fields[0] = sv;
+        return 1;
+    }
+
+    SvSplitIter iter = sv_split_iter_init(sv, delim);
+    iter.max_splits = capacity - 1;
+
+    size_t count = 0;
+    while (count < capacity && sv_split_iter_next(&iter, &fields[count])) count++;
+    return count;
+}
+
+StringSplit sv_split_any(StringView sv, const SvDelims* delims) {
+    StringSplit split = {};
+    sv_split_any_append(&split, sv, delims);
+    return split;
+}
+
+void sv_split_any_append(StringSplit* split, StringView sv, const SvDelims* delims) {
+    while (sv.len > 0) {
+        split_append(split, sv_chop_by_any(&sv, delims));
+    }
+}
+
+StringView sv_chop_by_pred(StringView* sv, sv_predicate_t pred) {
+    StringView out = { NULL, 0 };
+
+    for (size_t i = 0; i < sv->len; ++i) {
+        if (pred(sv->start[i])) {
+            const char* frag_end = &sv->start[i + 1]; 
+
+            out.start = sv->start;
+            out.len = frag_end - sv->start;
+
+            sv->start = frag_end;
+            sv->len = sv->len - i - 1;
+
+            break;
+        }
+    }
+    
+    if (out.start == NULL) {
+        out.start = sv->start;
+        out.len = sv->len;
+
+        sv->start = &sv->start[sv->len - 1];
+        sv->len = 0;
+    }
+
+    return out;
+}
+
+StringView sv_trim_left_pred(StringView sv, sv_predicate_t pred) {
+    while (pred(sv.start[0])) {
+        ++sv.start;
+        --sv.len;
+    }
+
+    return sv;
+}
+
+StringView sv_trim_right_pred(StringView sv, sv_predicate_t pred) {
+    while (pred(sv.start[sv.len - 1])) {
+        --sv.len;
+    }
+
+    return sv;
+}
+
+StringView sv_trim_pred(StringView sv, sv_predicate_t pred) {
+    return sv_trim_left_pred(sv_trim_right_pred(sv, pred), pred);
+}
+
+StringSplit sv_split_pred(StringView sv, sv_predicate_t pred) {
+    StringSplit split = {};   
+    sv_split_pred_append(&split, sv, pred);
+    return split;
+}
+
+void sv_split_pred_append(StringSplit* split, StringView sv, sv_predicate_t pred) {
+    while (sv.len > 0) {
+        split_append(split, sv_chop_by_pred(&sv, pred));
+    }
+}
+
+void sv_split_free(StringSplit* split) {
+    if (split->allocator != NULL) {
+        if (split->items != NULL) allocator_free(split->allocator, split->items, sizeof(*split->items) * split->capacity);
+    } else {
+        free(split->items);
+    }
+    split->items = NULL;
+    split->count = 0;
+    split->capacity = 0;
+}
+
+bool sv_cmpc(StringView sv, const char* cstr) {
+    if (sv.len != strlen(cstr)) return false;
+
+    for (size_t i = 0; i < sv.len; ++i) {
+        if (sv.start[i] != cstr[i]) return false;
+    }
+
+    return true;
+}
+
+bool sv_cmpsv(StringView sv, StringView that) {
+    if (sv.len != that.len) return false;
+
+    for (size_t i = 0; i < sv.len; ++i) {
+        if (sv.start[i] != that.start[i]) return false;
+    }
+
+    return true;
+}
+
+bool sv_ends_with(StringView self, StringView suffix) {
+    if (self.len < suffix.len) return false;
+
+    return strncmp(self.start + self.len - suffix.len, suffix.start, suffix.len) == 0;
+}
+
+char* sv_to_cstr(StringView sv) {
+    char* buf = SV_MALLOC(sv.len + 1);
+    memcpy(buf, sv.start, sv.len);
+    buf[sv.len] = 0;
+    return buf;
+}
+
+char* sv_to_cstr_inplace(StringView sv, char buf[sv.len + 1]) {
+    memcpy(buf, sv.start, sv.len);
+    buf[sv.len] = 0;
+    return buf;
+}
+
+
+#endif // STRING_VIEW_IMPLEMENTATION
+#ifndef HASHMAP_H_
+#define HASHMAP_H_
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
+#ifndef STRING_VIEW_H_
+#include "string_view.h"
+#endif // STRING_VIEW_H_
+
+// Open-addressing hash maps generated for a key and value type:
+//
+//     HASHMAP_DECLARE(Symbols, symbols, StringView, int)   // in a header
+//     HASHMAP_IMPLEMENT(Symbols, symbols, StringView, int, hashmap_hash_sv, hashmap_eq_sv)
+//
+// Every slot has a control byte, either HASHMAP_EMPTY or 7 bits of the key's
+// hash. Lookups compare 16 control bytes at once and only look at the keys
+// whose bits match. Probing is linear, and removing shifts the rest of the
+// cluster back, so there are no tombstones and lookups never slow down.
+// Iterating goes in slot order, which stays the same until the map is changed.
+
+#define HASHMAP_EMPTY 0x80
+#define HASHMAP_GROUP 16
+
+// Grows past this share of occupied slots, out of 8
+#ifndef HASHMAP_MAX_LOAD
+#define HASHMAP_MAX_LOAD 7
+#endif // HASHMAP_MAX_LOAD
+
+static inline uint64_t hashmap_hash_u64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline uint64_t hashmap_hash_bytes(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ size;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < size; ++i, shift += 8) tail |= (uint64_t)bytes[i] << shift;
+    return hashmap_hash_u64(hash ^ tail);
+}
+
+static inline bool hashmap_eq_u64(uint64_t a, uint64_t b) {
+    return a == b;
+}
+
+static inline uint64_t hashmap_hash_sv(StringView sv) {
+    return hashmap_hash_bytes(sv.start, sv.len);
+}
+
+static inline bool hashmap_eq_sv(StringView a, StringView b) {
+    return a.len == b.len && (a.len == 0 || memcmp(a.start, b.start, a.len) == 0);
+}
+
+// Bit I is set when the control byte at I is BYTE, EMPTY gets the empty slots
+static inline uint32_t hashmap__group(const uint8_t* ctrl, uint8_t byte, uint32_t* empty) {
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    *empty = (uint32_t)_mm_movemask_epi8(group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#else
+    uint32_t match = 0;
+    *empty = 0;
+    for (int i = 0; i < HASHMAP_GROUP; ++i) {
+        match |= (uint32_t)(ctrl[i] == byte) << i;
+        *empty |= (uint32_t)(ctrl[i] == HASHMAP_EMPTY) << i;
+    }
+    return match;
+#endif // __SSE2__
+}
+
+// The first group is mirrored past the end, so a group can be loaded from any slot
+static inline void hashmap__set_ctrl(uint8_t* ctrl, size_t capacity, size_t i, uint8_t byte) {
+    ctrl[i] = byte;
+    if (i < HASHMAP_GROUP) ctrl[capacity + i] = byte;
+}
+
+// Declares Name, NameEntry and the prefix_ functions
+#define HASHMAP_DECLARE(Name, prefix, Key, Value) \
+typedef struct { \
+    Key key; \
+    Value value; \
+}Name##Entry; \
+\
+typedef struct { \
+    Name##Entry* entries; \
+    /* capacity + HASHMAP_GROUP control bytes, right after the entries */ \
+    uint8_t* ctrl; \
+    size_t count, capacity; \
+    /* NULL means malloc/free */ \
+    const Allocator* allocator; \
+}Name; \
+\
+/* Returns NULL if KEY isn't in the map */ \
+Value* prefix##_get(Name* self, Key key); \
+/* Inserts KEY or overwrites its value, returns where the value lives until the map changes */ \
+Value* prefix##_put(Name* self, Key key, Value value); \
+bool prefix##_remove(Name* self, Key key); \
+/* Makes room for COUNT keys in total */ \
+void prefix##_reserve(Name* self, size_t count); \
+void prefix##_clear(Name* self); \
+void prefix##_free(Name* self); \
+/* Walks the entries in slot order, start ITER at 0. Returns NULL at the end */ \
+Name##Entry* prefix##_next(Name* self, size_t* iter);
+
+#define HASHMAP_IMPLEMENT(Name, prefix, Key, Value, hash_fn, eq_fn) \
+static size_t prefix##__block_size(size_t capacity) { \
+    return capacity * sizeof(Name##Entry) + capacity + HASHMAP_GROUP; \
+} \
+\
+/* Slot of KEY, or SIZE_MAX with the empty slot it would go in in HOLE */ \
+static size_t prefix##__find(Name* self, Key key, uint64_t hash, size_t* hole) { \
+    size_t mask = self->capacity - 1; \
+    uint8_t h2 = hash & 0x7f; \
+    size_t pos = (hash >> 7) & mask; \
+\
+    while (true) { \
+        uint32_t empty; \
+        uint32_t match = hashmap__group(self->ctrl + pos, h2, &empty); \
+        /* Slots past the first empty one belong to another cluster */ \
+        if (empty != 0) match &= (empty & -empty) - 1; \
+\
+        while (match != 0) { \
+            size_t i = (pos + __builtin_ctz(match)) & mask; \
+            if (eq_fn(self->entries[i].key, key)) return i; \
+            match &= match - 1; \
+        } \
+\
+        if (empty != 0) { \
+            *hole = (pos + __builtin_ctz(empty)) & mask; \
+            return SIZE_MAX; \
+        } \
+        pos = (pos + HASHMAP_GROUP) & mask; \
+    } \
+} \
+\
+static void prefix##__resize(Name* self, size_t capacity) { \
+    size_t size = prefix##__block_size(capacity); \
+    char* block = self->allocator != NULL ? (char*)allocator_alloc(self->allocator, size) : (char*)malloc(size); \
+    assert(block != NULL); \
+\
+    Name old = *self; \
+    self->entries = (Name##Entry*)block; \
+    self->ctrl = (uint8_t*)(block + capacity * sizeof(Name##Entry)); \
+    self->capacity = capacity; \
+    memset(self->ctrl, HASHMAP_EMPTY, capacity + HASHMAP_GROUP); \
+\
+    /* The keys are known to be distinct, so only an empty slot is needed */ \
+    size_t mask = capacity - 1; \
+    for (size_t i = 0; i < old.capacity; ++i) { \
+        if (old.ctrl[i] & HASHMAP_EMPTY) continue; \
+\
+        uint64_t hash = hash_fn(old.entries[i].key); \
+        size_t pos = (hash >> 7) & mask; \
+        uint32_t empty; \
+        while (hashmap__group(self->ctrl + pos, 0, &empty), empty == 0) pos = (pos + HASHMAP_GROUP) & mask; \
+\
+        size_t slot = (pos + __builtin_ctz(empty)) & mask; \
+        self->entries[slot] = old.entries[i]; \
+        hashmap__set_ctrl(self->ctrl, capacity, slot, hash & 0x7f); \
+    } \
+\
+    if (old.entries != NULL) { \
+        if (self->allocator != NULL) allocator_free(self->allocator, old.entries, prefix##__block_size(old.capacity)); \
+        else free(old.entries); \
+    } \
+} \
+\
+Value* prefix##_get(Name* self, Key key) { \
+    if (self->count == 0) return NULL; \
+\
+    size_t hole; \
+    size_t i = prefix##__find(self, key, hash_fn(key), &hole); \
+    return i == SIZE_MAX ? NULL : &self->entries[i].value; \
+} \
+\
+Value* prefix##_put(Name* self, Key key, Value value) { \
+    if (self->capacity == 0) prefix##__resize(self, HASHMAP_GROUP); \
+\
+    uint64_t hash = hash_fn(key); \
+    size_t hole; \
+    size_t i = prefix##__find(self, key, hash, &hole); \
+    if (i != SIZE_MAX) { \
+        self->entries[i].value = value; \
+        return &self->entries[i].value; \
+    } \
+\
+    if ((self->count + 1) * 8 > self->capacity * HASHMAP_MAX_LOAD) { \
+        prefix##__resize(self, self->capacity * 2); \
+        prefix##__find(self, key, hash, &hole); \
+    } \
+\
+    self->entries[hole].key = key; \
+    self->entries[hole].value = value; \
+    hashmap__set_ctrl(self->ctrl, self->capacity, hole, hash & 0x7f); \
+    self->count++; \
+    return &self->entries[hole].value; \
+} \
+\
+bool prefix##_remove(Name* self, Key key) { \
+    if (self->count == 0) return false; \
+\
+    size_t hole; \
+    size_t i = prefix##__find(self, key, hash_fn(key), &hole); \
+    if (i == SIZE_MAX) return false; \
+\
+    /* Moves every later entry of the cluster that may live in the hole into it */ \
+    size_t mask = self->capacity - 1; \
+    hole = i; \
+    for (size_t j = (i + 1) & mask; !(self->ctrl[j] & HASHMAP_EMPTY); j = (j + 1) & mask) { \
+        size_t home = (hash_fn(self->entries[j].key) >> 7) & mask; \
+        if (((j - home) & mask) >= ((j - hole) & mask)) { \
+            self->entries[hole] = self->entries[j]; \
+            hashmap__set_ctrl(self->ctrl, self->capacity, hole, self->ctrl[j]); \
+            hole = j; \
+        } \
+    } \
+\
+    hashmap__set_ctrl(self->ctrl, self->capacity, hole, HASHMAP_EMPTY); \
+    self->count--; \
+    return true; \
+} \
+\
+void prefix##_reserve(Name* self, size_t count) { \
+    size_t capacity = HASHMAP_GROUP; \
+    while (count * 8 > capacity * HASHMAP_MAX_LOAD) capacity *= 2; \
+    if (capacity > self->capacity) prefix##__resize(self, capacity); \
+} \
+\
+void prefix##_clear(Name* self) { \
+    if (self->ctrl != NULL) memset(self->ctrl, HASHMAP_EMPTY, self->capacity + HASHMAP_GROUP); \
+    self->count = 0; \
+} \
+\
+void prefix##_free(Name* self) { \
+    if (self->entries != NULL) { \
+        if (self->allocator != NULL) allocator_free(self->allocator, self->entries, prefix##__block_size(self->capacity)); \
+        else free(self->entries); \
+    } \
+    self->entries = NULL; \
+    self->ctrl = NULL; \
+    self->count = 0; \
+    self->capacity = 0; \
+} \
+\
+Name##Entry* prefix##_next(Name* self, size_t* iter) { \
+    while (*iter < self->capacity) { \
+        size_t i = (*iter)++; \
+        if (!(self->ctrl[i] & HASHMAP_EMPTY)) return &self->entries[i]; \
+    } \
+    return NULL; \
+}
+
+#endif // HASHMAP_H_
+#ifndef INTERN_H_
+#define INTERN_H_
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef ARENA_H_
+#include "arena.h"
+#endif // ARENA_H_
+
+#ifndef DAH_H_
+#include "dah.h"
+#endif // DAH_H_
+
+#ifndef HASHMAP_H_
+#include "hashmap.h"
+#endif // HASHMAP_H_
+
+// A small number standing for an interned string, 0 is no string
+typedef uint32_t Atom;
+#define ATOM_NONE 0
+
+HASHMAP_DECLARE(InternMap, intern__map, StringView, Atom)
+
+// Keeps one copy of every distinct string in an arena. Interned strings with
+// the same contents share their atom and their pointer, so comparing them is
+// an integer or pointer compare. The copies are NUL terminated.
+typedef struct {
+    Arena arena;
+    InternMap map;
+    // Canonical view of every atom, at the atom's index minus 1
+    StringView* strings;
+    bool frozen;
+}Interner;
+
+// Returns the atom of SV, copying it in first if it's new.
+// A frozen interner doesn't take new strings, so it returns ATOM_NONE for them
+Atom intern_atom(Interner* self, StringView sv);
+// Returns the canonical view of SV, which can be compared by its start pointer.
+// An empty view with a NULL start if SV is new and the interner is frozen
+StringView intern(Interner* self, StringView sv);
+#define intern_cstr(interner, cstr) intern(interner, sv_from_cstr(cstr))
+// Returns ATOM_NONE if SV was never interned, never inserts
+Atom intern_find(Interner* self, StringView sv);
+StringView intern_str(Interner* self, Atom atom);
+#define intern_count(interner) dah_getlen((interner)->strings)
+// Points every piece of SPLIT at its canonical copy, and stores their atoms in ATOMS if it isn't NULL.
+// Once frozen, new pieces are left alone and get ATOM_NONE
+void intern_split(Interner* self, StringSplit* split, Atom* atoms);
+// Stops interning new strings. intern_find and intern_str only read from then
+// on, so any number of threads can call them without locking, once they know
+// the interner is frozen: either intern_is_frozen returned true on that thread,
+// or the thread was handed the interner after intern_freeze some other
+// synchronizing way (a mutex, pthread_create, a queue)
+void intern_freeze(Interner* self);
+bool intern_is_frozen(Interner* self);
+void intern_free(Interner* self);
+
+#endif // INTERN_H_
+
+#ifdef INTERN_IMPLEMENTATION
+#undef INTERN_IMPLEMENTATION
+
+#include <string.h>
+#include <assert.h>
+
+HASHMAP_IMPLEMENT(InternMap, intern__map, StringView, Atom, hashmap_hash_sv, hashmap_eq_sv)
+
+Atom intern_find(Interner* self, StringView sv) {
+    Atom* atom = intern__map_get(&self->map, sv);
+    return atom == NULL ? ATOM_NONE : *atom;
+}
+
+Atom intern_atom(Interner* self, StringView sv) {
+    if (intern_is_frozen(self)) return intern_find(self, sv);
+
+    Atom atom = intern_find(self, sv);
+    if (atom != ATOM_NONE) return atom;
+
+    char* copy = arena_alloc(&self->arena, sv.len + 1);
+    if (sv.len > 0) memcpy(copy, sv.start, sv.len);
+    copy[sv.len] = 0;
+
+    StringView canonical = {copy, sv.len};
+    dah_append(self->strings, canonical);
+    atom = (Atom)dah_getlen(self->strings);
+    intern__map_put(&self->map, canonical, atom);
+    return atom;
+}
+
+StringView intern(Interner* self, StringView sv) {
+    Atom atom = intern_atom(self, sv);
+    if (atom == ATOM_NONE) {
+        StringView none = {0};
+        return none;
+    }
+    return intern_str(self, atom);
+}
+
+StringView intern_str(Interner* self, Atom atom) {
+    assert(atom != ATOM_NONE && atom <= dah_getlen(self->strings));
+    return self->strings[atom - 1];
+}
+
+void intern_split(Interner* self, StringSplit* split, Atom* atoms) {
+    for (size_t i = 0; i < split->count; ++i) {
+        Atom atom = intern_atom(self, split->items[i]);
+        if (atom != ATOM_NONE) split->items[i] = self->strings[atom - 1];
+        if (atoms != NULL) atoms[i] = atom;
+    }
+}
+
+void intern_freeze(Interner* self) {
+    // Pairs with the acquire in intern_is_frozen, so a reader that sees the
+    // flag also sees every string and map entry written before it
+    __atomic_store_n(&self->frozen, true, __ATOMIC_RELEASE);
+}
+
+bool intern_is_frozen(Interner* self) {
+    return __atomic_load_n(&self->frozen, __ATOMIC_ACQUIRE);
+}
+
+void intern_free(Interner* self) {
+    intern__map_free(&self->map);
+    dah_free(self->strings);
+    arena_free(&self->arena);
+    self->frozen = false;
+}
+
+#endif // INTERN_IMPLEMENTATION
+#ifndef TSPRINTF_H_
+#define TSPRINTF_H_
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <assert.h>
+
+// Rewinds tbuffer_alive remembers per pass over the buffer. Past that, the
+// oldest ones are forgotten and strings they killed may still pass as alive
+#ifndef TBUFFER_REWINDS
+#define TBUFFER_REWINDS 8
+#endif // TBUFFER_REWINDS
+
+// A circular buffer for temporary strings. Once the end is reached it wraps
+// around and overwrites the oldest strings.
+typedef struct {
+    char* data;
+    size_t capacity;
+    size_t size;
+    // Bumped every time strings can die: on wraps, resets and rewinds
+    size_t generation;
+    // Generations the current and the previous pass over the buffer started at
+    size_t pass_start, prev_pass_start;
+    // Furthest the current pass has written, and where the previous one ended
+    size_t high, prev_end;
+    // Rewinds of the current pass, each the lowest one since its generation.
+    // Oldest first, so both generations and sizes go up
+    struct {
+        size_t generation, size;
+    } rewinds[TBUFFER_REWINDS];
+    size_t rewind_count;
+}TBuffer;
+
+TBuffer tbuffer_new(char* data, size_t capacity);
+#define tbuffer_from_array(array) tbuffer_new(array, sizeof(array))
+
+// Formats straight into the free space and only formats again if it had to wrap.
+// Returns NULL if the string doesn't fit in the whole buffer.
+__attribute__((format(printf, 2, 3)))
+char* tbuffer_sprintf(TBuffer* self, const char* fmt, ...);
+char* tbuffer_vsprintf(TBuffer* self, const char* fmt, va_list args);
+
+void tbuffer_rewind(TBuffer* self, size_t snapshot);
+void tbuffer_reset(TBuffer* self);
+
+// Whether STR hasn't been overwritten, rewound past or reset yet. GENERATION is
+// the buffer's generation right after STR was returned. Never reports a live
+// string as dead, but can miss rewinds from before the last wrap
+bool tbuffer_alive(TBuffer* self, const char* str, size_t generation);
+
+// tsprintf and friends use a TBuffer of TBUFFER_SIZE bytes per thread
+__attribute__((format(printf, 1, 2)))
+char* tsprintf(const char* fmt, ...);
+size_t tsnapshot();
+void trewind(size_t snapshot);
+void treset();
+TBuffer* tbuffer_thread();
+#define tgeneration() (tbuffer_thread()->generation)
+
+// Catches strings used after the buffer wrapped over them or was rewound past
+// them, in debug builds
+#ifndef NDEBUG
+#define tassert_alive(str, generation) assert(tbuffer_alive(tbuffer_thread(), str, generation))
+#else
+#define tassert_alive(str, generation) ((void)0)
+#endif // NDEBUG
+
+#endif // TSPRINTF_H_
+
+#ifdef TSPRINTF_IMPLEMENTATION
+#undef TSPRINTF_IMPLEMENTATION
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef TBUFFER_SIZE
+#define TBUFFER_SIZE (1 << 10)
+#endif // TBUFFER_SIZE
+
+TBuffer tbuffer_new(char* data, size_t capacity) {
+    TBuffer buf = {0};
+    buf.data = data;
+    buf.capacity = capacity;
+    return buf;
+}
+
+// Starts a pass over the buffer, the strings of the previous one that are still
+// around live between where the new pass has written and END
+static void tbuffer__new_pass(TBuffer* self, size_t end) {
+    self->generation++;
+    self->prev_pass_start = self->pass_start;
+    self->pass_start = self->generation;
+    self->prev_end = end;
+    self->high = 0;
+    self->size = 0;
+    self->rewind_count = 0;
+}
+
+char* tbuffer_vsprintf(TBuffer* self, const char* fmt, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+
+    char* start = self->data + self->size;
+    size_t room = self->capacity - self->size;
+    int n = vsnprintf(start, room, fmt, copy);
+    va_end(copy);
+
+    if (n < 0) return NULL;
+    if ((size_t)n < room) {
+        self->size += n + 1;
+        if (self->size > self->high) self->high = self->size;
+        return start;
+    }
+
+    if ((size_t)n + 1 > self->capacity) return NULL;
+
+    tbuffer__new_pass(self, self->size);
+    start = self->data;
+    vsnprintf(start, n + 1, fmt, args);
+    self->size = n + 1;
+    self->high = n + 1;
+    return start;
+}
+
+char* tbuffer_sprintf(TBuffer* self, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char* str = tbuffer_vsprintf(self, fmt, args);
+    va_end(args);
+    return str;
+}
+
+void tbuffer_rewind(TBuffer* self, size_t snapshot) {
+    assert(snapshot <= self->capacity);
+    if (snapshot >= self->size) {
+        self->size = snapshot;
+        return;
+    }
+
+    // Later rewinds that go as low make the ones before them redundant
+    self->generation++;
+    while (self->rewind_count > 0 && self->rewinds[self->rewind_count - 1].size >= snapshot) {
+        self->rewind_count--;
+    }
+    if (self->rewind_count == TBUFFER_REWINDS) {
+        memmove(self->rewinds, self->rewinds + 1, (TBUFFER_REWINDS - 1) * sizeof(self->rewinds[0]));
+        self->rewind_count--;
+    }
+    self->rewinds[self->rewind_count].generation = self->generation;
+    self->rewinds[self->rewind_count].size = snapshot;
+    self->rewind_count++;
+    self->size = snapshot;
+}
+
+void tbuffer_reset(TBuffer* self) {
+    tbuffer__new_pass(self, 0);
+}
+
+bool tbuffer_alive(TBuffer* self, const char* str, size_t generation) {
+    if (str < self->data || str >= self->data + self->capacity) return false;
+    if (generation > self->generation) return false;
+
+    size_t offset = str - self->data;
+    if (generation >= self->pass_start) {
+        if (offset >= self->size) return false;
+        // The first rewind since GENERATION is the lowest one
+        for (size_t i = 0; i < self->rewind_count; ++i) {
+            if (self->rewinds[i].generation > generation) return offset < self->rewinds[i].size;
+        }
+        return true;
+    }
+
+    // The previous pass lives on past what the current one has written
+    if (generation >= self->prev_pass_start) return offset >= self->high && offset < self->prev_end;
+    return false;
+}
+
+// Every thread formats into its own buffer
+static _Thread_local char tbuffer_data[TBUFFER_SIZE] = {0};
+static _Thread_local TBuffer tbuffer = {0};
+
+TBuffer* tbuffer_thread() {
+    // The address of a thread local isn't a constant, so it can't be a static initializer
+    if (tbuffer.data == NULL) tbuffer = tbuffer_new(tbuffer_data, TBUFFER_SIZE);
+    return &tbuffer;
+}
+
+char* tsprintf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char* str = tbuffer_vsprintf(tbuffer_thread(), fmt, args);
+    va_end(args);
+    return str;
+}
+
+size_t tsnapshot() {
+    return tbuffer_thread()->size;
+}
+
+void trewind(size_t snapshot) {
+    tbuffer_rewind(tbuffer_thread(), snapshot);
+}
+
+void treset() {
+    tbuffer_reset(tbuffer_thread());
+}
+
+#endif // TSPRINTF_IMPLEMENTATION
+#ifndef TYPES_H_
+#define TYPES_H_
+#include <stdio.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef unsigned __int128 u128;
+
+typedef int8_t i8;
+typedef int16_t i16;
+typedef int32_t i32;
+typedef int64_t i64;
+typedef __int128 i128;
+
+typedef float f32;
+typedef double f64;
+
+typedef char* cstr;
+
+typedef FILE* Fp;
+typedef void* rawp;
+
+#endif // TYPES_H_
+
+#ifndef UTILS_H_
+#define UTILS_H_
+#include <stdbool.h>
+
+#ifndef MACROS_ABORT
+#include <stdlib.h>
+#define MACROS_ABORT abort
+#endif // MACROS_ABORT
+
+#define eprintf(...) fprintf(stderr, __VA_ARGS__)
+#define PANIC(...) do { eprintf(__VA_ARGS__); MACROS_ABORT(); } while (0)
+
+#define TODO() PANIC("%s:%d: TODO: %s not implemented yet\n", __FILE__, __LINE__, __func__)
+#define TODOO(thing) PANIC("%s:%d: TODO: %s not implemented yet\n", __FILE__, __LINE__, #thing)
+
+#define UNIMPLEMENTED() PANIC("%s:%d: UNIMPLEMENTED: %s not implemented\n", __FILE__, __LINE__, __func__)
+#define UUNIMPLEMENTED(thing) PANIC("%s:%d: UNIMPLEMENTED: %s not implemented\n", __FILE__, __LINE__, #thing)
+
+#define UNREACHABLE() PANIC("%s:%d: UNREACHABLE\n", __FILE__, __LINE__)
+
+#define ARRAY_LEN(arr) (sizeof(arr)/sizeof((arr)[0]))
+
+#define return_defer(thing) do { result = thing; goto defer; } while (0)
+#define gcc_format_attr(last_pos, start_va) __attribute__((format(printf, last_pos, start_va)))
+
+#include <signal.h>
+#define BREAKPOINT() do { eprintf("%s:%d: BREAKPOINT", __FILE__, __LINE__); raise(SIGINT); } while (0)
+#define BREAKPOINT_IF() do { if (expr) { eprintf("%s:%d: BREAKPOINT", __FILE__, __LINE__); raise(SIGINT); } } while (0)
+
+bool dynlib_load(void** handle, const char* path, int mode);
+bool dynsym_load(void** sym, void* handle, const char* name);
+
+#define simple_log_info(...) do { printf("[INFO] "); printf(__VA_ARGS__); } while (0)
+#define simple_log_warn(...) do { printf("[WARNING] "); printf(__VA_ARGS__); } while (0)
+#define simple_log_err(...) do { printf("[ERROR] "); printf(__VA_ARGS__); } while (0)
+#define simple_flog_info(f, ...) do { fprintf(f, "[INFO] "); fprintf(f, __VA_ARGS__); } while (0)
+#define simple_flog_warn(f, ...) do { fprintf(f, "[WARNING] "); fprintf(f, __VA_ARGS__); } while (0)
+#define simple_flog_err(f, ...) do { fprintf(f, "[ERROR] "); fprintf(f, __VA_ARGS__); } while (0)
+
+#endif // UTILS_H_
+
+#ifdef UTILS_IMPLEMENTATION
+#undef UTILS_IMPLEMENTATION
+
+#include <dlfcn.h>
+#include <stdio.h>
+
+bool dynlib_load(void** handle, const char* path, int mode) {
+    if (*handle != NULL)
+        dlclose(*handle);
+
+    *handle = dlopen(path, mode);
+    if (*handle == NULL) {
+        fprintf(stderr, "%s: %s\n", __func__, dlerror());
+        return false;
+    }
+
+    return true;
+}
+
+bool dynsym_load(void** sym, void* handle, const char* name) {
+    *sym = dlsym(handle, name);
+    if (*sym == NULL) {
+        fprintf(stderr, "%s: %s\n", __func__, dlerror());
+        return false;
+    }
+
+    return true;
+}
+
+#endif // UTILS_IMPLEMENTATION
+#ifndef MEASURE_H_
+#define MEASURE_H_
+#include <stdio.h>
+
+double get_now();
+
+void measures_free();
+
+void measure_begin(const char* name);
+void measure_end_with_loc(const char* name, const char* file, int line);
+#define measure_end(name) measure_end_with_loc(name, __FILE__, __LINE__)
+void measures_dump(FILE* sink);
+#define mesaures_print() measures_dump(stdout)
+
+#define MEASURE(name) measure_begin(name)
+#define MEASURE_END(name) measure_end(name)
+
+typedef struct {
+    double* items;
+    size_t count;
+    size_t capacity;
+}Measurements;
+
+typedef struct {
+    double start;
+    const char* name;
+    Measurements ms;
+}Measure;
+
+
+#endif // MEASURE_H_
+#ifdef MEASURE_IMPLEMENTATION
+#undef MEASURE_IMPLEMENTATION
+
+double get_now() {
+    struct timespec ts;
+    assert(clock_gettime(CLOCK_REALTIME, &ts) == 0);
+    return ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+#define UNIQUE_MEASURES_SIZE 1024
+Measure measures[UNIQUE_MEASURES_SIZE] = {0};
+size_t measures_count = 0;
+
+void measurements_push(Measurements* ms, double t) {
+    if (ms->count == ms->capacity) {
+        if (ms->capacity == 0) ms->capacity = 4;
+        ms->capacity *= 2;
+        ms->items = realloc(ms->items, ms->capacity * sizeof(double));
+    }
+    ms->items[ms->count++] = t;
+}
+
+void measurements_free(Measurements* ms) {
+    free(ms->items);
+    ms->items = NULL;
+    ms->count = 0;
+    ms->capacity = 0;
+}
+
+size_t measures_push(const char* name) {
+    assert(measures_count < UNIQUE_MEASURES_SIZE);
+    size_t i = measures_count++;
+    measures[i].name = name;
+    return i;
+}
+
+bool measures_find(const char* name, size_t* out) {
+    for (size_t i = 0; i < measures_count; ++i) {
+        if (strcmp(measures[i].name, name) == 0) {
+            *out = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void measures_free() {
+    for (size_t i = 0; i < measures_count; ++i) {
+        measurements_free(&measures[i].ms);
+    }
+    memset(measures, 0, measures_count * sizeof(measures[0]));
+    measures_count = 0;
+}
+
+double measuresments_average(Measurements* ms) {
+    assert(ms->count > 0);
+    double avg = 0;
+    for (size_t i = 0; i < ms->count; ++i) {
+        avg += ms->items[i];
+    }
+    return avg / ms->count;
+}
+
+void measures_dump(FILE* sink) {
+    for (size_t i = 0; i < measures_count; ++i) {
+        Measure* m = &measures[i];
+        printf("%s: Average: %lfs\n", m->name, measuresments_average(&m->ms));
+        for (size_t i = 0; i < m->ms.count; ++i) {
+            fprintf(sink, "    %ld. mesaurement: %lfs\n", i + 1, m->ms.items[i]);
+        }
+    }
+}
+
+void measure_begin(const char* name) {
+    size_t i;
+    if (!measures_find(name, &i)) {
+        i = measures_push(name);
+    }
+    measures[i].start = get_now();
+}
+
+void measure_end_with_loc(const char* name, const char* file, int line) {
+    size_t i;
+    if (!measures_find(name, &i)) {
+        fprintf(stderr, "%s:%d: Couldn't find measurement %s\n", file, line, name);
+        return;
+    }
+    double t = get_now() - measures[i].start;
+    measurements_push(&measures[i].ms, t);
+}
+
+#endif // MEASURE_IMPLEMENTATION
+#ifndef LOGGER_H_
+#define LOGGER_H_
+#include <stdio.h>
+
+typedef enum LogLevel {
+	LOG_INFO,
+	LOG_WARN,
+	LOG_ERROR,
+
+	LOG_COUNT_
+}LogLevel;
+
+typedef struct Logger {
+	FILE* f;
+	LogLevel level;
+}Logger;
+
+void log_log(Logger* self, LogLevel level, const char* fmt, ...);
+#define log_info(logger, ...) log_log(logger, LOG_INFO, __VA_ARGS__)
+#define log_warn(logger, ...) log_log(logger, LOG_WARN, __VA_ARGS__)
+#define log_error(logger, ...) log_log(logger, LOG_ERROR, __VA_ARGS__)
+
+extern Logger global_logger;
+void log_init_global(FILE* f, LogLevel level);
+#define log_log_global(level, ...) log_log(&global_logger, level, __VA_ARGS__)
+#define log_info_global(...) log_log(&global_logger, LOG_INFO, __VA_ARGS__)
+#define log_warn_global(...) log_log(&global_logger, LOG_WARN, __VA_ARGS__)
+#define log_error_global(...) log_log(&global_logger, LOG_ERROR, __VA_ARGS__)
+
+#endif // LOGGER_H_
+
+#ifdef LOGGER_IMPLEMENTATION
+#undef LOGGER_IMPLEMENTATION
+#include <stdarg.h>
+
+#define log__static_assert _Static_assert
+
+log__static_assert(LOG_COUNT_ == 3, "Log level was added");
+static const char* loglevel_to_str[LOG_COUNT_] = {
+	[LOG_INFO] = "INFO",
+	[LOG_WARN] = "WARN",
+	[LOG_ERROR] = "ERROR",
+};
+static const char* loglevel_to_color[LOG_COUNT_] = {
+	[LOG_INFO] = "\x1B[34m",
+	[LOG_WARN] = "\x1B[33m",
+	[LOG_ERROR] = "\x1B[31m",
+};
+
+Logger global_logger;
+
+void log_init_global(FILE* f, LogLevel level) {
+	global_logger.f = f;
+	global_logger.level = level;
+}
+
+__attribute__((format(printf, 3, 4)))
+void log_log(Logger* self, LogLevel level, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+
+	if (self->level <= level) {
+		fprintf(self->f, "[%s%s\x1B[0m] ", loglevel_to_color[level], loglevel_to_str[level]);
+		vfprintf(self->f, fmt, args);
+		fprintf(self->f, "\n");
+	}
+
+	va_end(args);
+}
+
+#endif // LOGGER_IMPLEMENTATION
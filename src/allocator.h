@@ -0,0 +1,83 @@
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// An allocator containers can carry instead of calling malloc/realloc/free.
+// Old sizes are passed along, so bump allocators can grow and pop in place.
+// The members aren't named after libc, so leak checkers that macro over realloc/free still work.
+typedef struct {
+    void* (*alloc)(void* ctx, size_t size);
+    void* (*resize)(void* ctx, void* ptr, size_t oldsize, size_t newsize);
+    void (*release)(void* ctx, void* ptr, size_t size);
+    void* ctx;
+}Allocator;
+
+#define allocator_alloc(a, size) (a)->alloc((a)->ctx, size)
+#define allocator_realloc(a, ptr, oldsize, newsize) (a)->resize((a)->ctx, ptr, oldsize, newsize)
+#define allocator_free(a, ptr, size) (a)->release((a)->ctx, ptr, size)
+
+// Everything below is static, so this header needs no implementation define
+
+static inline void* allocator__libc_alloc(void* ctx, size_t size) {
+    (void)ctx;
+    return malloc(size);
+}
+
+static inline void* allocator__libc_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    (void)ctx;
+    (void)oldsize;
+    return realloc(ptr, newsize);
+}
+
+static inline void allocator__libc_free(void* ctx, void* ptr, size_t size) {
+    (void)ctx;
+    (void)size;
+    free(ptr);
+}
+
+static const Allocator libc_allocator = {
+    allocator__libc_alloc,
+    allocator__libc_realloc,
+    allocator__libc_free,
+    NULL,
+};
+
+// Gives every allocation its own anonymous mapping, meant for buffers of many MB.
+// Growing remaps the pages with mremap instead of copying them when sys/mman.h
+// declares it, which glibc does with _GNU_SOURCE
+static inline void* allocator__mmap_alloc(void* ctx, size_t size) {
+    (void)ctx;
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+static inline void* allocator__mmap_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    (void)ctx;
+#ifdef MREMAP_MAYMOVE
+    void* moved = mremap(ptr, oldsize, newsize, MREMAP_MAYMOVE);
+    return moved == MAP_FAILED ? NULL : moved;
+#else
+    void* moved = allocator__mmap_alloc(ctx, newsize);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, oldsize < newsize ? oldsize : newsize);
+    munmap(ptr, oldsize);
+    return moved;
+#endif // MREMAP_MAYMOVE
+}
+
+static inline void allocator__mmap_free(void* ctx, void* ptr, size_t size) {
+    (void)ctx;
+    munmap(ptr, size);
+}
+
+static const Allocator mmap_allocator = {
+    allocator__mmap_alloc,
+    allocator__mmap_realloc,
+    allocator__mmap_free,
+    NULL,
+};
+
+#endif // ALLOCATOR_H_
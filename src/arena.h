@@ -2,11 +2,66 @@
 #define ARENA_H_
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
 
+// Size of the first region, in words
 #ifndef REGION_DEFAULT_SIZE
 #define REGION_DEFAULT_SIZE (1 << 10)
 #endif // REGION_DEFAULT_SIZE
 
+// Every new region doubles the size of the previous one, up to this size, in words
+#ifndef REGION_MAX_SIZE
+#define REGION_MAX_SIZE (1 << 18)
+#endif // REGION_MAX_SIZE
+
+// Allocations bigger than this get their own exactly sized region, in words
+#ifndef ARENA_LARGE_ALLOC_SIZE
+#define ARENA_LARGE_ALLOC_SIZE (REGION_MAX_SIZE / 4)
+#endif // ARENA_LARGE_ALLOC_SIZE
+
+#ifndef ARENA_CACHE_LINE
+#define ARENA_CACHE_LINE 64
+#endif // ARENA_CACHE_LINE
+
+// Granularity in which a virtual memory arena commits its reserved range, in bytes
+#ifndef ARENA_VM_COMMIT_SIZE
+#define ARENA_VM_COMMIT_SIZE (1 << 16)
+#endif // ARENA_VM_COMMIT_SIZE
+
+// Committed memory a virtual memory arena keeps on arena_reset/arena_jumpback, in bytes
+#ifndef ARENA_VM_RETAIN_SIZE
+#define ARENA_VM_RETAIN_SIZE (1 << 22)
+#endif // ARENA_VM_RETAIN_SIZE
+
+#ifndef ARENA_VM_HUGE_PAGE_SIZE
+#define ARENA_VM_HUGE_PAGE_SIZE (1 << 21)
+#endif // ARENA_VM_HUGE_PAGE_SIZE
+
+// Scratch arenas per thread, one more than the deepest chain of conflicts you pass
+#ifndef ARENA_SCRATCH_COUNT
+#define ARENA_SCRATCH_COUNT 2
+#endif // ARENA_SCRATCH_COUNT
+
+#ifdef ARENA_AUTO_TRIM
+// arena_reset averages the usage of the last this many resets, and trims to the average
+#ifndef ARENA_TRIM_DECAY
+#define ARENA_TRIM_DECAY 8
+#endif // ARENA_TRIM_DECAY
+#endif // ARENA_AUTO_TRIM
+
+#ifdef ARENA_REGION_CACHE
+// Bytes of freed regions kept around for other arenas of the process
+#ifndef ARENA_REGION_CACHE_SIZE
+#define ARENA_REGION_CACHE_SIZE (1 << 26)
+#endif // ARENA_REGION_CACHE_SIZE
+#endif // ARENA_REGION_CACHE
+
 #ifndef ARENA_MALLOC
 #include <stdlib.h>
 #define ARENA_MALLOC malloc
@@ -25,27 +80,123 @@ typedef struct arena_region_s {
     uintptr_t data[];
 }ArenaRegion;
 
+#define ARENA_VM (1 << 0)
+// Asks the kernel to back the arena with transparent huge pages
+#define ARENA_VM_HUGEPAGE (1 << 1)
+// Maps the arena from the hugetlbfs pool, falls back to regular pages if it's empty
+#define ARENA_VM_HUGETLB (1 << 2)
+
+#ifdef ARENA_STATS
+// Allocations are bucketed by the bit width of their size, the last bucket takes the rest
+#ifndef ARENA_STATS_CLASSES
+#define ARENA_STATS_CLASSES 32
+#endif // ARENA_STATS_CLASSES
+
+typedef struct {
+    // Bytes asked for by the caller
+    size_t requested;
+    // Bytes taken from regions, including rounding and alignment padding
+    size_t consumed;
+    // Bytes left unused at the end of regions the arena moved past
+    size_t tail_waste;
+    size_t regions;
+    size_t large_regions;
+    size_t in_use;
+    size_t peak;
+    size_t jumpbacks;
+    size_t resets;
+    size_t size_classes[ARENA_STATS_CLASSES];
+}ArenaStats;
+#endif // ARENA_STATS
+
 typedef struct {
     ArenaRegion *start, *end;
+    // Dedicated regions of large allocations, newest first
+    ArenaRegion* large;
+
+    // Non-zero for arenas set up by arena_init_vm
+    int vm_flags;
+    // Bytes of the reserved range that are backed by memory
+    size_t committed;
+
+#ifdef ARENA_AUTO_TRIM
+    // Decaying average of the bytes in use at arena_reset
+    size_t peak_avg;
+#endif // ARENA_AUTO_TRIM
+
+#ifdef ARENA_STATS
+    ArenaStats stats;
+#endif // ARENA_STATS
 }Arena;
 
 typedef struct {
     ArenaRegion* r;
     size_t count;
+    ArenaRegion* large;
 }ArenaMark;
 
+typedef struct {
+    Arena* arena;
+    ArenaMark mark;
+}ArenaScratch;
+
 void* arena_alloc(Arena* self, size_t size);
 #define arena_calloc(arena, size) memset(arena_alloc(arena, size), 0, size)
+// Allocates memory aligned to ALIGN, which must be a power of two
+void* arena_alloc_aligned(Arena* self, size_t size, size_t align);
+#define arena_calloc_aligned(arena, size, align) memset(arena_alloc_aligned(arena, size, align), 0, size)
+#define arena_alloc_type(arena, Type) ((Type*)arena_alloc_aligned(arena, sizeof(Type), _Alignof(Type)))
+#define arena_alloc_array(arena, n, Type) ((Type*)arena_alloc_aligned(arena, sizeof(Type) * (n), _Alignof(Type)))
+// Allocates whole cache lines, so the memory doesn't share a line with any other allocation
+#define arena_alloc_cacheline(arena, size) \
+    arena_alloc_aligned(arena, ((size) + ARENA_CACHE_LINE - 1) & ~(size_t)(ARENA_CACHE_LINE - 1), ARENA_CACHE_LINE)
+// Grows or shrinks PTR in place when it's the last allocation, otherwise copies it to new memory
 void* arena_realloc(Arena* self, size_t oldsize, size_t newsize, void* ptr);
+// Frees PTR if it's the last allocation. Returns false and does nothing otherwise
+bool arena_pop(Arena* self, void* ptr, size_t size);
 #define arena_memdup(arena, ptr, size) memcpy(arena_alloc(arena, size), ptr, size)
+// Formats straight into the free space of the current region, and only formats
+// again into a fresh region when the string didn't fit
+__attribute__((format(printf, 2, 3)))
 char* arena_sprintf(Arena* self, const char* fmt, ...);
+char* arena_vsprintf(Arena* self, const char* fmt, va_list args);
 char* arena_strdup(Arena* self, const char* cstr);
 char* arena_realpath(Arena* self, const char* path);
 
+// Reserves RESERVE bytes of address space as the only region of an unused arena.
+// Pages are committed as the arena grows, and given back past ARENA_VM_RETAIN_SIZE
+// on arena_reset/arena_jumpback. Allocations past the reservation return NULL.
+bool arena_init_vm(Arena* self, size_t reserve, int flags);
+
+// Allocator for containers that live on SELF. Freeing only reclaims the last allocation
+Allocator arena_allocator(Arena* self);
+
 ArenaMark arena_mark(Arena* self);
 void arena_jumpback(Arena* self, ArenaMark mark);
 void arena_reset(Arena* self);
 void arena_free(Arena* self);
+// Releases the unused regions once KEEP_BYTES of capacity are covered, or decommits
+// past them in virtual memory arenas. Returns the number of bytes released.
+// With ARENA_AUTO_TRIM, arena_reset trims to a decaying average of recent usage.
+size_t arena_trim(Arena* self, size_t keep_bytes);
+
+#ifdef ARENA_REGION_CACHE
+// Frees the regions the process-wide cache is holding on to
+void arena_region_cache_clear(void);
+#endif // ARENA_REGION_CACHE
+
+// Returns one of the calling thread's scratch arenas that isn't in CONFLICTS.
+// Pass the arenas your caller handed you, so temporaries never land in them.
+// Scratch arenas are freed when their thread exits.
+Arena* arena_scratch(Arena** conflicts, size_t conflicts_count);
+// Gets a scratch arena and marks it, for arena_scratch_end to jump back to
+ArenaScratch arena_scratch_begin(Arena** conflicts, size_t conflicts_count);
+#define arena_scratch_end(scratch) arena_jumpback((scratch).arena, (scratch).mark)
+
+#ifdef ARENA_STATS
+// Prints usage counters and a size class histogram of the allocations
+void arena_stats_dump(Arena* self, FILE* sink);
+#endif // ARENA_STATS
 
 #endif // ARENA_H_
 
@@ -53,64 +204,389 @@ void arena_free(Arena* self);
 #undef ARENA_IMPLEMENTATION
 
 #include <stdarg.h>
+#include <stdio.h>
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#ifdef ARENA_STATS
+#define ARENA__STAT(stmt) stmt
+
+static void arena__stats_alloc(Arena* self, size_t size, size_t words) {
+    ArenaStats* stats = &self->stats;
+    stats->requested += size;
+    stats->consumed += words * sizeof(uintptr_t);
+    stats->in_use += words * sizeof(uintptr_t);
+    if (stats->in_use > stats->peak) stats->peak = stats->in_use;
+
+    size_t class = 0;
+    while (class < ARENA_STATS_CLASSES - 1 && (size >> class) != 0) class++;
+    stats->size_classes[class]++;
+}
 
-void* arena_alloc(Arena* self, size_t size) {
-    if (self->end == NULL) {
-        self->end = ARENA_MALLOC(sizeof(*self->start) + REGION_DEFAULT_SIZE * sizeof(*self->start->data));
-        self->end->count = 0;
-        self->end->capacity = REGION_DEFAULT_SIZE;
-        self->end->next = NULL;
-        self->start = self->end;
+static void arena__stats_recount(Arena* self) {
+    size_t in_use = 0;
+    for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
+        in_use += r->count;
+        if (r == self->end) break;
+    }
+    for (ArenaRegion* r = self->large; r != NULL; r = r->next) {
+        in_use += r->count;
+    }
+    self->stats.in_use = in_use * sizeof(uintptr_t);
+}
+#else
+#define ARENA__STAT(stmt)
+#endif // ARENA_STATS
+
+#ifdef ARENA_REGION_CACHE
+// Regions of up to REGION_MAX_SIZE words are cached, large ones included, the
+// bigger large ones go straight back to ARENA_FREE
+static pthread_mutex_t arena__cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static ArenaRegion* arena__cache;
+static size_t arena__cache_bytes;
+
+// Takes a cached region of at least CAPACITY words, but no more than twice that
+static ArenaRegion* arena__cache_take(size_t capacity) {
+    if (capacity > REGION_MAX_SIZE) return NULL;
+
+    pthread_mutex_lock(&arena__cache_lock);
+    ArenaRegion** prev = &arena__cache;
+    ArenaRegion* r = arena__cache;
+    while (r != NULL && (r->capacity < capacity || r->capacity / 2 > capacity)) {
+        prev = &r->next;
+        r = r->next;
+    }
+    if (r != NULL) {
+        *prev = r->next;
+        arena__cache_bytes -= r->capacity * sizeof(uintptr_t);
+    }
+    pthread_mutex_unlock(&arena__cache_lock);
+    return r;
+}
+
+static bool arena__cache_give(ArenaRegion* r) {
+    if (r->capacity > REGION_MAX_SIZE) return false;
+
+    size_t bytes = r->capacity * sizeof(uintptr_t);
+    pthread_mutex_lock(&arena__cache_lock);
+    bool fits = arena__cache_bytes + bytes <= ARENA_REGION_CACHE_SIZE;
+    if (fits) {
+        r->next = arena__cache;
+        arena__cache = r;
+        arena__cache_bytes += bytes;
+    }
+    pthread_mutex_unlock(&arena__cache_lock);
+    return fits;
+}
+
+void arena_region_cache_clear(void) {
+    pthread_mutex_lock(&arena__cache_lock);
+    ArenaRegion* r = arena__cache;
+    arena__cache = NULL;
+    arena__cache_bytes = 0;
+    pthread_mutex_unlock(&arena__cache_lock);
+
+    while (r != NULL) {
+        ArenaRegion* n = r->next;
+        ARENA_FREE(r);
+        r = n;
+    }
+}
+#endif // ARENA_REGION_CACHE
+
+static void arena__release_region(ArenaRegion* r) {
+#ifdef ARENA_REGION_CACHE
+    if (arena__cache_give(r)) return;
+#endif // ARENA_REGION_CACHE
+    ARENA_FREE(r);
+}
+
+static ArenaRegion* arena__new_region(size_t capacity) {
+    ArenaRegion* r = NULL;
+#ifdef ARENA_REGION_CACHE
+    r = arena__cache_take(capacity);
+    if (r != NULL) capacity = r->capacity;
+#endif // ARENA_REGION_CACHE
+    if (r == NULL) r = ARENA_MALLOC(sizeof(*r) + capacity * sizeof(*r->data));
+    assert(r != NULL);
+    r->count = 0;
+    r->capacity = capacity;
+    r->next = NULL;
+    return r;
+}
+
+static size_t arena__next_capacity(Arena* self, size_t realsize) {
+    size_t capacity = REGION_DEFAULT_SIZE;
+    if (self->end != NULL) {
+        capacity = self->end->capacity * 2;
+        if (capacity > REGION_MAX_SIZE) capacity = REGION_MAX_SIZE;
+    }
+    return capacity < realsize ? realsize : capacity;
+}
+
+// Padding needed to align the next allocation in R, in words
+static size_t arena__padding(ArenaRegion* r, size_t align) {
+    uintptr_t p = (uintptr_t)(r->data + r->count);
+    return ((align - (p & (align - 1))) & (align - 1)) / sizeof(uintptr_t);
+}
+
+static size_t arena__vm_granularity(Arena* self) {
+    if ((self->vm_flags & ARENA_VM_HUGETLB) && ARENA_VM_COMMIT_SIZE < ARENA_VM_HUGE_PAGE_SIZE) {
+        return ARENA_VM_HUGE_PAGE_SIZE;
     }
-    assert(self->end != NULL);
+    return ARENA_VM_COMMIT_SIZE;
+}
+
+// Makes the first END bytes of the reserved range usable
+static bool arena__vm_commit(Arena* self, size_t end) {
+    if (end <= self->committed) return true;
 
-    while (self->end->count + size > self->end->capacity && self->end->next != NULL) {
-        self->end = self->end->next;
+    size_t granularity = arena__vm_granularity(self);
+    size_t target = (end + granularity - 1) / granularity * granularity;
+    if (mprotect((char*)self->start + self->committed, target - self->committed, PROT_READ | PROT_WRITE) < 0) {
+        fprintf(stderr, "Couldn't commit arena memory: %s\n", strerror(errno));
+        return false;
     }
 
-    if (self->end->count + size > self->end->capacity) {
-        self->end->next = ARENA_MALLOC(sizeof(*self->end->next) + REGION_DEFAULT_SIZE * sizeof(*self->start->data));
-        self->end->next->count = 0;
-        self->end->next->capacity = REGION_DEFAULT_SIZE;
-        self->end->next->next = NULL;
-        self->end = self->end->next;
+    self->committed = target;
+    return true;
+}
+
+// Gives back committed memory past the first KEEP bytes, returns how much
+static size_t arena__vm_release(Arena* self, size_t keep) {
+    size_t granularity = arena__vm_granularity(self);
+    keep = (keep + granularity - 1) / granularity * granularity;
+    if (keep >= self->committed) return 0;
+
+    char* base = (char*)self->start;
+    size_t released = self->committed - keep;
+    madvise(base + keep, released, MADV_DONTNEED);
+    mprotect(base + keep, released, PROT_NONE);
+    self->committed = keep;
+    return released;
+}
+
+// Same as arena__vm_release, but never goes below ARENA_VM_RETAIN_SIZE
+static void arena__vm_decommit(Arena* self, size_t keep) {
+    if (keep < ARENA_VM_RETAIN_SIZE) keep = ARENA_VM_RETAIN_SIZE;
+    arena__vm_release(self, keep);
+}
+
+bool arena_init_vm(Arena* self, size_t reserve, int flags) {
+    assert(self->start == NULL && self->large == NULL && "arena_init_vm needs an unused arena");
+
+    self->vm_flags = flags | ARENA_VM;
+    size_t granularity = arena__vm_granularity(self);
+    reserve = (reserve + granularity - 1) / granularity * granularity;
+
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    void* base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (flags & ARENA_VM_HUGETLB) {
+        // Without MAP_NORESERVE the whole range is reserved from the pool up front,
+        // so an empty pool fails here instead of raising SIGBUS on first touch
+        base = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == MAP_FAILED) {
+            fprintf(stderr, "Couldn't map huge pages, falling back to regular pages: %s\n", strerror(errno));
+        }
+    }
+#endif // MAP_HUGETLB
+    if (base == MAP_FAILED) {
+        self->vm_flags &= ~ARENA_VM_HUGETLB;
+        base = mmap(NULL, reserve, PROT_NONE, map_flags, -1, 0);
+    }
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Couldn't reserve %zu bytes for arena: %s\n", reserve, strerror(errno));
+        self->vm_flags = 0;
+        return false;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (flags & ARENA_VM_HUGEPAGE) madvise(base, reserve, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+
+    self->start = base;
+    self->committed = 0;
+    if (!arena__vm_commit(self, sizeof(ArenaRegion))) {
+        munmap(base, reserve);
+        self->start = NULL;
+        self->vm_flags = 0;
+        return false;
+    }
+
+    self->start->count = 0;
+    self->start->capacity = (reserve - sizeof(ArenaRegion)) / sizeof(uintptr_t);
+    self->start->next = NULL;
+    self->end = self->start;
+    return true;
+}
+
+static void* arena__vm_alloc(Arena* self, size_t size, size_t align) {
+    size_t realsize = (size + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+    ArenaRegion* r = self->end;
+    size_t padding = arena__padding(r, align);
+    if (r->count + padding + realsize > r->capacity) {
+        fprintf(stderr, "Arena ran out of its %zu reserved bytes\n", r->capacity * sizeof(uintptr_t));
+        return NULL;
     }
 
+    size_t end = sizeof(ArenaRegion) + (r->count + padding + realsize) * sizeof(uintptr_t);
+    if (!arena__vm_commit(self, end)) return NULL;
+
+    r->count += padding;
+    void* mem = r->data + r->count;
+    r->count += realsize;
+    ARENA__STAT(arena__stats_alloc(self, size, padding + realsize));
+    return mem;
+}
+
+void* arena_alloc_aligned(Arena* self, size_t size, size_t align) {
     size_t word_size = sizeof(uintptr_t);
+    assert((align & (align - 1)) == 0 && "alignment must be a power of two");
+    if (align < word_size) align = word_size;
+
     size_t realsize = (size + word_size - 1) / word_size;
+    // Worst case padding in a fresh region, in words
+    size_t slack = (align - word_size) / word_size;
+
+    if (self->vm_flags) {
+        return arena__vm_alloc(self, size, align);
+    }
+
+    if (realsize > ARENA_LARGE_ALLOC_SIZE) {
+        ArenaRegion* r = arena__new_region(realsize + slack);
+        void* mem = r->data + arena__padding(r, align);
+        r->count = r->capacity;
+        r->next = self->large;
+        self->large = r;
+        ARENA__STAT(self->stats.large_regions++);
+        ARENA__STAT(arena__stats_alloc(self, size, r->capacity));
+        return mem;
+    }
+
+    if (self->end == NULL) {
+        self->end = arena__new_region(arena__next_capacity(self, realsize + slack));
+        self->start = self->end;
+        ARENA__STAT(self->stats.regions++);
+    }
+
+    size_t padding = arena__padding(self->end, align);
+    if (self->end->count + padding + realsize > self->end->capacity) {
+        // Regions after end are always empty, so only the next one is worth checking
+        ArenaRegion* next = self->end->next;
+        if (next == NULL || realsize + slack > next->capacity) {
+            next = arena__new_region(arena__next_capacity(self, realsize + slack));
+            next->next = self->end->next;
+            self->end->next = next;
+            ARENA__STAT(self->stats.regions++);
+        }
+        ARENA__STAT(self->stats.tail_waste += (self->end->capacity - self->end->count) * sizeof(uintptr_t));
+        self->end = next;
+        padding = arena__padding(self->end, align);
+    }
 
+    self->end->count += padding;
     void* mem = self->end->data + self->end->count;
     self->end->count += realsize;
+    ARENA__STAT(arena__stats_alloc(self, size, padding + realsize));
     return mem;
 }
 
+void* arena_alloc(Arena* self, size_t size) {
+    return arena_alloc_aligned(self, size, sizeof(uintptr_t));
+}
+
+// Whether PTR of SIZE bytes is the last allocation in R
+static bool arena__is_last(ArenaRegion* r, void* ptr, size_t size) {
+    size_t word_size = sizeof(uintptr_t);
+    uintptr_t p = (uintptr_t)ptr;
+    uintptr_t data = (uintptr_t)r->data;
+    return data <= p && p + (size + word_size - 1) / word_size * word_size == (uintptr_t)(r->data + r->count);
+}
+
+// Reallocations that have to move get ALIGN, same as the original allocation
+static void* arena__realloc_aligned(Arena* self, size_t oldsize, size_t newsize, void* ptr, size_t align) {
+    if (ptr == NULL) return arena_alloc_aligned(self, newsize, align);
+
+    ArenaRegion* r = self->end;
+    if (r != NULL && arena__is_last(r, ptr, oldsize)) {
+        size_t word_size = sizeof(uintptr_t);
+        size_t start = (uintptr_t*)ptr - r->data;
+        size_t end = start + (newsize + word_size - 1) / word_size;
+
+        bool fits = end <= r->capacity;
+        if (fits && self->vm_flags) fits = arena__vm_commit(self, sizeof(ArenaRegion) + end * word_size);
+        if (fits) {
+            ARENA__STAT(if (newsize > oldsize) arena__stats_alloc(self, newsize - oldsize, end - r->count));
+            r->count = end;
+            ARENA__STAT(arena__stats_recount(self));
+            return ptr;
+        }
+    }
+
+    void* newptr = arena_alloc_aligned(self, newsize, align);
+    if (newptr == NULL) return NULL;
+    return memcpy(newptr, ptr, oldsize < newsize ? oldsize : newsize);
+}
+
 void* arena_realloc(Arena* self, size_t oldsize, size_t newsize, void* ptr) {
-    void* newptr = arena_alloc(self, newsize);
-    return memcpy(newptr, ptr, oldsize);
+    return arena__realloc_aligned(self, oldsize, newsize, ptr, sizeof(uintptr_t));
 }
 
-char* arena_sprintf(Arena* self, const char* fmt, ...) {
-    va_list args;
+bool arena_pop(Arena* self, void* ptr, size_t size) {
+    ArenaRegion* r = self->end;
+    if (r == NULL || !arena__is_last(r, ptr, size)) return false;
 
-    va_start(args, fmt);
+    r->count = (uintptr_t*)ptr - r->data;
+    ARENA__STAT(arena__stats_recount(self));
+    return true;
+}
 
-#pragma GCC diagnostic ignored "-Wformat-truncation"
-    int n = vsnprintf(NULL, 0, fmt, args);
+// Bytes at the end of the current region that can be written right away
+static size_t arena__free_bytes(Arena* self) {
+    ArenaRegion* r = self->end;
+    if (r == NULL) return 0;
 
-    va_end(args);
-    
-    char* cstr = arena_alloc(self, n);
+    if (self->vm_flags) {
+        return self->committed - sizeof(ArenaRegion) - r->count * sizeof(uintptr_t);
+    }
+    return (r->capacity - r->count) * sizeof(uintptr_t);
+}
 
-    va_start(args, fmt);
+char* arena_vsprintf(Arena* self, const char* fmt, va_list args) {
+    size_t room = arena__free_bytes(self);
+    char* start = room > 0 ? (char*)(self->end->data + self->end->count) : NULL;
 
-    int n_ = vsnprintf(NULL, n + 1, fmt, args);
-    assert(n_ == n);
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(start, room, fmt, copy);
+    va_end(copy);
 
-    va_end(args);
+    if (n < 0) return NULL;
+
+    if ((size_t)n < room) {
+        size_t word_size = sizeof(uintptr_t);
+        size_t realsize = (n + 1 + word_size - 1) / word_size;
+        self->end->count += realsize;
+        ARENA__STAT(arena__stats_alloc(self, n + 1, realsize));
+        return start;
+    }
 
+    char* cstr = arena_alloc(self, n + 1);
+    if (cstr == NULL) return NULL;
+
+    vsnprintf(cstr, n + 1, fmt, args);
+    return cstr;
+}
+
+char* arena_sprintf(Arena* self, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char* cstr = arena_vsprintf(self, fmt, args);
+    va_end(args);
     return cstr;
 }
 
@@ -132,41 +608,239 @@ char* arena_realpath(Arena* self, const char* path) {
     return out;
 }
 
+#ifdef ARENA_AUTO_TRIM
+// Bytes taken from the regular regions, alignment padding included
+static size_t arena__used_bytes(Arena* self) {
+    size_t used = 0;
+    for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
+        used += r->count * sizeof(uintptr_t);
+        if (r == self->end) break;
+    }
+    return used;
+}
+#endif // ARENA_AUTO_TRIM
+
+size_t arena_trim(Arena* self, size_t keep_bytes) {
+    if (self->start == NULL) return 0;
+
+    if (self->vm_flags) {
+        size_t used = sizeof(ArenaRegion) + self->start->count * sizeof(uintptr_t);
+        return arena__vm_release(self, used > keep_bytes ? used : keep_bytes);
+    }
+
+    // Regions up to end are in use and always stay, the empty ones after it
+    // stay until KEEP_BYTES are covered. The region that crosses KEEP_BYTES
+    // stays too, or a steady workload would free and malloc it every cycle
+    size_t kept = 0;
+    ArenaRegion* r = self->start;
+    while (r != self->end) {
+        kept += r->capacity * sizeof(uintptr_t);
+        r = r->next;
+    }
+    kept += r->capacity * sizeof(uintptr_t);
+
+    size_t released = 0;
+    ArenaRegion* prev = r;
+    r = r->next;
+    while (r != NULL) {
+        ArenaRegion* n = r->next;
+        size_t bytes = r->capacity * sizeof(uintptr_t);
+        if (kept < keep_bytes) {
+            kept += bytes;
+            prev = r;
+        } else {
+            prev->next = n;
+            released += bytes;
+            arena__release_region(r);
+        }
+        r = n;
+    }
+    return released;
+}
+
+static void arena__free_large(Arena* self, ArenaRegion* until) {
+    while (self->large != until) {
+        ArenaRegion* n = self->large->next;
+        arena__release_region(self->large);
+        self->large = n;
+    }
+}
+
 void arena_reset(Arena* self) {
+    arena__free_large(self, NULL);
+    ARENA__STAT(self->stats.resets++);
+    ARENA__STAT(self->stats.in_use = 0);
+
+    size_t keep = 0;
+#ifdef ARENA_AUTO_TRIM
+    // One huge cycle only moves the average by a fraction, so it can't pin its memory
+    size_t used = arena__used_bytes(self);
+    self->peak_avg = self->peak_avg - self->peak_avg / ARENA_TRIM_DECAY + used / ARENA_TRIM_DECAY;
+    keep = self->peak_avg;
+#endif // ARENA_AUTO_TRIM
+
     for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
         r->count = 0;
     }
 
     self->end = self->start;
+
+    if (self->vm_flags) {
+        arena__vm_decommit(self, sizeof(ArenaRegion) + keep);
+        return;
+    }
+
+#ifdef ARENA_AUTO_TRIM
+    arena_trim(self, keep);
+#endif // ARENA_AUTO_TRIM
+    (void)keep;
 }
 
 ArenaMark arena_mark(Arena* self) {
-    ArenaMark mark = {self->end, self->end->count};
+    ArenaMark mark = {self->end, self->end != NULL ? self->end->count : 0, self->large};
     return mark;
 }
 
 void arena_jumpback(Arena* self, ArenaMark mark) {
+    arena__free_large(self, mark.large);
+    ARENA__STAT(self->stats.jumpbacks++);
+
     if (mark.r == NULL) {
-        arena_reset(self);
+        for (ArenaRegion* r = self->start; r != NULL; r = r->next) {
+            r->count = 0;
+        }
+        self->end = self->start;
+        ARENA__STAT(arena__stats_recount(self));
         return;
     }
 
     mark.r->count = mark.count;
-    for (ArenaRegion* r = mark.r; r != NULL; r = r->next) {
+    for (ArenaRegion* r = mark.r->next; r != NULL; r = r->next) {
         r->count = 0;
     }
 
     self->end = mark.r;
+    ARENA__STAT(arena__stats_recount(self));
+
+    if (self->vm_flags) {
+        arena__vm_decommit(self, sizeof(ArenaRegion) + mark.count * sizeof(uintptr_t));
+    }
 }
 
 void arena_free(Arena* self) {
+    arena__free_large(self, NULL);
+
+    if (self->vm_flags) {
+        if (self->start != NULL) {
+            munmap(self->start, sizeof(ArenaRegion) + self->start->capacity * sizeof(uintptr_t));
+        }
+        self->start = NULL;
+        self->end = NULL;
+        self->vm_flags = 0;
+        self->committed = 0;
+        return;
+    }
+
     ArenaRegion* r = self->start;
     while (r != NULL) {
         ArenaRegion* n = r->next;
-        ARENA_FREE(r);
+        arena__release_region(r);
         r = n;
     }
     self->start = NULL;
     self->end = NULL;
 }
+
+static void* arena__allocator_alloc(void* ctx, size_t size) {
+    return arena_alloc_aligned(ctx, size, _Alignof(max_align_t));
+}
+
+static void* arena__allocator_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    return arena__realloc_aligned(ctx, oldsize, newsize, ptr, _Alignof(max_align_t));
+}
+
+static void arena__allocator_free(void* ctx, void* ptr, size_t size) {
+    arena_pop(ctx, ptr, size);
+}
+
+Allocator arena_allocator(Arena* self) {
+    Allocator allocator = {arena__allocator_alloc, arena__allocator_realloc, arena__allocator_free, self};
+    return allocator;
+}
+
+static _Thread_local Arena arena__scratch[ARENA_SCRATCH_COUNT];
+static _Thread_local bool arena__scratch_registered;
+static pthread_key_t arena__scratch_key;
+static pthread_once_t arena__scratch_once = PTHREAD_ONCE_INIT;
+
+static void arena__scratch_destroy(void* scratch) {
+    Arena* arenas = scratch;
+    for (size_t i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+        arena_free(&arenas[i]);
+    }
+}
+
+static void arena__scratch_create_key(void) {
+    int err = pthread_key_create(&arena__scratch_key, arena__scratch_destroy);
+    assert(err == 0);
+    (void)err;
+}
+
+Arena* arena_scratch(Arena** conflicts, size_t conflicts_count) {
+    if (!arena__scratch_registered) {
+        // The key's destructor only runs for threads that set a value
+        pthread_once(&arena__scratch_once, arena__scratch_create_key);
+        pthread_setspecific(arena__scratch_key, arena__scratch);
+        arena__scratch_registered = true;
+    }
+
+    for (size_t i = 0; i < ARENA_SCRATCH_COUNT; ++i) {
+        bool conflicting = false;
+        for (size_t j = 0; j < conflicts_count; ++j) {
+            if (conflicts[j] == &arena__scratch[i]) {
+                conflicting = true;
+                break;
+            }
+        }
+
+        if (!conflicting) return &arena__scratch[i];
+    }
+
+    assert(0 && "every scratch arena conflicts, raise ARENA_SCRATCH_COUNT");
+    return NULL;
+}
+
+ArenaScratch arena_scratch_begin(Arena** conflicts, size_t conflicts_count) {
+    ArenaScratch scratch;
+    scratch.arena = arena_scratch(conflicts, conflicts_count);
+    scratch.mark = arena_mark(scratch.arena);
+    return scratch;
+}
+
+#ifdef ARENA_STATS
+void arena_stats_dump(Arena* self, FILE* sink) {
+    ArenaStats* stats = &self->stats;
+    fprintf(sink, "Arena stats:\n");
+    fprintf(sink, "    requested: %zu bytes\n", stats->requested);
+    fprintf(sink, "    consumed: %zu bytes\n", stats->consumed);
+    fprintf(sink, "    in use: %zu bytes (peak %zu bytes)\n", stats->in_use, stats->peak);
+    fprintf(sink, "    regions: %zu, large regions: %zu\n", stats->regions, stats->large_regions);
+    fprintf(sink, "    tail waste: %zu bytes (%zu bytes per region)\n",
+            stats->tail_waste, stats->regions > 0 ? stats->tail_waste / stats->regions : 0);
+    fprintf(sink, "    jumpbacks: %zu, resets: %zu\n", stats->jumpbacks, stats->resets);
+
+    fprintf(sink, "    size classes:\n");
+    for (size_t i = 0; i < ARENA_STATS_CLASSES; ++i) {
+        if (stats->size_classes[i] == 0) continue;
+
+        if (i <= 1) {
+            fprintf(sink, "        %zu: %zu\n", i, stats->size_classes[i]);
+        } else if (i == ARENA_STATS_CLASSES - 1) {
+            fprintf(sink, "        >= %zu: %zu\n", (size_t)1 << (i - 1), stats->size_classes[i]);
+        } else {
+            fprintf(sink, "        %zu-%zu: %zu\n", (size_t)1 << (i - 1), ((size_t)1 << i) - 1, stats->size_classes[i]);
+        }
+    }
+}
+#endif // ARENA_STATS
 #endif // ARENA_IMPLEMENTATION
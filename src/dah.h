@@ -1,9 +1,9 @@
 #ifndef DAH_H_
 #define DAH_H_
-#endif // DAH_H_
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifndef DAH_MALLOC
 #include <stdlib.h>
@@ -15,62 +15,283 @@
 #define DAH_REALLOC realloc
 #endif // DAH_REALLOC
 
+#ifndef DAH_FREE
+#include <stdlib.h>
+#define DAH_FREE free
+#endif // DAH_FREE
+
+// Called with false when memory runs out or a size overflows. It must not return,
+// the array can't be used past that point, so dah aborts if it does (as under NDEBUG)
+#ifndef DAH_ASSERT
+#include <assert.h>
+#define DAH_ASSERT assert
+#endif // DAH_ASSERT
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
 typedef struct {
     size_t count, capacity;
-    uint8_t data[];
+    // NULL means DAH_MALLOC/DAH_REALLOC/DAH_FREE
+    const Allocator* allocator;
+    // DAH_INLINE while the items live in a DAH_SBO
+    size_t flags;
+    _Alignas(max_align_t) uint8_t data[];
 }DaHeader;
 
+#define DAH_INLINE (1 << 0)
+
+// Storage for N items inside the owning struct, so small arrays never allocate.
+// dah_sbo_init returns the array, which moves to the heap once it outgrows N.
+// The storage has to stay in place while the array points into it.
+#define DAH_SBO(Type, N) struct { DaHeader header; _Alignas(max_align_t) Type items[N]; }
+#define dah_sbo_init(sbo) dah__init_inline(&(sbo)->header, sizeof((sbo)->items) / sizeof((sbo)->items[0]))
+
+#ifndef DAH_INIT_CAPACITY
 #define DAH_INIT_CAPACITY 16
+#endif // DAH_INIT_CAPACITY
+
+// Capacity after CAP when an append doesn't fit. Define it as ((cap) + (cap)/2)
+// for 1.5x growth, which wastes less memory at the cost of more reallocs
+#ifndef DAH_GROW
+#define DAH_GROW(cap) ((cap) * 2)
+#endif // DAH_GROW
+
+// Arrays without an allocator move to their own mapping once they reach this
+// many bytes, and grow with mremap from there. 0 disables it, which is the
+// default when sys/mman.h has no mremap (glibc needs _GNU_SOURCE), since each
+// growth would copy the whole mapping where realloc can remap
+#ifndef DAH_MMAP_THRESHOLD
+#ifdef MREMAP_MAYMOVE
+#define DAH_MMAP_THRESHOLD (1 << 26)
+#else
+#define DAH_MMAP_THRESHOLD 0
+#endif // MREMAP_MAYMOVE
+#endif // DAH_MMAP_THRESHOLD
+
+// Radix sorts fall back to insertion sort below this many items
+#ifndef DAH_RADIX_INSERTION
+#define DAH_RADIX_INSERTION 64
+#endif // DAH_RADIX_INSERTION
+
+// Radix sorts use 8 bit digits below this many items, 11 bit ones below
+// DAH_RADIX_16BIT, and 16 bit ones past it, so bigger arrays take fewer passes
+#ifndef DAH_RADIX_11BIT
+#define DAH_RADIX_11BIT (1 << 12)
+#endif // DAH_RADIX_11BIT
+
+#ifndef DAH_RADIX_16BIT
+#define DAH_RADIX_16BIT (1 << 20)
+#endif // DAH_RADIX_16BIT
+
+typedef enum {
+    DAH_KEY_U32,
+    DAH_KEY_U64,
+    DAH_KEY_I32,
+    DAH_KEY_I64,
+    DAH_KEY_F32,
+    DAH_KEY_F64,
+}DahKeyType;
+
+// Decides whether dah_retain keeps ITEM
+typedef bool (*dah_predicate_t)(const void* item, void* ctx);
 
-#define dah_init(da) ((da) = (void*)dah__default_header(sizeof(Statement))->data)
+#define dah_init(da) ((da) = (void*)dah__default_header(sizeof(*(da)), NULL)->data)
+// Starts an array whose memory comes from ALLOCATOR, which must outlive it
+#define dah_init_with(da, allocator) ((da) = (void*)dah__default_header(sizeof(*(da)), allocator)->data)
 
 #define dah_append(da, v) ((da) = dah__maybe_resize(da, 1, sizeof(*(da))), (da)[dah_getheader(da)->count++] = (v))
-#define dah_append_many(da, vs, vcount) ((da) = dah__maybe_resize(da, vcount, sizeof(*(da))), memcpy((da) + dah_getheader(da)->count, vs, vcount * sizeof(*(da))), dah_getheader(da)->count += vcount)
+// Grows at most once, to exactly fit when the items wouldn't fit the regular growth
+#define dah_append_many(da, vs, vcount) ((da) = dah__append_many(da, vs, vcount, sizeof(*(da))))
 #define dah_append_cstr(da, cstr) dah_append_many(da, cstr, strlen(cstr))
 #define dah_remove_unordered(da, i) ((da)[i] = (da)[--dah_getheader(da)->count])
 #define dah_remove_ordered(da, i) dah__remove_ordered(da, i, sizeof(*(da)))
-#define dah_reset(da) (da_getheader(da)->count = 0)
-#define dah_free(da) ((da) = dah__free(da))
+// Inserts N items at I, moving the items from I on once
+#define dah_insert_many(da, i, vs, n) ((da) = dah__insert_many(da, i, vs, n, sizeof(*(da))))
+#define dah_remove_range(da, i, n) dah__remove_range(da, i, n, sizeof(*(da)))
+// Keeps the items PRED returns true for, in order, in a single pass that moves
+// whole runs of kept items at once. Returns the new count
+#define dah_retain(da, pred, ctx) dah__retain(da, pred, ctx, sizeof(*(da)))
+// Same as dah_retain, but keeps item I when bit I % 64 of KEEP[I / 64] is set
+#define dah_retain_mask(da, keep) dah__retain_mask(da, keep, sizeof(*(da)))
+#define dah_reset(da) (dah_getheader(da)->count = 0)
+#define dah_free(da) ((da) = dah__free(da, sizeof(*(da))))
+// Makes room for CAPACITY items in total, so appending up to there never reallocs
+#define dah_reserve(da, capacity) ((da) = dah__reserve(da, capacity, sizeof(*(da))))
+// Gives back the capacity past the current count
+#define dah_shrink_to_fit(da) ((da) = dah__shrink_to_fit(da, sizeof(*(da))))
 
-#define dah_for(da, counter) for (size_t counter = 0; counter < dah_getheader(da)->count; ++counter)
-#define dah_foreach(da, Type, ptr) for (Type* ptr = da; ptr < da + dah_getheader(da)->count; ++ptr)
+// Stable LSD radix sorts of arrays of plain keys, in ascending order. Floats
+// sort by their IEEE bits, so -0.0 comes before 0.0 and NaNs go to the ends.
+// The items have to be as wide as the key, which is checked at compile time
+#define dah_radix_sort_u32(da) dah__radix_sort_keys(da, DAH_KEY_U32)
+#define dah_radix_sort_u64(da) dah__radix_sort_keys(da, DAH_KEY_U64)
+#define dah_radix_sort_i32(da) dah__radix_sort_keys(da, DAH_KEY_I32)
+#define dah_radix_sort_i64(da) dah__radix_sort_keys(da, DAH_KEY_I64)
+#define dah_radix_sort_f32(da) dah__radix_sort_keys(da, DAH_KEY_F32)
+#define dah_radix_sort_f64(da) dah__radix_sort_keys(da, DAH_KEY_F64)
+// Sorts an array of structs by FIELD, whose type is given by KEY_TYPE. KEY_TYPE
+// has to be a constant, the field's size is checked against it at compile time
+#define dah_radix_sort_by(da, field, key_type) \
+    (DAH__CHECK_KEY_SIZE(sizeof(((__typeof__(*(da))*)0)->field), key_type), \
+     dah__radix_sort(da, dah_getlen(da), sizeof(*(da)), offsetof(__typeof__(*(da)), field), key_type))
+
+#define DAH__KEY_SIZE(key_type) \
+    ((key_type) == DAH_KEY_U32 || (key_type) == DAH_KEY_I32 || (key_type) == DAH_KEY_F32 ? 4 : 8)
+// A static assert usable in an expression
+#define DAH__CHECK_KEY_SIZE(size, key_type) \
+    ((void)sizeof(struct { _Static_assert((size) == DAH__KEY_SIZE(key_type), "key size doesn't match the radix sort's key type"); int dah__unused; }))
+#define dah__radix_sort_keys(da, key_type) \
+    (DAH__CHECK_KEY_SIZE(sizeof(*(da)), key_type), dah__radix_sort(da, dah_getlen(da), sizeof(*(da)), 0, key_type))
+
+#define dah_for(da, counter) for (size_t counter = 0; counter < dah_getlen(da); ++counter)
+#define dah_foreach(da, Type, ptr) for (Type* ptr = (da); ptr < (da) + dah_getlen(da); ++ptr)
 
 DaHeader* dah_getheader(void* da);
 size_t dah_getlen(void* da);
 
-DaHeader* dah__default_header(size_t item_size);
+DaHeader* dah__default_header(size_t item_size, const Allocator* allocator);
+void* dah__init_inline(DaHeader* header, size_t capacity);
 void* dah__maybe_resize(void* da, size_t to_add, size_t item_size);
+void* dah__append_many(void* da, const void* items, size_t count, size_t item_size);
+void* dah__reserve(void* da, size_t capacity, size_t item_size);
+void* dah__shrink_to_fit(void* da, size_t item_size);
 void dah__remove_ordered(void* da, size_t i, size_t item_size);
-void* dah__free(void* da);
+void* dah__insert_many(void* da, size_t i, const void* items, size_t count, size_t item_size);
+void dah__remove_range(void* da, size_t i, size_t count, size_t item_size);
+size_t dah__retain(void* da, dah_predicate_t pred, void* ctx, size_t item_size);
+size_t dah__retain_mask(void* da, const uint64_t* keep, size_t item_size);
+void* dah__free(void* da, size_t item_size);
+void dah__radix_sort(void* items, size_t count, size_t item_size, size_t key_offset, DahKeyType key_type);
+
+#endif // DAH_H_
 
 #ifdef DAH_IMPLEMENTATION
 #undef DAH_IMPLEMENTATION
 
 #include <string.h>
 
-DaHeader* dah__default_header(size_t item_size) {
-    DaHeader* header = DAH_MALLOC(sizeof(DaHeader) + item_size * DAH_INIT_CAPACITY);
+#define dah__check(cond) do { if (!(cond)) { DAH_ASSERT(cond); abort(); } } while (0)
+
+DaHeader* dah__default_header(size_t item_size, const Allocator* allocator) {
+    size_t size = sizeof(DaHeader) + item_size * DAH_INIT_CAPACITY;
+    DaHeader* header = allocator != NULL ? allocator_alloc(allocator, size) : DAH_MALLOC(size);
+    dah__check(header != NULL);
     header->count = 0;
     header->capacity = DAH_INIT_CAPACITY;
+    header->allocator = allocator;
+    header->flags = 0;
     return header;
 }
 
+void* dah__init_inline(DaHeader* header, size_t capacity) {
+    header->count = 0;
+    header->capacity = capacity;
+    header->allocator = NULL;
+    header->flags = DAH_INLINE;
+    return header->data;
+}
+
+// Reallocates HEADER to CAPACITY items. Nothing is written until the new memory is there
+static DaHeader* dah__set_capacity(DaHeader* header, size_t capacity, size_t item_size) {
+    dah__check(capacity <= (SIZE_MAX - sizeof(DaHeader)) / item_size);
+
+    size_t old_size = sizeof(DaHeader) + header->capacity * item_size;
+    size_t new_size = sizeof(DaHeader) + capacity * item_size;
+
+    DaHeader* resized;
+    if (header->flags & DAH_INLINE) {
+        // Inline storage never shrinks, and spills to the heap when it's outgrown
+        if (capacity <= header->capacity) return header;
+
+        resized = DAH_MALLOC(new_size);
+        if (resized != NULL) {
+            memcpy(resized, header, sizeof(DaHeader) + header->count * item_size);
+            resized->flags &= ~DAH_INLINE;
+        }
+    } else if (header->allocator != NULL) {
+        resized = allocator_realloc(header->allocator, header, old_size, new_size);
+#if DAH_MMAP_THRESHOLD > 0
+    } else if (new_size >= DAH_MMAP_THRESHOLD) {
+        resized = allocator_alloc(&mmap_allocator, new_size);
+        if (resized != NULL) {
+            memcpy(resized, header, sizeof(DaHeader) + header->count * item_size);
+            DAH_FREE(header);
+            resized->allocator = &mmap_allocator;
+        }
+#endif // DAH_MMAP_THRESHOLD
+    } else {
+        resized = DAH_REALLOC(header, new_size);
+    }
+    dah__check(resized != NULL);
+
+    resized->capacity = capacity;
+    return resized;
+}
+
 void* dah__maybe_resize(void* da, size_t to_add, size_t item_size) {
     if (da == NULL) {
-        return dah__default_header(item_size)->data;
+        da = dah__default_header(item_size, NULL)->data;
     }
 
     DaHeader* header = (DaHeader*)da - 1;
-    
-    if (header->count + to_add >= header->capacity) {
-        if (header->capacity == 0) header->capacity = 2;
-        while (header->count + to_add >= header->capacity) header->capacity *= 2;
-        header = DAH_REALLOC(header, sizeof(DaHeader) + header->capacity * item_size);
+
+    size_t needed = header->count + to_add;
+    dah__check(needed >= to_add);
+    if (needed > header->capacity) {
+        size_t capacity = header->capacity == 0 ? DAH_INIT_CAPACITY : DAH_GROW(header->capacity);
+        if (capacity < needed) capacity = needed;
+        header = dah__set_capacity(header, capacity, item_size);
     }
 
     return header->data;
 }
 
+// Byte offset of ITEMS in the items of DA, or SIZE_MAX when they live somewhere else.
+// Items taken from the array itself have to be found again after it grows
+static size_t dah__offset_of(void* da, const void* items, size_t item_size) {
+    if (da == NULL || items == NULL) return SIZE_MAX;
+
+    uintptr_t p = (uintptr_t)items;
+    uintptr_t start = (uintptr_t)da;
+    if (p < start || p >= start + dah_getheader(da)->count * item_size) return SIZE_MAX;
+    return p - start;
+}
+
+void* dah__append_many(void* da, const void* items, size_t count, size_t item_size) {
+    size_t offset = dah__offset_of(da, items, item_size);
+    da = dah__maybe_resize(da, count, item_size);
+
+    DaHeader* header = dah_getheader(da);
+    if (offset != SIZE_MAX) items = header->data + offset;
+    if (count > 0) memcpy(header->data + header->count * item_size, items, count * item_size);
+    header->count += count;
+    return da;
+}
+
+void* dah__reserve(void* da, size_t capacity, size_t item_size) {
+    if (da == NULL) {
+        da = dah__default_header(item_size, NULL)->data;
+    }
+
+    DaHeader* header = dah_getheader(da);
+    if (capacity > header->capacity) {
+        header = dah__set_capacity(header, capacity, item_size);
+    }
+    return header->data;
+}
+
+void* dah__shrink_to_fit(void* da, size_t item_size) {
+    if (da == NULL) return NULL;
+
+    DaHeader* header = dah_getheader(da);
+    if (header->count < header->capacity) {
+        header = dah__set_capacity(header, header->count, item_size);
+    }
+    return header->data;
+}
+
 size_t dah_getlen(void* da) {
     if (da == NULL) return 0;
     return dah_getheader(da)->count;
@@ -87,9 +308,214 @@ void dah__remove_ordered(void* da, size_t i, size_t item_size) {
     header->count--;
 }
 
-void* dah__free(void* da) {
-    free(dah_getheader(da));
+void* dah__insert_many(void* da, size_t i, const void* items, size_t count, size_t item_size) {
+    DAH_ASSERT(i <= dah_getlen(da));
+    size_t offset = dah__offset_of(da, items, item_size);
+    da = dah__maybe_resize(da, count, item_size);
+
+    DaHeader* header = dah_getheader(da);
+    size_t at = i * item_size;
+    size_t size = count * item_size;
+    memmove(header->data + at + size, header->data + at, (header->count - i) * item_size);
+    if (offset == SIZE_MAX) {
+        if (count > 0) memcpy(header->data + at, items, size);
+    } else {
+        // Items from before I stayed put, the ones from I on moved up with the tail
+        size_t before = offset < at ? at - offset : 0;
+        if (before > size) before = size;
+        memcpy(header->data + at, header->data + offset, before);
+        memcpy(header->data + at + before, header->data + offset + before + size, size - before);
+    }
+    header->count += count;
+    return da;
+}
+
+void dah__remove_range(void* da, size_t i, size_t count, size_t item_size) {
+    if (count == 0) return;
+
+    DaHeader* header = dah_getheader(da);
+    DAH_ASSERT(i + count <= header->count);
+    memmove(header->data + i * item_size, header->data + (i + count) * item_size, (header->count - i - count) * item_size);
+    header->count -= count;
+}
+
+size_t dah__retain(void* da, dah_predicate_t pred, void* ctx, size_t item_size) {
+    if (da == NULL) return 0;
+
+    DaHeader* header = dah_getheader(da);
+    uint8_t* data = header->data;
+    size_t count = header->count;
+
+    // Kept items only ever move down, so the ones PRED hasn't seen stay where they are.
+    // PRED sees every item exactly once, and each run of kept items moves with one memmove
+    size_t kept = 0;
+    size_t start = 0;
+    bool in_run = false;
+    for (size_t i = 0; i <= count; ++i) {
+        bool keep = i < count && pred(data + i * item_size, ctx);
+        if (keep && !in_run) {
+            start = i;
+        } else if (!keep && in_run) {
+            if (start != kept) memmove(data + kept * item_size, data + start * item_size, (i - start) * item_size);
+            kept += i - start;
+        }
+        in_run = keep;
+    }
+
+    header->count = kept;
+    return kept;
+}
+
+// First I from FROM on whose bit in MASK is SET, or COUNT
+static size_t dah__find_bit(const uint64_t* mask, size_t from, size_t count, bool set) {
+    size_t i = from;
+    while (i < count) {
+        uint64_t word = set ? mask[i / 64] : ~mask[i / 64];
+        word &= ~(uint64_t)0 << (i % 64);
+        if (word != 0) {
+            i = i / 64 * 64 + __builtin_ctzll(word);
+            return i < count ? i : count;
+        }
+        i = (i / 64 + 1) * 64;
+    }
+    return count;
+}
+
+size_t dah__retain_mask(void* da, const uint64_t* keep, size_t item_size) {
+    if (da == NULL) return 0;
+
+    DaHeader* header = dah_getheader(da);
+    uint8_t* data = header->data;
+    size_t count = header->count;
+
+    size_t kept = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t start = dah__find_bit(keep, i, count, true);
+        i = dah__find_bit(keep, start, count, false);
+
+        if (start != kept) memmove(data + kept * item_size, data + start * item_size, (i - start) * item_size);
+        kept += i - start;
+    }
+
+    header->count = kept;
+    return kept;
+}
+
+void* dah__free(void* da, size_t item_size) {
+    if (da == NULL) return NULL;
+
+    DaHeader* header = dah_getheader(da);
+    if (header->flags & DAH_INLINE) {
+        return NULL;
+    } else if (header->allocator != NULL) {
+        allocator_free(header->allocator, header, sizeof(DaHeader) + header->capacity * item_size);
+    } else {
+        DAH_FREE(header);
+    }
     return NULL;
 }
 
+// Loads the key of ITEM as an unsigned number that sorts in the same order
+static inline uint64_t dah__radix_key(const uint8_t* item, DahKeyType key_type) {
+    uint32_t k32;
+    uint64_t k64;
+    switch (key_type) {
+    case DAH_KEY_U32: memcpy(&k32, item, 4); return k32;
+    case DAH_KEY_U64: memcpy(&k64, item, 8); return k64;
+    case DAH_KEY_I32: memcpy(&k32, item, 4); return k32 ^ 0x80000000u;
+    case DAH_KEY_I64: memcpy(&k64, item, 8); return k64 ^ 0x8000000000000000ull;
+    case DAH_KEY_F32:
+        memcpy(&k32, item, 4);
+        return k32 & 0x80000000u ? ~k32 : k32 | 0x80000000u;
+    case DAH_KEY_F64:
+        memcpy(&k64, item, 8);
+        return k64 & 0x8000000000000000ull ? ~k64 : k64 | 0x8000000000000000ull;
+    }
+    return 0;
+}
+
+static inline void dah__radix_copy(uint8_t* dst, const uint8_t* src, size_t item_size) {
+    // Plain keys are the common case, and fixed size copies compile to a single move
+    switch (item_size) {
+    case 4: memcpy(dst, src, 4); break;
+    case 8: memcpy(dst, src, 8); break;
+    case 16: memcpy(dst, src, 16); break;
+    default: memcpy(dst, src, item_size); break;
+    }
+}
+
+static void dah__insertion_sort(uint8_t* items, size_t count, size_t item_size, size_t key_offset, DahKeyType key_type) {
+    uint8_t tmp[item_size];
+    for (size_t i = 1; i < count; ++i) {
+        uint64_t key = dah__radix_key(items + i * item_size + key_offset, key_type);
+        size_t j = i;
+        while (j > 0 && dah__radix_key(items + (j - 1) * item_size + key_offset, key_type) > key) --j;
+        if (j == i) continue;
+
+        memcpy(tmp, items + i * item_size, item_size);
+        memmove(items + (j + 1) * item_size, items + j * item_size, (i - j) * item_size);
+        memcpy(items + j * item_size, tmp, item_size);
+    }
+}
+
+void dah__radix_sort(void* da, size_t count, size_t item_size, size_t key_offset, DahKeyType key_type) {
+    uint8_t* items = da;
+    if (count < 2) return;
+    if (count < DAH_RADIX_INSERTION) {
+        dah__insertion_sort(items, count, item_size, key_offset, key_type);
+        return;
+    }
+
+    size_t key_bits = DAH__KEY_SIZE(key_type) * 8;
+    size_t digit_bits = count < DAH_RADIX_11BIT ? 8 : count < DAH_RADIX_16BIT ? 11 : 16;
+    size_t passes = (key_bits + digit_bits - 1) / digit_bits;
+    size_t buckets = (size_t)1 << digit_bits;
+
+    // Every histogram is counted in a single read of the keys
+    size_t* counts = DAH_MALLOC(passes * buckets * sizeof(size_t));
+    uint8_t* tmp = DAH_MALLOC(count * item_size);
+    dah__check(counts != NULL && tmp != NULL);
+    memset(counts, 0, passes * buckets * sizeof(size_t));
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = dah__radix_key(items + i * item_size + key_offset, key_type);
+        for (size_t p = 0; p < passes; ++p) {
+            counts[p * buckets + ((key >> (p * digit_bits)) & (buckets - 1))]++;
+        }
+    }
+
+    uint8_t* src = items;
+    uint8_t* dst = tmp;
+    for (size_t p = 0; p < passes; ++p) {
+        size_t* hist = counts + p * buckets;
+        size_t shift = p * digit_bits;
+
+        // Every key has the same digit, so the pass wouldn't move anything
+        size_t first = (dah__radix_key(src + key_offset, key_type) >> shift) & (buckets - 1);
+        if (hist[first] == count) continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            size_t n = hist[b];
+            hist[b] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* item = src + i * item_size;
+            size_t digit = (dah__radix_key(item + key_offset, key_type) >> shift) & (buckets - 1);
+            dah__radix_copy(dst + hist[digit]++ * item_size, item, item_size);
+        }
+
+        uint8_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != items) memcpy(items, src, count * item_size);
+    DAH_FREE(counts);
+    DAH_FREE(tmp);
+}
+
 #endif
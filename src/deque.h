@@ -0,0 +1,172 @@
+#ifndef DEQUE_H_
+#define DEQUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef DEQ_MALLOC
+#include <stdlib.h>
+#define DEQ_MALLOC malloc
+#endif // DEQ_MALLOC
+
+#ifndef DEQ_FREE
+#include <stdlib.h>
+#define DEQ_FREE free
+#endif // DEQ_FREE
+
+#ifndef DEQ_ASSERT
+#include <assert.h>
+#define DEQ_ASSERT assert
+#endif // DEQ_ASSERT
+
+// Has to be a power of two
+#ifndef DEQ_INIT_CAPACITY
+#define DEQ_INIT_CAPACITY 16
+#endif // DEQ_INIT_CAPACITY
+
+// A ring buffer behind a pointer to its items, like dah. The items wrap around
+// the end of the buffer, so use deq_at instead of indexing the pointer directly.
+// A NULL pointer is an empty deque.
+typedef struct {
+    size_t head, count;
+    // Always a power of two, so wrapping is a mask
+    size_t capacity;
+    _Alignas(max_align_t) uint8_t data[];
+}DeqHeader;
+
+#define deq_getheader(dq) ((DeqHeader*)(dq) - 1)
+#define deq_len(dq) ((dq) == NULL ? 0 : deq_getheader(dq)->count)
+#define deq_empty(dq) (deq_len(dq) == 0)
+#define deq__mask(dq) (deq_getheader(dq)->capacity - 1)
+
+// Item I counted from the front
+#define deq_at(dq, i) ((dq)[(deq_getheader(dq)->head + (i)) & deq__mask(dq)])
+#define deq_front(dq) deq_at(dq, 0)
+#define deq_back(dq) deq_at(dq, deq_getheader(dq)->count - 1)
+
+#define deq_push_back(dq, v) ((dq) = deq__grow(dq, 1, sizeof(*(dq))), (dq)[deq__push_back_slot(deq_getheader(dq))] = (v))
+#define deq_push_front(dq, v) ((dq) = deq__grow(dq, 1, sizeof(*(dq))), (dq)[deq__push_front_slot(deq_getheader(dq))] = (v))
+// Take the value out of the deque, which mustn't be empty
+#define deq_pop_front(dq) ((dq)[deq__pop_front_slot(deq_getheader(dq))])
+#define deq_pop_back(dq) ((dq)[deq__pop_back_slot(deq_getheader(dq))])
+
+// Copy N items in or out with at most two memcpys each.
+// The pops return how many items there were to take, up to N.
+#define deq_push_back_many(dq, items, n) ((dq) = deq__push_back_many(dq, items, n, sizeof(*(dq))))
+#define deq_pop_front_many(dq, out, n) deq__pop_front_many(dq, out, n, sizeof(*(dq)))
+
+// Makes room for CAPACITY items in total
+#define deq_reserve(dq, capacity) ((dq) = deq__reserve(dq, capacity, sizeof(*(dq))))
+#define deq_clear(dq) ((dq) == NULL ? (void)0 : (void)(deq_getheader(dq)->head = deq_getheader(dq)->count = 0))
+#define deq_free(dq) ((dq) = deq__free(dq))
+
+void* deq__grow(void* dq, size_t to_add, size_t item_size);
+void* deq__reserve(void* dq, size_t capacity, size_t item_size);
+size_t deq__push_back_slot(DeqHeader* header);
+size_t deq__push_front_slot(DeqHeader* header);
+size_t deq__pop_front_slot(DeqHeader* header);
+size_t deq__pop_back_slot(DeqHeader* header);
+void* deq__push_back_many(void* dq, const void* items, size_t n, size_t item_size);
+size_t deq__pop_front_many(void* dq, void* out, size_t n, size_t item_size);
+void* deq__free(void* dq);
+
+#endif // DEQUE_H_
+
+#ifdef DEQ_IMPLEMENTATION
+#undef DEQ_IMPLEMENTATION
+
+#include <string.h>
+
+// Moves the items to a buffer of CAPACITY, starting at its beginning
+static DeqHeader* deq__unwrap(DeqHeader* header, size_t capacity, size_t item_size) {
+    DeqHeader* fresh = DEQ_MALLOC(sizeof(DeqHeader) + capacity * item_size);
+    DEQ_ASSERT(fresh != NULL);
+    fresh->head = 0;
+    fresh->count = 0;
+    fresh->capacity = capacity;
+    if (header == NULL) return fresh;
+
+    size_t first = header->capacity - header->head;
+    if (first > header->count) first = header->count;
+    memcpy(fresh->data, header->data + header->head * item_size, first * item_size);
+    memcpy(fresh->data + first * item_size, header->data, (header->count - first) * item_size);
+    fresh->count = header->count;
+
+    DEQ_FREE(header);
+    return fresh;
+}
+
+void* deq__reserve(void* dq, size_t capacity, size_t item_size) {
+    DeqHeader* header = dq != NULL ? deq_getheader(dq) : NULL;
+    size_t current = header != NULL ? header->capacity : 0;
+    if (header != NULL && capacity <= current) return dq;
+
+    size_t fresh = DEQ_INIT_CAPACITY;
+    while (fresh < capacity) fresh *= 2;
+    return deq__unwrap(header, fresh, item_size)->data;
+}
+
+void* deq__grow(void* dq, size_t to_add, size_t item_size) {
+    if (dq != NULL && deq_getheader(dq)->count + to_add <= deq_getheader(dq)->capacity) return dq;
+    return deq__reserve(dq, deq_len(dq) + to_add, item_size);
+}
+
+size_t deq__push_back_slot(DeqHeader* header) {
+    return (header->head + header->count++) & (header->capacity - 1);
+}
+
+size_t deq__push_front_slot(DeqHeader* header) {
+    header->head = (header->head - 1) & (header->capacity - 1);
+    header->count++;
+    return header->head;
+}
+
+size_t deq__pop_front_slot(DeqHeader* header) {
+    DEQ_ASSERT(header->count > 0);
+    size_t slot = header->head;
+    header->head = (header->head + 1) & (header->capacity - 1);
+    header->count--;
+    return slot;
+}
+
+size_t deq__pop_back_slot(DeqHeader* header) {
+    DEQ_ASSERT(header->count > 0);
+    return (header->head + --header->count) & (header->capacity - 1);
+}
+
+void* deq__push_back_many(void* dq, const void* items, size_t n, size_t item_size) {
+    dq = deq__grow(dq, n, item_size);
+    DeqHeader* header = deq_getheader(dq);
+
+    size_t tail = (header->head + header->count) & (header->capacity - 1);
+    size_t first = header->capacity - tail;
+    if (first > n) first = n;
+    memcpy(header->data + tail * item_size, items, first * item_size);
+    memcpy(header->data, (const uint8_t*)items + first * item_size, (n - first) * item_size);
+
+    header->count += n;
+    return dq;
+}
+
+size_t deq__pop_front_many(void* dq, void* out, size_t n, size_t item_size) {
+    if (dq == NULL) return 0;
+
+    DeqHeader* header = deq_getheader(dq);
+    if (n > header->count) n = header->count;
+
+    size_t first = header->capacity - header->head;
+    if (first > n) first = n;
+    memcpy(out, header->data + header->head * item_size, first * item_size);
+    memcpy((uint8_t*)out + first * item_size, header->data, (n - first) * item_size);
+
+    header->head = (header->head + n) & (header->capacity - 1);
+    header->count -= n;
+    return n;
+}
+
+void* deq__free(void* dq) {
+    if (dq != NULL) DEQ_FREE(deq_getheader(dq));
+    return NULL;
+}
+
+#endif // DEQ_IMPLEMENTATION
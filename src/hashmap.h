@@ -0,0 +1,278 @@
+#ifndef HASHMAP_H_
+#define HASHMAP_H_
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
+#ifndef STRING_VIEW_H_
+#include "string_view.h"
+#endif // STRING_VIEW_H_
+
+// Open-addressing hash maps generated for a key and value type:
+//
+//     HASHMAP_DECLARE(Symbols, symbols, StringView, int)   // in a header
+//     HASHMAP_IMPLEMENT(Symbols, symbols, StringView, int, hashmap_hash_sv, hashmap_eq_sv)
+//
+// Every slot has a control byte, either HASHMAP_EMPTY or 7 bits of the key's
+// hash. Lookups compare 16 control bytes at once and only look at the keys
+// whose bits match. Probing is linear, and removing shifts the rest of the
+// cluster back, so there are no tombstones and lookups never slow down.
+// Iterating goes in slot order, which stays the same until the map is changed.
+
+#define HASHMAP_EMPTY 0x80
+#define HASHMAP_GROUP 16
+
+// Grows past this share of occupied slots, out of 8
+#ifndef HASHMAP_MAX_LOAD
+#define HASHMAP_MAX_LOAD 7
+#endif // HASHMAP_MAX_LOAD
+
+static inline uint64_t hashmap_hash_u64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline uint64_t hashmap_hash_bytes(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ size;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < size; ++i, shift += 8) tail |= (uint64_t)bytes[i] << shift;
+    return hashmap_hash_u64(hash ^ tail);
+}
+
+static inline bool hashmap_eq_u64(uint64_t a, uint64_t b) {
+    return a == b;
+}
+
+static inline uint64_t hashmap_hash_sv(StringView sv) {
+    return hashmap_hash_bytes(sv.start, sv.len);
+}
+
+static inline bool hashmap_eq_sv(StringView a, StringView b) {
+    return a.len == b.len && (a.len == 0 || memcmp(a.start, b.start, a.len) == 0);
+}
+
+// Bit I is set when the control byte at I is BYTE, EMPTY gets the empty slots
+static inline uint32_t hashmap__group(const uint8_t* ctrl, uint8_t byte, uint32_t* empty) {
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    *empty = (uint32_t)_mm_movemask_epi8(group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#else
+    uint32_t match = 0;
+    *empty = 0;
+    for (int i = 0; i < HASHMAP_GROUP; ++i) {
+        match |= (uint32_t)(ctrl[i] == byte) << i;
+        *empty |= (uint32_t)(ctrl[i] == HASHMAP_EMPTY) << i;
+    }
+    return match;
+#endif // __SSE2__
+}
+
+// The first group is mirrored past the end, so a group can be loaded from any slot
+static inline void hashmap__set_ctrl(uint8_t* ctrl, size_t capacity, size_t i, uint8_t byte) {
+    ctrl[i] = byte;
+    if (i < HASHMAP_GROUP) ctrl[capacity + i] = byte;
+}
+
+// Declares Name, NameEntry and the prefix_ functions
+#define HASHMAP_DECLARE(Name, prefix, Key, Value) \
+typedef struct { \
+    Key key; \
+    Value value; \
+}Name##Entry; \
+\
+typedef struct { \
+    Name##Entry* entries; \
+    /* capacity + HASHMAP_GROUP control bytes, right after the entries */ \
+    uint8_t* ctrl; \
+    size_t count, capacity; \
+    /* NULL means malloc/free */ \
+    const Allocator* allocator; \
+}Name; \
+\
+/* Returns NULL if KEY isn't in the map */ \
+Value* prefix##_get(Name* self, Key key); \
+/* Inserts KEY or overwrites its value, returns where the value lives until the map changes */ \
+Value* prefix##_put(Name* self, Key key, Value value); \
+bool prefix##_remove(Name* self, Key key); \
+/* Makes room for COUNT keys in total */ \
+void prefix##_reserve(Name* self, size_t count); \
+void prefix##_clear(Name* self); \
+void prefix##_free(Name* self); \
+/* Walks the entries in slot order, start ITER at 0. Returns NULL at the end */ \
+Name##Entry* prefix##_next(Name* self, size_t* iter);
+
+#define HASHMAP_IMPLEMENT(Name, prefix, Key, Value, hash_fn, eq_fn) \
+static size_t prefix##__block_size(size_t capacity) { \
+    return capacity * sizeof(Name##Entry) + capacity + HASHMAP_GROUP; \
+} \
+\
+/* Slot of KEY, or SIZE_MAX with the empty slot it would go in in HOLE */ \
+static size_t prefix##__find(Name* self, Key key, uint64_t hash, size_t* hole) { \
+    size_t mask = self->capacity - 1; \
+    uint8_t h2 = hash & 0x7f; \
+    size_t pos = (hash >> 7) & mask; \
+\
+    while (true) { \
+        uint32_t empty; \
+        uint32_t match = hashmap__group(self->ctrl + pos, h2, &empty); \
+        /* Slots past the first empty one belong to another cluster */ \
+        if (empty != 0) match &= (empty & -empty) - 1; \
+\
+        while (match != 0) { \
+            size_t i = (pos + __builtin_ctz(match)) & mask; \
+            if (eq_fn(self->entries[i].key, key)) return i; \
+            match &= match - 1; \
+        } \
+\
+        if (empty != 0) { \
+            *hole = (pos + __builtin_ctz(empty)) & mask; \
+            return SIZE_MAX; \
+        } \
+        pos = (pos + HASHMAP_GROUP) & mask; \
+    } \
+} \
+\
+static void prefix##__resize(Name* self, size_t capacity) { \
+    size_t size = prefix##__block_size(capacity); \
+    char* block = self->allocator != NULL ? (char*)allocator_alloc(self->allocator, size) : (char*)malloc(size); \
+    assert(block != NULL); \
+\
+    Name old = *self; \
+    self->entries = (Name##Entry*)block; \
+    self->ctrl = (uint8_t*)(block + capacity * sizeof(Name##Entry)); \
+    self->capacity = capacity; \
+    memset(self->ctrl, HASHMAP_EMPTY, capacity + HASHMAP_GROUP); \
+\
+    /* The keys are known to be distinct, so only an empty slot is needed */ \
+    size_t mask = capacity - 1; \
+    for (size_t i = 0; i < old.capacity; ++i) { \
+        if (old.ctrl[i] & HASHMAP_EMPTY) continue; \
+\
+        uint64_t hash = hash_fn(old.entries[i].key); \
+        size_t pos = (hash >> 7) & mask; \
+        uint32_t empty; \
+        while (hashmap__group(self->ctrl + pos, 0, &empty), empty == 0) pos = (pos + HASHMAP_GROUP) & mask; \
+\
+        size_t slot = (pos + __builtin_ctz(empty)) & mask; \
+        self->entries[slot] = old.entries[i]; \
+        hashmap__set_ctrl(self->ctrl, capacity, slot, hash & 0x7f); \
+    } \
+\
+    if (old.entries != NULL) { \
+        if (self->allocator != NULL) allocator_free(self->allocator, old.entries, prefix##__block_size(old.capacity)); \
+        else free(old.entries); \
+    } \
+} \
+\
+Value* prefix##_get(Name* self, Key key) { \
+    if (self->count == 0) return NULL; \
+\
+    size_t hole; \
+    size_t i = prefix##__find(self, key, hash_fn(key), &hole); \
+    return i == SIZE_MAX ? NULL : &self->entries[i].value; \
+} \
+\
+Value* prefix##_put(Name* self, Key key, Value value) { \
+    if (self->capacity == 0) prefix##__resize(self, HASHMAP_GROUP); \
+\
+    uint64_t hash = hash_fn(key); \
+    size_t hole; \
+    size_t i = prefix##__find(self, key, hash, &hole); \
+    if (i != SIZE_MAX) { \
+        self->entries[i].value = value; \
+        return &self->entries[i].value; \
+    } \
+\
+    if ((self->count + 1) * 8 > self->capacity * HASHMAP_MAX_LOAD) { \
+        prefix##__resize(self, self->capacity * 2); \
+        prefix##__find(self, key, hash, &hole); \
+    } \
+\
+    self->entries[hole].key = key; \
+    self->entries[hole].value = value; \
+    hashmap__set_ctrl(self->ctrl, self->capacity, hole, hash & 0x7f); \
+    self->count++; \
+    return &self->entries[hole].value; \
+} \
+\
+bool prefix##_remove(Name* self, Key key) { \
+    if (self->count == 0) return false; \
+\
+    size_t hole; \
+    size_t i = prefix##__find(self, key, hash_fn(key), &hole); \
+    if (i == SIZE_MAX) return false; \
+\
+    /* Moves every later entry of the cluster that may live in the hole into it */ \
+    size_t mask = self->capacity - 1; \
+    hole = i; \
+    for (size_t j = (i + 1) & mask; !(self->ctrl[j] & HASHMAP_EMPTY); j = (j + 1) & mask) { \
+        size_t home = (hash_fn(self->entries[j].key) >> 7) & mask; \
+        if (((j - home) & mask) >= ((j - hole) & mask)) { \
+            self->entries[hole] = self->entries[j]; \
+            hashmap__set_ctrl(self->ctrl, self->capacity, hole, self->ctrl[j]); \
+            hole = j; \
+        } \
+    } \
+\
+    hashmap__set_ctrl(self->ctrl, self->capacity, hole, HASHMAP_EMPTY); \
+    self->count--; \
+    return true; \
+} \
+\
+void prefix##_reserve(Name* self, size_t count) { \
+    size_t capacity = HASHMAP_GROUP; \
+    while (count * 8 > capacity * HASHMAP_MAX_LOAD) capacity *= 2; \
+    if (capacity > self->capacity) prefix##__resize(self, capacity); \
+} \
+\
+void prefix##_clear(Name* self) { \
+    if (self->ctrl != NULL) memset(self->ctrl, HASHMAP_EMPTY, self->capacity + HASHMAP_GROUP); \
+    self->count = 0; \
+} \
+\
+void prefix##_free(Name* self) { \
+    if (self->entries != NULL) { \
+        if (self->allocator != NULL) allocator_free(self->allocator, self->entries, prefix##__block_size(self->capacity)); \
+        else free(self->entries); \
+    } \
+    self->entries = NULL; \
+    self->ctrl = NULL; \
+    self->count = 0; \
+    self->capacity = 0; \
+} \
+\
+Name##Entry* prefix##_next(Name* self, size_t* iter) { \
+    while (*iter < self->capacity) { \
+        size_t i = (*iter)++; \
+        if (!(self->ctrl[i] & HASHMAP_EMPTY)) return &self->entries[i]; \
+    } \
+    return NULL; \
+}
+
+#endif // HASHMAP_H_
@@ -0,0 +1,136 @@
+#ifndef HEAP_H_
+#define HEAP_H_
+#include <stddef.h>
+#include <assert.h>
+
+#ifndef DAH_H_
+#include "dah.h"
+#endif // DAH_H_
+
+// Priority queues over dah arrays, generated for an item type and a comparator:
+//
+//     #define timer_less(a, b) ((a).deadline < (b).deadline)
+//     HEAP_DECLARE(timers, Timer)                                  // in a header
+//     HEAP_IMPLEMENT(timers, Timer, timer_less, HEAP_NO_INDEX)     // in one .c file
+//
+// LESS(a, b) takes two items and puts the smallest on top. It's a macro or an
+// inline function, so comparisons get inlined. The heap is 4-ary, which halves
+// its depth and keeps the children of a node next to each other in memory.
+//
+// For decrease-key, SET_INDEX(item, i) is called every time an item lands on
+// index I. Store I in the item (or next to it) as its handle, change its key
+// and call prefix_update with it. Pass HEAP_NO_INDEX when nothing needs it.
+
+#define HEAP_ARITY 4
+#define HEAP_NO_INDEX(item, i) ((void)0)
+
+#define heap_len(heap) dah_getlen(heap)
+#define heap_peek(heap) (dah_getlen(heap) == 0 ? NULL : &(heap)[0])
+
+#define HEAP_DECLARE(prefix, Type) \
+void prefix##_push(Type** heap, Type item); \
+/* The heap mustn't be empty */ \
+Type prefix##_pop(Type* heap); \
+/* Pops up to K items into OUT, smallest first, returns how many it popped */ \
+size_t prefix##_pop_many(Type* heap, Type* out, size_t k); \
+/* Orders an array of items into a heap in O(n) */ \
+void prefix##_heapify(Type* heap); \
+/* Restores the order after the key of item I changed, either way */ \
+void prefix##_update(Type* heap, size_t i); \
+Type prefix##_remove(Type* heap, size_t i);
+
+#define HEAP_IMPLEMENT(prefix, Type, less, set_index) \
+/* Moves the hole at I up until ITEM fits in it */ \
+static void prefix##__sift_up(Type* heap, size_t i, Type item) { \
+    while (i > 0) { \
+        size_t parent = (i - 1) / HEAP_ARITY; \
+        if (!less(item, heap[parent])) break; \
+        heap[i] = heap[parent]; \
+        set_index(heap[i], i); \
+        i = parent; \
+    } \
+    heap[i] = item; \
+    set_index(heap[i], i); \
+} \
+\
+static void prefix##__sift_down(Type* heap, size_t count, size_t i, Type item) { \
+    while (true) { \
+        size_t first = i * HEAP_ARITY + 1; \
+        if (first >= count) break; \
+\
+        size_t last = first + HEAP_ARITY < count ? first + HEAP_ARITY : count; \
+        size_t best = first; \
+        for (size_t c = first + 1; c < last; ++c) { \
+            if (less(heap[c], heap[best])) best = c; \
+        } \
+\
+        if (!less(heap[best], item)) break; \
+        heap[i] = heap[best]; \
+        set_index(heap[i], i); \
+        i = best; \
+    } \
+    heap[i] = item; \
+    set_index(heap[i], i); \
+} \
+\
+void prefix##_push(Type** heap, Type item) { \
+    dah_append(*heap, item); \
+    prefix##__sift_up(*heap, dah_getlen(*heap) - 1, item); \
+} \
+\
+Type prefix##_pop(Type* heap) { \
+    DaHeader* header = dah_getheader(heap); \
+    assert(header->count > 0); \
+\
+    Type top = heap[0]; \
+    Type last = heap[--header->count]; \
+    if (header->count > 0) prefix##__sift_down(heap, header->count, 0, last); \
+    return top; \
+} \
+\
+size_t prefix##_pop_many(Type* heap, Type* out, size_t k) { \
+    size_t count = dah_getlen(heap); \
+    if (k > count) k = count; \
+    for (size_t i = 0; i < k; ++i) out[i] = prefix##_pop(heap); \
+    return k; \
+} \
+\
+void prefix##_heapify(Type* heap) { \
+    size_t count = dah_getlen(heap); \
+    if (count < 2) { \
+        if (count == 1) set_index(heap[0], 0); \
+        return; \
+    } \
+\
+    for (size_t i = (count - 2) / HEAP_ARITY + 1; i < count; ++i) set_index(heap[i], i); \
+    for (size_t i = (count - 2) / HEAP_ARITY + 1; i-- > 0;) { \
+        prefix##__sift_down(heap, count, i, heap[i]); \
+    } \
+} \
+\
+void prefix##_update(Type* heap, size_t i) { \
+    size_t count = dah_getlen(heap); \
+    assert(i < count); \
+\
+    Type item = heap[i]; \
+    if (i > 0 && less(item, heap[(i - 1) / HEAP_ARITY])) { \
+        prefix##__sift_up(heap, i, item); \
+    } else { \
+        prefix##__sift_down(heap, count, i, item); \
+    } \
+} \
+\
+Type prefix##_remove(Type* heap, size_t i) { \
+    DaHeader* header = dah_getheader(heap); \
+    assert(i < header->count); \
+\
+    Type removed = heap[i]; \
+    Type last = heap[--header->count]; \
+    if (i < header->count) { \
+        heap[i] = last; \
+        prefix##_update(heap, i); \
+    } \
+    return removed; \
+}
+
+#endif // HEAP_H_
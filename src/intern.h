@@ -0,0 +1,130 @@
+#ifndef INTERN_H_
+#define INTERN_H_
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef ARENA_H_
+#include "arena.h"
+#endif // ARENA_H_
+
+#ifndef DAH_H_
+#include "dah.h"
+#endif // DAH_H_
+
+#ifndef HASHMAP_H_
+#include "hashmap.h"
+#endif // HASHMAP_H_
+
+// A small number standing for an interned string, 0 is no string
+typedef uint32_t Atom;
+#define ATOM_NONE 0
+
+HASHMAP_DECLARE(InternMap, intern__map, StringView, Atom)
+
+// Keeps one copy of every distinct string in an arena. Interned strings with
+// the same contents share their atom and their pointer, so comparing them is
+// an integer or pointer compare. The copies are NUL terminated.
+typedef struct {
+    Arena arena;
+    InternMap map;
+    // Canonical view of every atom, at the atom's index minus 1
+    StringView* strings;
+    bool frozen;
+}Interner;
+
+// Returns the atom of SV, copying it in first if it's new.
+// A frozen interner doesn't take new strings, so it returns ATOM_NONE for them
+Atom intern_atom(Interner* self, StringView sv);
+// Returns the canonical view of SV, which can be compared by its start pointer.
+// An empty view with a NULL start if SV is new and the interner is frozen
+StringView intern(Interner* self, StringView sv);
+#define intern_cstr(interner, cstr) intern(interner, sv_from_cstr(cstr))
+// Returns ATOM_NONE if SV was never interned, never inserts
+Atom intern_find(Interner* self, StringView sv);
+StringView intern_str(Interner* self, Atom atom);
+#define intern_count(interner) dah_getlen((interner)->strings)
+// Points every piece of SPLIT at its canonical copy, and stores their atoms in ATOMS if it isn't NULL.
+// Once frozen, new pieces are left alone and get ATOM_NONE
+void intern_split(Interner* self, StringSplit* split, Atom* atoms);
+// Stops interning new strings. intern_find and intern_str only read from then
+// on, so any number of threads can call them without locking, once they know
+// the interner is frozen: either intern_is_frozen returned true on that thread,
+// or the thread was handed the interner after intern_freeze some other
+// synchronizing way (a mutex, pthread_create, a queue)
+void intern_freeze(Interner* self);
+bool intern_is_frozen(Interner* self);
+void intern_free(Interner* self);
+
+#endif // INTERN_H_
+
+#ifdef INTERN_IMPLEMENTATION
+#undef INTERN_IMPLEMENTATION
+
+#include <string.h>
+#include <assert.h>
+
+HASHMAP_IMPLEMENT(InternMap, intern__map, StringView, Atom, hashmap_hash_sv, hashmap_eq_sv)
+
+Atom intern_find(Interner* self, StringView sv) {
+    Atom* atom = intern__map_get(&self->map, sv);
+    return atom == NULL ? ATOM_NONE : *atom;
+}
+
+Atom intern_atom(Interner* self, StringView sv) {
+    if (intern_is_frozen(self)) return intern_find(self, sv);
+
+    Atom atom = intern_find(self, sv);
+    if (atom != ATOM_NONE) return atom;
+
+    char* copy = arena_alloc(&self->arena, sv.len + 1);
+    if (sv.len > 0) memcpy(copy, sv.start, sv.len);
+    copy[sv.len] = 0;
+
+    StringView canonical = {copy, sv.len};
+    dah_append(self->strings, canonical);
+    atom = (Atom)dah_getlen(self->strings);
+    intern__map_put(&self->map, canonical, atom);
+    return atom;
+}
+
+StringView intern(Interner* self, StringView sv) {
+    Atom atom = intern_atom(self, sv);
+    if (atom == ATOM_NONE) {
+        StringView none = {0};
+        return none;
+    }
+    return intern_str(self, atom);
+}
+
+StringView intern_str(Interner* self, Atom atom) {
+    assert(atom != ATOM_NONE && atom <= dah_getlen(self->strings));
+    return self->strings[atom - 1];
+}
+
+void intern_split(Interner* self, StringSplit* split, Atom* atoms) {
+    for (size_t i = 0; i < split->count; ++i) {
+        Atom atom = intern_atom(self, split->items[i]);
+        if (atom != ATOM_NONE) split->items[i] = self->strings[atom - 1];
+        if (atoms != NULL) atoms[i] = atom;
+    }
+}
+
+void intern_freeze(Interner* self) {
+    // Pairs with the acquire in intern_is_frozen, so a reader that sees the
+    // flag also sees every string and map entry written before it
+    __atomic_store_n(&self->frozen, true, __ATOMIC_RELEASE);
+}
+
+bool intern_is_frozen(Interner* self) {
+    return __atomic_load_n(&self->frozen, __ATOMIC_ACQUIRE);
+}
+
+void intern_free(Interner* self) {
+    intern__map_free(&self->map);
+    dah_free(self->strings);
+    arena_free(&self->arena);
+    self->frozen = false;
+}
+
+#endif // INTERN_IMPLEMENTATION
@@ -3,16 +3,39 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
 
 #ifndef LINEAR_DEFAULT_CAPACITY
 #define LINEAR_DEFAULT_CAPACITY (1 << 20)
 #endif // LINEAR_DEFAULT_CAPACITY
 
+// Capacity of every chunk of a SharedLinear, in bytes
+#ifndef SHARED_LINEAR_CHUNK_SIZE
+#define SHARED_LINEAR_CHUNK_SIZE (1 << 20)
+#endif // SHARED_LINEAR_CHUNK_SIZE
+
+#ifndef LINEAR_CACHE_LINE
+#define LINEAR_CACHE_LINE 64
+#endif // LINEAR_CACHE_LINE
+
 #ifndef LINEAR_ASSERT
 #include <assert.h>
 #define LINEAR_ASSERT(expr) assert(expr)
 #endif // LINEAR_ASSERT
 
+#ifndef LINEAR_THREAD_LOCAL
+#ifdef __cplusplus
+#define LINEAR_THREAD_LOCAL thread_local
+#else // __cplusplus
+#define LINEAR_THREAD_LOCAL _Thread_local
+#endif // __cplusplus
+#endif // LINEAR_THREAD_LOCAL
+
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
 #ifndef cast
 #ifdef __cplusplus
 #define cast(Type, thing) reinterpret_cast<Type>(thing)
@@ -25,10 +48,29 @@
 extern "C" {
 #endif // __cplusplus
 
+#ifdef LINEAR_STATS
+typedef struct {
+    // Bytes asked for by the caller
+    size_t requested;
+    // Bytes taken from the buffer, including rounding and alignment padding
+    size_t consumed;
+    size_t peak;
+    size_t rewinds;
+    // Allocations that didn't fit
+    size_t failed;
+}LinearStats;
+#endif // LINEAR_STATS
+
 typedef struct {
     size_t size;
     size_t capacity;
     uintptr_t* mem;
+    // Length of the file mapping MEM lives in, 0 when it was malloc'd
+    size_t mapped;
+
+#ifdef LINEAR_STATS
+    LinearStats stats;
+#endif // LINEAR_STATS
 }Linear;
 
 #define linear_alloc(linear, Type) (Type*)linear_allocb(linear, sizeof(Type))
@@ -37,34 +79,132 @@ typedef struct {
 #define linear_alloc_array(linear, n, Type) (Type*)linear_allocb(linear, sizeof(Type) * (n))
 #define linear_calloc_array(linear, n, Type) (Type*)linear_callocb(linear, sizeof(Type) * (n))
 
+#define linear_alloc_aligned_array(linear, n, Type, align) (Type*)linear_alloc_aligned(linear, sizeof(Type) * (n), align)
+#define linear_calloc_aligned_array(linear, n, Type, align) (Type*)linear_calloc_aligned(linear, sizeof(Type) * (n), align)
+// Allocates whole cache lines, so the memory doesn't share a line with any other allocation
+#define linear_alloc_cacheline(linear, size) \
+    linear_alloc_aligned(linear, ((size) + LINEAR_CACHE_LINE - 1) & ~(size_t)(LINEAR_CACHE_LINE - 1), LINEAR_CACHE_LINE)
+
 #define linear_occupied(linear) (LINEAR_ASSERT((linear) != NULL), (linear)->size*sizeof(uintptr_t))
 #define linear_can_alloc(linear, Type) linear_can_allocb(linear, sizeof(Type))
 
 Linear linear_new(size_t capacity);
 void linear_prealloc(Linear* self, size_t capacity);
 char* linear_strdup(Linear* self, const char* cstr);
+// Formats straight into the free space, returns NULL if the string doesn't fit
+__attribute__((format(printf, 2, 3)))
 char* linear_sprintf(Linear* self, const char* fmt, ...);
+char* linear_vsprintf(Linear* self, const char* fmt, va_list args);
 
 size_t linear_snapshot(Linear* self);
 void linear_rewind(Linear* self, size_t offset);
 
 void linear_free(Linear* self);
+#ifdef LINEAR_STATS
+void linear_stats_dump(Linear* self, FILE* sink);
+#endif // LINEAR_STATS
 #define linear_reset(linear) ((linear)->size = 0)
 
 void* linear_allocb(Linear* self, size_t size);
 void* linear_callocb(Linear* self, size_t size);
+// Grows or shrinks PTR in place when it's the last allocation, otherwise copies it to new memory
+void* linear_reallocb(Linear* self, size_t oldsize, size_t newsize, void* ptr);
+
+// Allocator for containers that live on SELF. Freeing only reclaims the last allocation
+Allocator linear_allocator(Linear* self);
+// Allocates memory aligned to ALIGN, which must be a power of two
+void* linear_alloc_aligned(Linear* self, size_t size, size_t align);
+void* linear_calloc_aligned(Linear* self, size_t size, size_t align);
 void* linear_memdupb(Linear* self, void* mem, size_t size);
 bool linear_can_allocb(Linear* self, size_t size);
 
-extern Linear temp_linear;
-#define temp_prealloc(size) linear_prealloc(&temp_linear, size)
-#define temp_alloc(Type) linear_alloc(&temp_linear, Type)
-#define temp_allocb(size) linear_allocb(&temp_linear, size)
-#define temp_sprintf(...) linear_sprintf(&temp_linear, __VA_ARGS__)
+// Byte offsets of memory inside SELF, they stay the same after saving and loading
+size_t linear_get_offset(Linear* self, void* thing);
+void* linear_from_offset(Linear* self, size_t offset);
+void* linear_exportb(Linear* self, size_t offset, size_t size);
+
+#define LINEAR_FILE_MAGIC 0x3152414e494c /* "LINAR1" */
+#define LINEAR_FILE_VERSION 1
+// Keeps the buffer cache line aligned after the header in the mapping
+#define LINEAR_FILE_HEADER_SIZE 64
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t word_size;
+    // Bytes of the buffer following the header
+    uint64_t size;
+    // FNV-1a of those bytes
+    uint64_t checksum;
+}LinearFileHeader;
+
+// Flags for linear_load
+#define LINEAR_LOAD_COW (1 << 0) // Writable, changes stay in this process
+#define LINEAR_LOAD_VERIFY (1 << 1) // Checks the checksum, which reads the whole file
+
+// Writes the used part of SELF to FILEPATH
+bool linear_save(Linear* self, const char* filepath);
+// Maps a file written by linear_save, read-only unless LINEAR_LOAD_COW is given.
+// Pages are read on first touch. The loaded Linear is full, linear_free unmaps it.
+// Whatever SELF held before is freed once the load succeeds, and kept if it fails.
+bool linear_load(Linear* self, const char* filepath, int flags);
+
+// Pointers stored as the distance from themselves, so they stay valid wherever the
+// buffer is mapped. Both ends have to live in the same buffer, 0 is NULL.
+#define LinearRel(Type) union { ptrdiff_t offset; Type* type_; }
+#define linear_rel_set(rel, ptr) \
+    ((rel).offset = (ptr) == NULL ? 0 : cast(char*, ptr) - cast(char*, &(rel)))
+#define linear_rel_get(rel) \
+    cast(__typeof__((rel).type_), (rel).offset == 0 ? NULL : cast(char*, &(rel)) + (rel).offset)
+
+// Every thread gets its own temp_linear, freed when the thread exits
+extern LINEAR_THREAD_LOCAL Linear temp_linear;
+Linear* linear_temp(void);
+#define temp_prealloc(size) linear_prealloc(linear_temp(), size)
+#define temp_alloc(Type) linear_alloc(linear_temp(), Type)
+#define temp_allocb(size) linear_allocb(linear_temp(), size)
+#define temp_sprintf(...) linear_sprintf(linear_temp(), __VA_ARGS__)
 #define temp_snapshot() linear_snapshot(&temp_linear)
 #define temp_rewind(offset) linear_rewind(&temp_linear, offset)
 #define temp_free() linear_free(&temp_linear)
 
+typedef struct linear_chunk_s {
+    struct linear_chunk_s* next;
+    size_t capacity;
+    // Reserved words, runs past capacity once the chunk is full
+    size_t size;
+    // Words handed out before the chunk filled up, set by the reservation that didn't fit
+    size_t used;
+    uintptr_t mem[];
+}LinearChunk;
+
+// A bump allocator many threads can allocate from at once.
+// Space is reserved with an atomic add, and a full chunk is replaced with a
+// compare-and-swap, so allocating never takes a lock.
+typedef struct {
+    // Newest first
+    LinearChunk* chunks;
+}SharedLinear;
+
+typedef struct {
+    LinearChunk* chunk;
+    size_t size;
+}SharedLinearSnapshot;
+
+#define shared_linear_alloc(shared, Type) (Type*)shared_linear_allocb(shared, sizeof(Type))
+#define shared_linear_alloc_array(shared, n, Type) (Type*)shared_linear_allocb(shared, sizeof(Type) * (n))
+// Bytes handed out from a chunk
+#define linear_chunk_occupied(chunk) \
+    (((chunk)->size <= (chunk)->capacity ? (chunk)->size : (chunk)->used)*sizeof(uintptr_t))
+
+void* shared_linear_allocb(SharedLinear* self, size_t size);
+
+// The following need every thread to be done allocating from SELF
+SharedLinearSnapshot shared_linear_snapshot(SharedLinear* self);
+void shared_linear_rewind(SharedLinear* self, SharedLinearSnapshot snapshot);
+void shared_linear_reset(SharedLinear* self);
+void shared_linear_free(SharedLinear* self);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -77,9 +217,54 @@ extern Linear temp_linear;
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
+#ifndef __cplusplus
+#include <stdalign.h>
+#endif // __cplusplus
 #include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+LINEAR_THREAD_LOCAL Linear temp_linear = {0};
+static LINEAR_THREAD_LOCAL bool linear__temp_registered = false;
+static pthread_key_t linear__temp_key;
+static pthread_once_t linear__temp_once = PTHREAD_ONCE_INIT;
+
+static void linear__temp_destroy(void* temp) {
+    linear_free(cast(Linear*, temp));
+}
+
+static void linear__temp_create_key(void) {
+    int err = pthread_key_create(&linear__temp_key, linear__temp_destroy);
+    LINEAR_ASSERT(err == 0);
+    (void)err;
+}
+
+Linear* linear_temp(void) {
+    if (!linear__temp_registered) {
+        // The key's destructor only runs for threads that set a value
+        pthread_once(&linear__temp_once, linear__temp_create_key);
+        pthread_setspecific(linear__temp_key, &temp_linear);
+        linear__temp_registered = true;
+    }
+    return &temp_linear;
+}
+
+#ifdef LINEAR_STATS
+#define LINEAR__STAT(stmt) stmt
 
-Linear temp_linear = {0};
+static void linear__stats_alloc(Linear* self, size_t size, size_t before) {
+    LinearStats* stats = &self->stats;
+    stats->requested += size;
+    stats->consumed += (self->size - before)*sizeof(uintptr_t);
+    if (self->size*sizeof(uintptr_t) > stats->peak) stats->peak = self->size*sizeof(uintptr_t);
+}
+#else
+#define LINEAR__STAT(stmt)
+#endif // LINEAR_STATS
 
 Linear linear_new(size_t capacity) {
     Linear a = {0};
@@ -101,6 +286,7 @@ size_t linear_snapshot(Linear* self) {
 }
 
 void linear_rewind(Linear* self, size_t offset) {
+    LINEAR__STAT(self->stats.rewinds++);
     self->size = offset;
 }
 
@@ -111,14 +297,99 @@ void* linear_allocb(Linear* self, size_t size) {
     size_t real_size = (size + word_size - 1)/word_size;
 
     if (self->size + real_size > self->capacity) {
+        LINEAR__STAT(self->stats.failed++);
         return NULL;
     }
 
     size_t i = self->size;
     self->size += real_size;
+    LINEAR__STAT(linear__stats_alloc(self, size, i));
+    return cast(void*, self->mem + i);
+}
+
+// Reallocations that have to move get ALIGN, same as the original allocation
+static void* linear__realloc_aligned(Linear* self, size_t oldsize, size_t newsize, void* ptr, size_t align) {
+    if (ptr == NULL) return linear_alloc_aligned(self, newsize, align);
+
+    size_t word_size = sizeof(uintptr_t);
+    uintptr_t* p = cast(uintptr_t*, ptr);
+    if (p + (oldsize + word_size - 1)/word_size == self->mem + self->size) {
+        size_t end = (p - self->mem) + (newsize + word_size - 1)/word_size;
+        if (end > self->capacity) {
+            LINEAR__STAT(self->stats.failed++);
+            return NULL;
+        }
+
+        LINEAR__STAT(size_t before = self->size);
+        self->size = end;
+        LINEAR__STAT(if (end > before) linear__stats_alloc(self, newsize - oldsize, before));
+        return ptr;
+    }
+
+    void* newptr = linear_alloc_aligned(self, newsize, align);
+    if (newptr == NULL) return NULL;
+
+    memcpy(newptr, ptr, oldsize < newsize ? oldsize : newsize);
+    return newptr;
+}
+
+void* linear_reallocb(Linear* self, size_t oldsize, size_t newsize, void* ptr) {
+    return linear__realloc_aligned(self, oldsize, newsize, ptr, sizeof(uintptr_t));
+}
+
+static void* linear__allocator_alloc(void* ctx, size_t size) {
+    return linear_alloc_aligned(cast(Linear*, ctx), size, alignof(max_align_t));
+}
+
+static void* linear__allocator_realloc(void* ctx, void* ptr, size_t oldsize, size_t newsize) {
+    return linear__realloc_aligned(cast(Linear*, ctx), oldsize, newsize, ptr, alignof(max_align_t));
+}
+
+static void linear__allocator_free(void* ctx, void* ptr, size_t size) {
+    Linear* self = cast(Linear*, ctx);
+    size_t word_size = sizeof(uintptr_t);
+    uintptr_t* p = cast(uintptr_t*, ptr);
+    if (p != NULL && p + (size + word_size - 1)/word_size == self->mem + self->size) {
+        self->size = p - self->mem;
+    }
+}
+
+Allocator linear_allocator(Linear* self) {
+    Allocator allocator = {linear__allocator_alloc, linear__allocator_realloc, linear__allocator_free, self};
+    return allocator;
+}
+
+void* linear_alloc_aligned(Linear* self, size_t size, size_t align) {
+    if (self->mem == NULL) linear_prealloc(self, LINEAR_DEFAULT_CAPACITY);
+
+    size_t word_size = sizeof(uintptr_t);
+    LINEAR_ASSERT((align & (align - 1)) == 0 && "alignment must be a power of two");
+    if (align < word_size) align = word_size;
+
+    uintptr_t p = cast(uintptr_t, self->mem + self->size);
+    size_t padding = ((align - (p & (align - 1))) & (align - 1))/word_size;
+    size_t real_size = (size + word_size - 1)/word_size;
+
+    if (self->size + padding + real_size > self->capacity) {
+        LINEAR__STAT(self->stats.failed++);
+        return NULL;
+    }
+
+    LINEAR__STAT(size_t before = self->size);
+    size_t i = self->size + padding;
+    self->size = i + real_size;
+    LINEAR__STAT(linear__stats_alloc(self, size, before));
     return cast(void*, self->mem + i);
 }
 
+void* linear_calloc_aligned(Linear* self, size_t size, size_t align) {
+    void* p = linear_alloc_aligned(self, size, align);
+    if (p == NULL) return NULL;
+
+    memset(p, 0, size);
+    return p;
+}
+
 void* linear_callocb(Linear* self, size_t size) {
     void* p = linear_allocb(self, size);
     memset(p, 0, size);
@@ -142,32 +413,142 @@ char* linear_strdup(Linear* self, const char* cstr) {
     return dup;
 }
 
+char* linear_vsprintf(Linear* self, const char* fmt, va_list args) {
+    if (self->mem == NULL) linear_prealloc(self, LINEAR_DEFAULT_CAPACITY);
+
+    char* start = cast(char*, self->mem + self->size);
+    size_t room = (self->capacity - self->size)*sizeof(uintptr_t);
+    int n = vsnprintf(start, room, fmt, args);
+    if (n < 0 || (size_t)n >= room) {
+        LINEAR__STAT(self->stats.failed++);
+        return NULL;
+    }
+
+    // The string is already in place, this only claims it
+    return linear_alloc_array(self, n + 1, char);
+}
+
 char* linear_sprintf(Linear* self, const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    int n = vsnprintf(NULL, 0, fmt, args);
-    va_end(args);
-
-    va_start(args, fmt);
-    char* cstr = linear_alloc_array(self, n + 1, char);
-    vsnprintf(cstr, n + 1, fmt, args);
+    char* cstr = linear_vsprintf(self, fmt, args);
     va_end(args);
-
     return cstr;
 }
 
 size_t linear_get_offset(Linear* self, void* thing) {
-    assert((uint8_t*)self->mem <= (uint8_t*)thing && (uint8_t*)thing < (uint8_t*)self->mem + self->capacity);
+    LINEAR_ASSERT(cast(char*, self->mem) <= cast(char*, thing) &&
+                  cast(char*, thing) <= cast(char*, self->mem + self->capacity));
 
     return cast(char*, thing) - cast(char*, self->mem);
 }
 
+void* linear_from_offset(Linear* self, size_t offset) {
+    LINEAR_ASSERT(offset <= self->capacity*sizeof(uintptr_t));
+    return cast(char*, self->mem) + offset;
+}
+
 void* linear_exportb(Linear* self, size_t offset, size_t size) {
     void* mem = malloc(size);
-    memcpy(mem, self->mem + offset, size);
+    memcpy(mem, linear_from_offset(self, offset), size);
     return mem;
 }
 
+static uint64_t linear__checksum(const void* data, size_t size) {
+    const unsigned char* bytes = cast(const unsigned char*, data);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool linear_save(Linear* self, const char* filepath) {
+    size_t size = self->size*sizeof(uintptr_t);
+
+    char header[LINEAR_FILE_HEADER_SIZE] = {0};
+    LinearFileHeader info = {LINEAR_FILE_MAGIC, LINEAR_FILE_VERSION, sizeof(uintptr_t), size, 0};
+    info.checksum = linear__checksum(self->mem, size);
+    memcpy(header, &info, sizeof(info));
+
+    FILE* f = fopen(filepath, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    if (fwrite(header, 1, sizeof(header), f) != sizeof(header) ||
+        (size > 0 && fwrite(self->mem, 1, size, f) != size)) {
+        fprintf(stderr, "Couldn't write %s: %s\n", filepath, strerror(errno));
+        fclose(f);
+        return false;
+    }
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Couldn't write %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool linear_load(Linear* self, const char* filepath, int flags) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Couldn't open %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        fprintf(stderr, "Couldn't stat %s: %s\n", filepath, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    LinearFileHeader info = {0};
+    if ((size_t)st.st_size < LINEAR_FILE_HEADER_SIZE || read(fd, &info, sizeof(info)) != sizeof(info)) {
+        fprintf(stderr, "Couldn't load %s: file is too short\n", filepath);
+        close(fd);
+        return false;
+    }
+
+    if (info.magic != LINEAR_FILE_MAGIC || info.version != LINEAR_FILE_VERSION || info.word_size != sizeof(uintptr_t)) {
+        fprintf(stderr, "Couldn't load %s: not a linear buffer of this version\n", filepath);
+        close(fd);
+        return false;
+    }
+
+    size_t length = LINEAR_FILE_HEADER_SIZE + info.size;
+    if ((size_t)st.st_size < length) {
+        fprintf(stderr, "Couldn't load %s: file is truncated\n", filepath);
+        close(fd);
+        return false;
+    }
+
+    int prot = flags & LINEAR_LOAD_COW ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* map = mmap(NULL, length, prot, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Couldn't map %s: %s\n", filepath, strerror(errno));
+        return false;
+    }
+
+    uintptr_t* mem = cast(uintptr_t*, cast(char*, map) + LINEAR_FILE_HEADER_SIZE);
+    if (flags & LINEAR_LOAD_VERIFY && linear__checksum(mem, info.size) != info.checksum) {
+        fprintf(stderr, "Couldn't load %s: checksum mismatch\n", filepath);
+        munmap(map, length);
+        return false;
+    }
+
+    linear_free(self);
+    self->mem = mem;
+    self->size = info.size/sizeof(uintptr_t);
+    self->capacity = self->size;
+    self->mapped = length;
+    return true;
+}
+
 
 bool linear_can_allocb(Linear* a, size_t size) {
     size_t word_size = sizeof(uintptr_t);
@@ -175,11 +556,99 @@ bool linear_can_allocb(Linear* a, size_t size) {
     return a->size + real_size < a->capacity;
 }
 
+#ifdef LINEAR_STATS
+void linear_stats_dump(Linear* self, FILE* sink) {
+    LinearStats* stats = &self->stats;
+    fprintf(sink, "Linear stats:\n");
+    fprintf(sink, "    requested: %zu bytes\n", stats->requested);
+    fprintf(sink, "    consumed: %zu bytes\n", stats->consumed);
+    fprintf(sink, "    in use: %zu of %zu bytes (peak %zu bytes)\n",
+            self->size*sizeof(uintptr_t), self->capacity*sizeof(uintptr_t), stats->peak);
+    fprintf(sink, "    rewinds: %zu, failed allocations: %zu\n", stats->rewinds, stats->failed);
+}
+#endif // LINEAR_STATS
+
 void linear_free(Linear* self) {
-    free(self->mem);
+    if (self->mapped > 0) {
+        munmap(cast(char*, self->mem) - LINEAR_FILE_HEADER_SIZE, self->mapped);
+    } else {
+        free(self->mem);
+    }
     self->mem = NULL;
+    self->mapped = 0;
     self->size = 0;
     self->capacity = 0;
 }
+
+void* shared_linear_allocb(SharedLinear* self, size_t size) {
+    size_t word_size = sizeof(uintptr_t);
+    size_t real_size = (size + word_size - 1)/word_size;
+
+    LinearChunk* chunk = __atomic_load_n(&self->chunks, __ATOMIC_ACQUIRE);
+    while (true) {
+        if (chunk != NULL) {
+            // A failed reservation leaves size past capacity, which seals the chunk for everyone
+            size_t i = __atomic_fetch_add(&chunk->size, real_size, __ATOMIC_RELAXED);
+            if (i + real_size <= chunk->capacity) return cast(void*, chunk->mem + i);
+            // Only the first reservation that doesn't fit starts at or before capacity
+            if (i <= chunk->capacity) __atomic_store_n(&chunk->used, i, __ATOMIC_RELAXED);
+        }
+
+        size_t capacity = SHARED_LINEAR_CHUNK_SIZE/word_size;
+        if (capacity < real_size) capacity = real_size;
+
+        LinearChunk* fresh = cast(LinearChunk*, malloc(sizeof(LinearChunk) + capacity*word_size));
+        LINEAR_ASSERT(fresh != NULL);
+        fresh->next = chunk;
+        fresh->capacity = capacity;
+        fresh->size = real_size;
+        fresh->used = 0;
+
+        if (__atomic_compare_exchange_n(&self->chunks, &chunk, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return cast(void*, fresh->mem);
+        }
+
+        // Another thread replaced the chunk first, CHUNK now holds its one
+        free(fresh);
+    }
+}
+
+SharedLinearSnapshot shared_linear_snapshot(SharedLinear* self) {
+    SharedLinearSnapshot snapshot = {self->chunks, 0};
+    if (snapshot.chunk != NULL) {
+        snapshot.size = linear_chunk_occupied(snapshot.chunk)/sizeof(uintptr_t);
+    }
+    return snapshot;
+}
+
+void shared_linear_rewind(SharedLinear* self, SharedLinearSnapshot snapshot) {
+    while (self->chunks != snapshot.chunk) {
+        LinearChunk* next = self->chunks->next;
+        free(self->chunks);
+        self->chunks = next;
+    }
+
+    if (self->chunks != NULL) self->chunks->size = snapshot.size;
+}
+
+void shared_linear_reset(SharedLinear* self) {
+    if (self->chunks == NULL) return;
+
+    LinearChunk* chunk = self->chunks->next;
+    while (chunk != NULL) {
+        LinearChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    self->chunks->next = NULL;
+    self->chunks->size = 0;
+}
+
+void shared_linear_free(SharedLinear* self) {
+    shared_linear_reset(self);
+    free(self->chunks);
+    self->chunks = NULL;
+}
 #endif // LINEAR_IMPLEMENTATION
 
@@ -0,0 +1,175 @@
+#ifndef POOL_H_
+#define POOL_H_
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifndef ARENA_H_
+#include "arena.h"
+#endif // ARENA_H_
+
+// Objects a PoolCache moves to and from the shared depot at once
+#ifndef POOL_BATCH_SIZE
+#define POOL_BATCH_SIZE 32
+#endif // POOL_BATCH_SIZE
+
+#ifndef POOL_ASSERT
+#include <assert.h>
+#define POOL_ASSERT assert
+#endif // POOL_ASSERT
+
+typedef struct pool_node_s {
+    struct pool_node_s* next;
+    // Links the first nodes of the batches in the depot
+    struct pool_node_s* next_batch;
+}PoolNode;
+
+// Fixed-size objects slab-allocated from an arena and recycled through free lists.
+// pool_alloc/pool_free are for a single thread. Other threads go through their
+// own PoolCache, which only locks the pool to trade whole batches with the depot.
+typedef struct {
+    Arena arena;
+    size_t item_size;
+    size_t item_align;
+
+    PoolNode* free;
+
+    pthread_mutex_t lock;
+    PoolNode* depot;
+}Pool;
+
+typedef struct {
+    Pool* pool;
+    PoolNode* free;
+    size_t count;
+}PoolCache;
+
+void pool_init(Pool* self, size_t item_size, size_t item_align);
+#define pool_init_for(pool, Type) pool_init(pool, sizeof(Type), _Alignof(Type))
+void* pool_alloc(Pool* self);
+void pool_free(Pool* self, void* item);
+// Frees the memory of every object at once
+void pool_destroy(Pool* self);
+
+PoolCache pool_cache_new(Pool* pool);
+void* pool_cache_alloc(PoolCache* self);
+void pool_cache_free(PoolCache* self, void* item);
+// Hands every cached object back to the depot, call it before the thread exits
+void pool_cache_flush(PoolCache* self);
+
+#endif // POOL_H_
+
+#ifdef POOL_IMPLEMENTATION
+#undef POOL_IMPLEMENTATION
+
+void pool_init(Pool* self, size_t item_size, size_t item_align) {
+    if (item_align < _Alignof(PoolNode)) item_align = _Alignof(PoolNode);
+    if (item_size < sizeof(PoolNode)) item_size = sizeof(PoolNode);
+    item_size = (item_size + item_align - 1) & ~(item_align - 1);
+
+    Arena arena = {0};
+    self->arena = arena;
+    self->item_size = item_size;
+    self->item_align = item_align;
+    self->free = NULL;
+    self->depot = NULL;
+    pthread_mutex_init(&self->lock, NULL);
+}
+
+// Takes a batch from the depot, or carves a new one from the arena. Needs the lock
+static PoolNode* pool__take_batch(Pool* self) {
+    PoolNode* batch = self->depot;
+    if (batch != NULL) {
+        self->depot = batch->next_batch;
+        return batch;
+    }
+
+    char* slab = arena_alloc_aligned(&self->arena, self->item_size * POOL_BATCH_SIZE, self->item_align);
+    POOL_ASSERT(slab != NULL);
+
+    for (size_t i = 0; i < POOL_BATCH_SIZE; ++i) {
+        PoolNode* node = (PoolNode*)(slab + i * self->item_size);
+        node->next = i + 1 < POOL_BATCH_SIZE ? (PoolNode*)(slab + (i + 1) * self->item_size) : NULL;
+    }
+    return (PoolNode*)slab;
+}
+
+static void pool__give_batch(Pool* self, PoolNode* batch) {
+    pthread_mutex_lock(&self->lock);
+    batch->next_batch = self->depot;
+    self->depot = batch;
+    pthread_mutex_unlock(&self->lock);
+}
+
+void* pool_alloc(Pool* self) {
+    if (self->free == NULL) {
+        pthread_mutex_lock(&self->lock);
+        self->free = pool__take_batch(self);
+        pthread_mutex_unlock(&self->lock);
+    }
+
+    PoolNode* node = self->free;
+    self->free = node->next;
+    return node;
+}
+
+void pool_free(Pool* self, void* item) {
+    PoolNode* node = item;
+    node->next = self->free;
+    self->free = node;
+}
+
+void pool_destroy(Pool* self) {
+    arena_free(&self->arena);
+    pthread_mutex_destroy(&self->lock);
+    self->free = NULL;
+    self->depot = NULL;
+}
+
+PoolCache pool_cache_new(Pool* pool) {
+    PoolCache cache = {pool, NULL, 0};
+    return cache;
+}
+
+void* pool_cache_alloc(PoolCache* self) {
+    if (self->free == NULL) {
+        pthread_mutex_lock(&self->pool->lock);
+        self->free = pool__take_batch(self->pool);
+        pthread_mutex_unlock(&self->pool->lock);
+
+        self->count = 0;
+        for (PoolNode* node = self->free; node != NULL; node = node->next) self->count++;
+    }
+
+    PoolNode* node = self->free;
+    self->free = node->next;
+    self->count--;
+    return node;
+}
+
+void pool_cache_free(PoolCache* self, void* item) {
+    PoolNode* node = item;
+    node->next = self->free;
+    self->free = node;
+    self->count++;
+
+    // Keep a batch around, so alternating alloc/free doesn't bounce on the depot
+    if (self->count >= 2 * POOL_BATCH_SIZE) {
+        PoolNode* batch = self->free;
+        PoolNode* last = batch;
+        for (size_t i = 1; i < POOL_BATCH_SIZE; ++i) last = last->next;
+
+        self->free = last->next;
+        self->count -= POOL_BATCH_SIZE;
+        last->next = NULL;
+        pool__give_batch(self->pool, batch);
+    }
+}
+
+void pool_cache_flush(PoolCache* self) {
+    if (self->free != NULL) pool__give_batch(self->pool, self->free);
+    self->free = NULL;
+    self->count = 0;
+}
+
+#endif // POOL_IMPLEMENTATION
@@ -0,0 +1,125 @@
+#ifndef SOA_H_
+#define SOA_H_
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Struct-of-arrays containers generated from a field list, so loops over one
+// field only touch that field's memory. A field list takes the expander as its
+// argument, in the form X(Type, name):
+//
+//     #define PARTICLE_FIELDS(X) X(float, x) X(float, y) X(int, id)
+//     SOA_DECLARE(Particles, particles, PARTICLE_FIELDS)   // in a header
+//     SOA_IMPLEMENT(Particles, particles, PARTICLE_FIELDS) // in one .c file
+//
+// Particles then has a pointer per column (self.x, self.y, self.id) and
+// ParticlesRow holds one record for particles_append/particles_get.
+
+// Every column starts at this alignment, in bytes
+#ifndef SOA_ALIGN
+#define SOA_ALIGN 64
+#endif // SOA_ALIGN
+
+#ifndef SOA_INIT_CAPACITY
+#define SOA_INIT_CAPACITY 16
+#endif // SOA_INIT_CAPACITY
+
+// Has to take sizes that are a multiple of SOA_ALIGN, like aligned_alloc
+#ifndef SOA_ALIGNED_ALLOC
+#define SOA_ALIGNED_ALLOC aligned_alloc
+#endif // SOA_ALIGNED_ALLOC
+
+#ifndef SOA_FREE
+#define SOA_FREE free
+#endif // SOA_FREE
+
+static inline size_t soa__align_up(size_t size) {
+    return (size + SOA_ALIGN - 1) & ~(size_t)(SOA_ALIGN - 1);
+}
+
+#define SOA__COLUMN(Type, name) Type* name;
+#define SOA__ROW_FIELD(Type, name) Type name;
+#define SOA__COLUMN_SIZE(Type, name) size = soa__align_up(size) + capacity * sizeof(Type);
+#define SOA__MOVE_COLUMN(Type, name) \
+    size = soa__align_up(size); \
+    if (self->count > 0) memcpy(block + size, self->name, self->count * sizeof(Type)); \
+    self->name = (Type*)(block + size); \
+    size += capacity * sizeof(Type);
+#define SOA__STORE(Type, name) self->name[i] = row.name;
+#define SOA__LOAD(Type, name) row.name = self->name[i];
+#define SOA__SWAP_LAST(Type, name) self->name[i] = self->name[self->count - 1];
+
+// Declares Name, NameRow and the prefix_ functions
+#define SOA_DECLARE(Name, prefix, FIELDS) \
+typedef struct { \
+    size_t count, capacity; \
+    /* Every column lives in this one allocation */ \
+    char* block; \
+    FIELDS(SOA__COLUMN) \
+}Name; \
+\
+typedef struct { \
+    FIELDS(SOA__ROW_FIELD) \
+}Name##Row; \
+\
+/* Makes room for CAPACITY records in total */ \
+void prefix##_reserve(Name* self, size_t capacity); \
+/* Returns the index of the new record */ \
+size_t prefix##_append(Name* self, Name##Row row); \
+Name##Row prefix##_get(Name* self, size_t i); \
+void prefix##_set(Name* self, size_t i, Name##Row row); \
+/* Moves the last record into I, so records don't keep their order */ \
+void prefix##_swap_remove(Name* self, size_t i); \
+void prefix##_free(Name* self);
+
+#define SOA_IMPLEMENT(Name, prefix, FIELDS) \
+void prefix##_reserve(Name* self, size_t capacity) { \
+    if (capacity <= self->capacity) return; \
+\
+    size_t size = 0; \
+    FIELDS(SOA__COLUMN_SIZE) \
+    char* block = (char*)SOA_ALIGNED_ALLOC(SOA_ALIGN, soa__align_up(size)); \
+    assert(block != NULL); \
+\
+    size = 0; \
+    FIELDS(SOA__MOVE_COLUMN) \
+    SOA_FREE(self->block); \
+    self->block = block; \
+    self->capacity = capacity; \
+} \
+\
+size_t prefix##_append(Name* self, Name##Row row) { \
+    if (self->count == self->capacity) { \
+        prefix##_reserve(self, self->capacity == 0 ? SOA_INIT_CAPACITY : self->capacity * 2); \
+    } \
+\
+    size_t i = self->count++; \
+    FIELDS(SOA__STORE) \
+    return i; \
+} \
+\
+Name##Row prefix##_get(Name* self, size_t i) { \
+    assert(i < self->count); \
+    Name##Row row; \
+    FIELDS(SOA__LOAD) \
+    return row; \
+} \
+\
+void prefix##_set(Name* self, size_t i, Name##Row row) { \
+    assert(i < self->count); \
+    FIELDS(SOA__STORE) \
+} \
+\
+void prefix##_swap_remove(Name* self, size_t i) { \
+    assert(i < self->count); \
+    FIELDS(SOA__SWAP_LAST) \
+    self->count--; \
+} \
+\
+void prefix##_free(Name* self) { \
+    SOA_FREE(self->block); \
+    memset(self, 0, sizeof(*self)); \
+}
+
+#endif // SOA_H_
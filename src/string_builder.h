@@ -4,6 +4,10 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -12,9 +16,22 @@ typedef struct {
     char* items;
     size_t count;
     size_t capacity;
+    // NULL means realloc/free
+    const Allocator* allocator;
+    // ITEMS points into the buffer of an SB_SBO
+    bool inline_items;
+    // ITEMS is a mapping of its own, from growing past SB_MMAP_THRESHOLD
+    bool mapped_items;
 }StringBuilder;
 typedef StringBuilder SB;
 
+// A string builder with N bytes of storage inside the owning struct, so short
+// strings never allocate. sb_sbo_init returns the builder, which moves to the
+// heap once it outgrows the buffer.
+#define SB_SBO(N) struct { StringBuilder sb; char buffer[N]; }
+#define sb_sbo_init(sbo) sb__init_inline(&(sbo)->sb, (sbo)->buffer, sizeof((sbo)->buffer))
+StringBuilder* sb__init_inline(StringBuilder* sb, char* buffer, size_t size);
+
 // Resizes a string builder 
 void sb_maybe_resize(StringBuilder* sb, size_t to_append_len);
 
@@ -96,6 +113,18 @@ void sb_free(StringBuilder* sb);
 #define SB_INIT_CAP 8
 #endif // SB_INIT_CAP
 
+// Builders without an allocator move to their own mapping once they reach this
+// many bytes, and grow with mremap from there. 0 disables it, which is the
+// default when sys/mman.h has no mremap (glibc needs _GNU_SOURCE), since each
+// growth would copy the whole mapping where realloc can remap
+#ifndef SB_MMAP_THRESHOLD
+#ifdef MREMAP_MAYMOVE
+#define SB_MMAP_THRESHOLD (1 << 26)
+#else
+#define SB_MMAP_THRESHOLD 0
+#endif // MREMAP_MAYMOVE
+#endif // SB_MMAP_THRESHOLD
+
 size_t __curl_sb(void *contents, size_t sz, size_t nmemb, void *ctx) {
     size_t realsize = sz * nmemb;
 
@@ -107,16 +136,51 @@ size_t __curl_sb(void *contents, size_t sz, size_t nmemb, void *ctx) {
 
 void sb_maybe_resize(StringBuilder* sb, size_t to_append_len) {
     if (sb->count + to_append_len >= sb->capacity) {
+        size_t old_size = sizeof(sb->items[0]) * sb->capacity;
         if (sb->capacity == 0) sb->capacity = SB_INIT_CAP;
         while (sb->count + to_append_len >= sb->capacity) {
             sb->capacity *= 2;
         }
 
-        sb->items = realloc(sb->items, sizeof(sb->items[0]) * sb->capacity);
+        size_t new_size = sizeof(sb->items[0]) * sb->capacity;
+        if (sb->inline_items) {
+            char* items = sb->allocator != NULL ? allocator_alloc(sb->allocator, new_size) : malloc(new_size);
+            assert(items != NULL);
+            memcpy(items, sb->items, sb->count);
+            sb->items = items;
+            sb->inline_items = false;
+        } else if (sb->allocator != NULL) {
+            sb->items = sb->items == NULL
+                ? allocator_alloc(sb->allocator, new_size)
+                : allocator_realloc(sb->allocator, sb->items, old_size, new_size);
+        } else if (sb->mapped_items) {
+            sb->items = allocator_realloc(&mmap_allocator, sb->items, old_size, new_size);
+#if SB_MMAP_THRESHOLD > 0
+        } else if (new_size >= SB_MMAP_THRESHOLD) {
+            char* mapped = allocator_alloc(&mmap_allocator, new_size);
+            assert(mapped != NULL);
+            if (sb->count > 0) memcpy(mapped, sb->items, sb->count);
+            free(sb->items);
+            sb->items = mapped;
+            sb->mapped_items = true;
+#endif // SB_MMAP_THRESHOLD
+        } else {
+            sb->items = realloc(sb->items, new_size);
+        }
         assert(sb->items != NULL);
     }
 }
 
+StringBuilder* sb__init_inline(StringBuilder* sb, char* buffer, size_t size) {
+    sb->items = buffer;
+    sb->count = 0;
+    sb->capacity = size;
+    sb->allocator = NULL;
+    sb->inline_items = true;
+    sb->mapped_items = false;
+    return sb;
+}
+
 void sb_push(StringBuilder* sb, char c) {
     sb_maybe_resize(sb, 1);
     sb->items[sb->count++] = c;
@@ -280,10 +344,21 @@ void sb_export_inplace(StringBuilder const* sb, char dst[sb->count]) {
 }
 
 void sb_free(StringBuilder* sb) {
-    free(sb->items);
+    if (sb->inline_items) {
+        // The buffer belongs to the owning struct
+    } else if (sb->allocator != NULL) {
+        if (sb->items != NULL) allocator_free(sb->allocator, sb->items, sizeof(sb->items[0]) * sb->capacity);
+    } else if (sb->mapped_items) {
+        allocator_free(&mmap_allocator, sb->items, sizeof(sb->items[0]) * sb->capacity);
+    } else {
+        free(sb->items);
+    }
     sb->items = NULL;
     sb->count = 0;
     sb->capacity = 0;
+    sb->inline_items = false;
+    // A freed builder starts over on the heap
+    sb->mapped_items = false;
 }
 
 #endif // STRING_BUILDER_IMPLENTATION
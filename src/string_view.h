@@ -2,8 +2,13 @@
 #define STRING_VIEW_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
+#ifndef ALLOCATOR_H_
+#include "allocator.h"
+#endif // ALLOCATOR_H_
+
 #define SV_FMT "%.*s"
 #define SV_F(sv) (int)(sv).len, (sv).start
 
@@ -22,8 +27,33 @@ typedef struct {
     StringView* items;
     size_t count;
     size_t capacity;
+    // NULL means realloc/free
+    const Allocator* allocator;
 }StringSplit;
 
+// A set of delimiter bytes for sv_chop_by_any, made by sv_delims
+typedef struct {
+    // A byte is a delimiter when lo[byte & 15] & hi[byte >> 4] isn't 0, which
+    // SIMD shuffles can look up 16 or 32 bytes at once
+    uint8_t lo[16], hi[16];
+    // False with more than 8 delimiters, which the nibble tables can't tell apart
+    bool nibbles;
+    bool table[256];
+}SvDelims;
+
+// Walks the fields of a StringView one at a time, without allocating.
+// Set the options after sv_split_iter_init, before the first sv_split_iter_next.
+typedef struct {
+    StringView rest;
+    char delim;
+    // Splits on any of these instead of DELIM when not NULL
+    const SvDelims* delims;
+    bool skip_empty;
+    // Fields split off before the rest comes out as the last one, 0 means no limit
+    size_t max_splits;
+    size_t splits;
+}SvSplitIter;
+
 // Creates a StringView from a C string
 StringView sv_from_parts(const char* start, size_t len);
 #define sv_from_cstr(str) sv_from_parts(str, strlen(str))
@@ -47,8 +77,26 @@ double sv_to_double(StringView* sv);
 long long sv_to_longlong(StringView* sv, int base);
 unsigned long long sv_to_ulonglong(StringView* sv, int base);
 
+SvDelims sv_delims(const char* delims);
+// Same as sv_chop_by_c, but stops at any of DELIMS
+StringView sv_chop_by_any(StringView* sv, const SvDelims* delims);
+
+// Fields come out the same as the pieces of sv_split
+SvSplitIter sv_split_iter_init(StringView sv, char delim);
+SvSplitIter sv_split_iter_init_any(StringView sv, const SvDelims* delims);
+bool sv_split_iter_next(SvSplitIter* self, StringView* field);
+// Splits into at most CAPACITY fields, the last of which takes the rest of SV.
+// Returns how many fields it wrote
+size_t sv_split_fixed(StringView sv, char delim, StringView* fields, size_t capacity);
+
 StringSplit sv_split(StringView sv, char c);
+StringSplit sv_split_any(StringView sv, const SvDelims* delims);
+void sv_split_any_append(StringSplit* split, StringView sv, const SvDelims* delims);
 StringSplit sv_split_pred(StringView sv, sv_predicate_t pred);
+// Appends the pieces to SPLIT, whose items come from its allocator if it has one
+void sv_split_append(StringSplit* split, StringView sv, char c);
+void sv_split_pred_append(StringSplit* split, StringView sv, sv_predicate_t pred);
+void sv_split_free(StringSplit* split);
 
 bool sv_cmpc(StringView sv, const char* cstr);
 bool sv_cmpsv(StringView sv, StringView that);
@@ -78,8 +126,17 @@ char* sv_to_cstr_inplace(StringView sv, char buf[sv.len + 1]);
 
 static void split_maybe_resize(StringSplit* split) {
     if (split->count == split->capacity) {
+        size_t old_size = sizeof(*split->items) * split->capacity;
         split->capacity = split->capacity == 0? 2 : split->capacity * 2;
-        split->items = realloc(split->items, sizeof(*split->items) * split->capacity);
+
+        size_t new_size = sizeof(*split->items) * split->capacity;
+        if (split->allocator != NULL) {
+            split->items = split->items == NULL
+                ? allocator_alloc(split->allocator, new_size)
+                : allocator_realloc(split->allocator, split->items, old_size, new_size);
+        } else {
+            split->items = realloc(split->items, new_size);
+        }
         assert(split->items != NULL);
     }
 }
@@ -98,32 +155,126 @@ void sv_step(StringView* self) {
     self->len -= 1;
 }
 
-StringView sv_chop_by_c(StringView* sv, char delim) {
-    StringView out = { NULL, 0 };
+// Cuts SV at I, the index of a delimiter or SV->len if there's none
+static StringView sv__chop_at(StringView* sv, size_t i) {
+    StringView out = { sv->start, i };
 
-    for (size_t i = 0; i < sv->len; ++i) {
-        if (sv->start[i] == delim) {
-            const char* frag_end = &sv->start[i + 1]; 
+    if (i < sv->len) {
+        sv->start += i + 1;
+        sv->len -= i + 1;
+    } else {
+        // Callers rely on start ending up on the last byte
+        sv->start = &sv->start[sv->len - 1];
+        sv->len = 0;
+    }
 
-            out.start = sv->start;
-            out.len = frag_end - sv->start - 1;
+    return out;
+}
 
-            sv->start = frag_end;
-            sv->len = sv->len - i - 1;
+StringView sv_chop_by_c(StringView* sv, char delim) {
+    // memchr is vectorized and picks the widest instructions at runtime
+    const char* found = sv->len > 0 ? memchr(sv->start, delim, sv->len) : NULL;
+    return sv__chop_at(sv, found != NULL ? (size_t)(found - sv->start) : sv->len);
+}
 
-            break;
+SvDelims sv_delims(const char* delims) {
+    SvDelims set;
+    memset(&set, 0, sizeof(set));
+
+    size_t count = 0;
+    for (const unsigned char* d = (const unsigned char*)delims; *d; ++d) {
+        if (set.table[*d]) continue;
+        set.table[*d] = true;
+
+        if (count < 8) {
+            set.lo[*d & 15] |= 1 << count;
+            set.hi[*d >> 4] |= 1 << count;
         }
+        count++;
     }
-    
-    if (out.start == NULL) {
-        out.start = sv->start;
-        out.len = sv->len;
 
-        sv->start = &sv->start[sv->len - 1];
-        sv->len = 0;
+    set.nibbles = count <= 8;
+    return set;
+}
+
+static size_t sv__find_any_scalar(const unsigned char* s, size_t len, const SvDelims* delims) {
+    for (size_t i = 0; i < len; ++i) {
+        if (delims->table[s[i]]) return i;
     }
+    return len;
+}
 
-    return out;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(SV_NO_SIMD)
+#include <immintrin.h>
+#define SV__SIMD
+
+__attribute__((target("ssse3")))
+static size_t sv__find_any_ssse3(const unsigned char* s, size_t len, const SvDelims* delims) {
+    __m128i lo = _mm_loadu_si128((const __m128i*)delims->lo);
+    __m128i hi = _mm_loadu_si128((const __m128i*)delims->hi);
+    __m128i nibble = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i lo_class = _mm_shuffle_epi8(lo, _mm_and_si128(bytes, nibble));
+        __m128i hi_class = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        __m128i none = _mm_cmpeq_epi8(_mm_and_si128(lo_class, hi_class), _mm_setzero_si128());
+
+        unsigned mask = ~_mm_movemask_epi8(none) & 0xffff;
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return i + sv__find_any_scalar(s + i, len - i, delims);
+}
+
+__attribute__((target("avx2")))
+static size_t sv__find_any_avx2(const unsigned char* s, size_t len, const SvDelims* delims) {
+    // vpshufb looks up each 128 bit lane separately, so both lanes get the tables
+    __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)delims->lo));
+    __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)delims->hi));
+    __m256i nibble = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i lo_class = _mm256_shuffle_epi8(lo, _mm256_and_si256(bytes, nibble));
+        __m256i hi_class = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+        __m256i none = _mm256_cmpeq_epi8(_mm256_and_si256(lo_class, hi_class), _mm256_setzero_si256());
+
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(none);
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    // The 16 byte step stays VEX encoded here. Calling the SSSE3 version with
+    // the upper halves dirty would pay an SSE/AVX transition on every call
+    if (i + 16 <= len) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i lo_class = _mm_shuffle_epi8(_mm256_castsi256_si128(lo), _mm_and_si128(bytes, _mm256_castsi256_si128(nibble)));
+        __m128i hi_class = _mm_shuffle_epi8(_mm256_castsi256_si128(hi),
+            _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm256_castsi256_si128(nibble)));
+        __m128i none = _mm_cmpeq_epi8(_mm_and_si128(lo_class, hi_class), _mm_setzero_si128());
+
+        unsigned mask = ~_mm_movemask_epi8(none) & 0xffff;
+        if (mask != 0) return i + __builtin_ctz(mask);
+        i += 16;
+    }
+    return i + sv__find_any_scalar(s + i, len - i, delims);
+}
+#endif // SIMD
+
+// Index of the first byte of S that's in DELIMS, or LEN
+static size_t sv__find_any(const unsigned char* s, size_t len, const SvDelims* delims) {
+#ifdef SV__SIMD
+    if (delims->nibbles && len >= 16) {
+        if (__builtin_cpu_supports("avx2")) return sv__find_any_avx2(s, len, delims);
+        if (__builtin_cpu_supports("ssse3")) return sv__find_any_ssse3(s, len, delims);
+    }
+#endif // SV__SIMD
+    return sv__find_any_scalar(s, len, delims);
+}
+
+StringView sv_chop_by_any(StringView* sv, const SvDelims* delims) {
+    return sv__chop_at(sv, sv__find_any((const unsigned char*)sv->start, sv->len, delims));
 }
 
 StringView sv_trim_left(StringView sv) {
@@ -197,12 +348,76 @@ long long sv_to_longlong(StringView* sv, int base) {
 
 StringSplit sv_split(StringView sv, char c) {
     StringSplit split = {};   
+    sv_split_append(&split, sv, c);
+    return split;
+}
+
+void sv_split_append(StringSplit* split, StringView sv, char c) {
     while (sv.len > 0) {
-        split_append(&split, sv_chop_by_c(&sv, c));
+        split_append(split, sv_chop_by_c(&sv, c));
+    }
+}
+
+SvSplitIter sv_split_iter_init(StringView sv, char delim) {
+    SvSplitIter iter = { sv, delim, NULL, false, 0, 0 };
+    return iter;
+}
+
+SvSplitIter sv_split_iter_init_any(StringView sv, const SvDelims* delims) {
+    SvSplitIter iter = { sv, 0, delims, false, 0, 0 };
+    return iter;
+}
+
+bool sv_split_iter_next(SvSplitIter* self, StringView* field) {
+    while (self->rest.len > 0) {
+        if (self->max_splits != 0 && self->splits == self->max_splits) {
+            *field = self->rest;
+            self->rest.start += self->rest.len;
+            self->rest.len = 0;
+            return true;
+        }
+
+        StringView piece = self->delims != NULL
+            ? sv_chop_by_any(&self->rest, self->delims)
+            : sv_chop_by_c(&self->rest, self->delim);
+        if (self->skip_empty && piece.len == 0) continue;
+
+        self->splits++;
+        *field = piece;
+        return true;
     }
+
+    return false;
+}
+
+size_t sv_split_fixed(StringView sv, char delim, StringView* fields, size_t capacity) {
+    if (capacity == 0 || sv.len == 0) return 0;
+    // A max_splits of 0 would mean no limit
+    if (capacity == 1) {
+        fields[0] = sv;
+        return 1;
+    }
+
+    SvSplitIter iter = sv_split_iter_init(sv, delim);
+    iter.max_splits = capacity - 1;
+
+    size_t count = 0;
+    while (count < capacity && sv_split_iter_next(&iter, &fields[count])) count++;
+    return count;
+}
+
+StringSplit sv_split_any(StringView sv, const SvDelims* delims) {
+    StringSplit split = {};
+    sv_split_any_append(&split, sv, delims);
     return split;
 }
 
+void sv_split_any_append(StringSplit* split, StringView sv, const SvDelims* delims) {
+    while (sv.len > 0) {
+        split_append(split, sv_chop_by_any(&sv, delims));
+    }
+}
+
 StringView sv_chop_by_pred(StringView* sv, sv_predicate_t pred) {
     StringView out = { NULL, 0 };
 
@@ -254,27 +469,32 @@ StringView sv_trim_pred(StringView sv, sv_predicate_t pred) {
 
 StringSplit sv_split_pred(StringView sv, sv_predicate_t pred) {
     StringSplit split = {};   
-    while (sv.len > 0) {
-        split_append(&split, sv_chop_by_pred(&sv, pred));
-    }
+    sv_split_pred_append(&split, sv, pred);
     return split;
 }
 
-bool sv_cmpc(StringView sv, const char* cstr) {
-    if (sv.len != strlen(cstr)) return false;
-
-    for (size_t i = 0; i < sv.len; ++i) {
-        if (sv.start[i] != cstr[i]) return false;
+void sv_split_pred_append(StringSplit* split, StringView sv, sv_predicate_t pred) {
+    while (sv.len > 0) {
+        split_append(split, sv_chop_by_pred(&sv, pred));
     }
+}
 
-    return true;
+void sv_split_free(StringSplit* split) {
+    if (split->allocator != NULL) {
+        if (split->items != NULL) allocator_free(split->allocator, split->items, sizeof(*split->items) * split->capacity);
+    } else {
+        free(split->items);
+    }
+    split->items = NULL;
+    split->count = 0;
+    split->capacity = 0;
 }
 
-bool sv_cmpsv(StringView sv, StringView that) {
-    if (sv.len != that.len) return false;
+bool sv_cmpc(StringView sv, const char* cstr) {
+    if (sv.len != strlen(cstr)) return false;
 
     for (size_t i = 0; i < sv.len; ++i) {
-        if (sv.start[i] != that.start[i]) return false;
+        if (sv.start[i] != cstr[i]) return false;
     }
 
     return true;
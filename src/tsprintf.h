@@ -1,60 +1,208 @@
 #ifndef TSPRINTF_H_
 #define TSPRINTF_H_
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <assert.h>
 
+// Rewinds tbuffer_alive remembers per pass over the buffer. Past that, the
+// oldest ones are forgotten and strings they killed may still pass as alive
+#ifndef TBUFFER_REWINDS
+#define TBUFFER_REWINDS 8
+#endif // TBUFFER_REWINDS
+
+// A circular buffer for temporary strings. Once the end is reached it wraps
+// around and overwrites the oldest strings.
+typedef struct {
+    char* data;
+    size_t capacity;
+    size_t size;
+    // Bumped every time strings can die: on wraps, resets and rewinds
+    size_t generation;
+    // Generations the current and the previous pass over the buffer started at
+    size_t pass_start, prev_pass_start;
+    // Furthest the current pass has written, and where the previous one ended
+    size_t high, prev_end;
+    // Rewinds of the current pass, each the lowest one since its generation.
+    // Oldest first, so both generations and sizes go up
+    struct {
+        size_t generation, size;
+    } rewinds[TBUFFER_REWINDS];
+    size_t rewind_count;
+}TBuffer;
+
+TBuffer tbuffer_new(char* data, size_t capacity);
+#define tbuffer_from_array(array) tbuffer_new(array, sizeof(array))
+
+// Formats straight into the free space and only formats again if it had to wrap.
+// Returns NULL if the string doesn't fit in the whole buffer.
+__attribute__((format(printf, 2, 3)))
+char* tbuffer_sprintf(TBuffer* self, const char* fmt, ...);
+char* tbuffer_vsprintf(TBuffer* self, const char* fmt, va_list args);
+
+void tbuffer_rewind(TBuffer* self, size_t snapshot);
+void tbuffer_reset(TBuffer* self);
+
+// Whether STR hasn't been overwritten, rewound past or reset yet. GENERATION is
+// the buffer's generation right after STR was returned. Never reports a live
+// string as dead, but can miss rewinds from before the last wrap
+bool tbuffer_alive(TBuffer* self, const char* str, size_t generation);
+
+// tsprintf and friends use a TBuffer of TBUFFER_SIZE bytes per thread
 __attribute__((format(printf, 1, 2)))
 char* tsprintf(const char* fmt, ...);
 size_t tsnapshot();
 void trewind(size_t snapshot);
 void treset();
+TBuffer* tbuffer_thread();
+#define tgeneration() (tbuffer_thread()->generation)
+
+// Catches strings used after the buffer wrapped over them or was rewound past
+// them, in debug builds
+#ifndef NDEBUG
+#define tassert_alive(str, generation) assert(tbuffer_alive(tbuffer_thread(), str, generation))
+#else
+#define tassert_alive(str, generation) ((void)0)
+#endif // NDEBUG
 
 #endif // TSPRINTF_H_
 
 #ifdef TSPRINTF_IMPLEMENTATION
 #undef TSPRINTF_IMPLEMENTATION
 
-#include <assert.h>
-#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 
 #ifndef TBUFFER_SIZE
 #define TBUFFER_SIZE (1 << 10)
 #endif // TBUFFER_SIZE
 
-static char tbuffer[TBUFFER_SIZE] = {0};
-static size_t tbuffer_size = 0;
+TBuffer tbuffer_new(char* data, size_t capacity) {
+    TBuffer buf = {0};
+    buf.data = data;
+    buf.capacity = capacity;
+    return buf;
+}
 
-char* tsprintf(const char* fmt, ...) {
+// Starts a pass over the buffer, the strings of the previous one that are still
+// around live between where the new pass has written and END
+static void tbuffer__new_pass(TBuffer* self, size_t end) {
+    self->generation++;
+    self->prev_pass_start = self->pass_start;
+    self->pass_start = self->generation;
+    self->prev_end = end;
+    self->high = 0;
+    self->size = 0;
+    self->rewind_count = 0;
+}
+
+char* tbuffer_vsprintf(TBuffer* self, const char* fmt, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+
+    char* start = self->data + self->size;
+    size_t room = self->capacity - self->size;
+    int n = vsnprintf(start, room, fmt, copy);
+    va_end(copy);
+
+    if (n < 0) return NULL;
+    if ((size_t)n < room) {
+        self->size += n + 1;
+        if (self->size > self->high) self->high = self->size;
+        return start;
+    }
+
+    if ((size_t)n + 1 > self->capacity) return NULL;
+
+    tbuffer__new_pass(self, self->size);
+    start = self->data;
+    vsnprintf(start, n + 1, fmt, args);
+    self->size = n + 1;
+    self->high = n + 1;
+    return start;
+}
+
+char* tbuffer_sprintf(TBuffer* self, const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    int n = vsnprintf(NULL, 0, fmt, args);
+    char* str = tbuffer_vsprintf(self, fmt, args);
     va_end(args);
+    return str;
+}
 
-    if (n + tbuffer_size >= TBUFFER_SIZE) {
-        return NULL;
+void tbuffer_rewind(TBuffer* self, size_t snapshot) {
+    assert(snapshot <= self->capacity);
+    if (snapshot >= self->size) {
+        self->size = snapshot;
+        return;
     }
 
-    char* start = tbuffer + tbuffer_size;
+    // Later rewinds that go as low make the ones before them redundant
+    self->generation++;
+    while (self->rewind_count > 0 && self->rewinds[self->rewind_count - 1].size >= snapshot) {
+        self->rewind_count--;
+    }
+    if (self->rewind_count == TBUFFER_REWINDS) {
+        memmove(self->rewinds, self->rewinds + 1, (TBUFFER_REWINDS - 1) * sizeof(self->rewinds[0]));
+        self->rewind_count--;
+    }
+    self->rewinds[self->rewind_count].generation = self->generation;
+    self->rewinds[self->rewind_count].size = snapshot;
+    self->rewind_count++;
+    self->size = snapshot;
+}
 
-    va_start(args, fmt);
-    int n_ = vsnprintf(start, n + 1, fmt, args);
-    assert(n == n_);
+void tbuffer_reset(TBuffer* self) {
+    tbuffer__new_pass(self, 0);
+}
 
-    tbuffer_size += n_;
-    va_end(args);
+bool tbuffer_alive(TBuffer* self, const char* str, size_t generation) {
+    if (str < self->data || str >= self->data + self->capacity) return false;
+    if (generation > self->generation) return false;
+
+    size_t offset = str - self->data;
+    if (generation >= self->pass_start) {
+        if (offset >= self->size) return false;
+        // The first rewind since GENERATION is the lowest one
+        for (size_t i = 0; i < self->rewind_count; ++i) {
+            if (self->rewinds[i].generation > generation) return offset < self->rewinds[i].size;
+        }
+        return true;
+    }
 
-    return start;
+    // The previous pass lives on past what the current one has written
+    if (generation >= self->prev_pass_start) return offset >= self->high && offset < self->prev_end;
+    return false;
+}
+
+// Every thread formats into its own buffer
+static _Thread_local char tbuffer_data[TBUFFER_SIZE] = {0};
+static _Thread_local TBuffer tbuffer = {0};
+
+TBuffer* tbuffer_thread() {
+    // The address of a thread local isn't a constant, so it can't be a static initializer
+    if (tbuffer.data == NULL) tbuffer = tbuffer_new(tbuffer_data, TBUFFER_SIZE);
+    return &tbuffer;
+}
+
+char* tsprintf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char* str = tbuffer_vsprintf(tbuffer_thread(), fmt, args);
+    va_end(args);
+    return str;
 }
 
 size_t tsnapshot() {
-    return tbuffer_size;
+    return tbuffer_thread()->size;
 }
 
 void trewind(size_t snapshot) {
-    tbuffer_size = snapshot;
+    tbuffer_rewind(tbuffer_thread(), snapshot);
 }
 
 void treset() {
-    tbuffer_size = 0;
+    tbuffer_reset(tbuffer_thread());
 }
 
 #endif // TSPRINTF_IMPLEMENTATION
@@ -0,0 +1,125 @@
+#include <stdint.h>
+#include <string.h>
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+#define LINEAR_IMPLEMENTATION
+#include "linear.h"
+
+#include "test.h"
+
+static const size_t aligns[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 4096};
+#define ALIGN_COUNT (sizeof(aligns) / sizeof(aligns[0]))
+
+typedef struct {
+    _Alignas(64) uint64_t counter;
+}Padded;
+
+// Odd sizes and every alignment, until the arena has gone through many regions
+static void arena_regions(void) {
+    Arena arena = {0};
+    for (size_t i = 0; i < 20000; ++i) {
+        size_t align = aligns[i % ALIGN_COUNT];
+        size_t size = 1 + (i * 37) % 3000;
+        uint8_t* p = arena_alloc_aligned(&arena, size, align);
+        CHECK_ALIGNED(p, align);
+        memset(p, 0xab, size);
+    }
+
+    size_t regions = 0;
+    for (ArenaRegion* r = arena.start; r != NULL; r = r->next) regions++;
+    CHECK(regions > 1);
+    arena_free(&arena);
+}
+
+static void arena_large(void) {
+    Arena arena = {0};
+    size_t size = (ARENA_LARGE_ALLOC_SIZE + 1) * sizeof(uintptr_t);
+    for (size_t i = 0; i < ALIGN_COUNT; ++i) {
+        uint8_t* p = arena_alloc_aligned(&arena, size, aligns[i]);
+        CHECK_ALIGNED(p, aligns[i]);
+        memset(p, 0xab, size);
+    }
+    arena_free(&arena);
+}
+
+static void arena_marks(void) {
+    Arena arena = {0};
+    arena_alloc(&arena, 3);
+
+    for (size_t i = 0; i < ALIGN_COUNT; ++i) {
+        size_t align = aligns[i];
+        ArenaMark mark = arena_mark(&arena);
+        void* first = arena_alloc_aligned(&arena, 24, align);
+        CHECK_ALIGNED(first, align);
+
+        // Spill into later regions, then come back
+        for (size_t j = 0; j < 500; ++j) CHECK_ALIGNED(arena_alloc_aligned(&arena, 1000 + j, align), align);
+        arena_jumpback(&arena, mark);
+
+        void* again = arena_alloc_aligned(&arena, 24, align);
+        CHECK_ALIGNED(again, align);
+        CHECK(again == first);
+        arena_jumpback(&arena, mark);
+    }
+
+    arena_reset(&arena);
+    CHECK_ALIGNED(arena_alloc_aligned(&arena, 8, 64), 64);
+    arena_free(&arena);
+}
+
+static void arena_macros(void) {
+    Arena arena = {0};
+    arena_alloc(&arena, 1);
+
+    Padded* padded = arena_alloc_type(&arena, Padded);
+    CHECK_ALIGNED(padded, _Alignof(Padded));
+    Padded* many = arena_alloc_array(&arena, 7, Padded);
+    CHECK_ALIGNED(many, _Alignof(Padded));
+
+    uint8_t* line = arena_alloc_cacheline(&arena, 10);
+    CHECK_ALIGNED(line, ARENA_CACHE_LINE);
+    // The next allocation can't share the line
+    uint8_t* next = arena_alloc(&arena, 1);
+    CHECK(next >= line + ARENA_CACHE_LINE);
+
+    uint8_t* zeroed = arena_calloc_aligned(&arena, 100, 32);
+    CHECK_ALIGNED(zeroed, 32);
+    for (size_t i = 0; i < 100; ++i) CHECK(zeroed[i] == 0);
+    arena_free(&arena);
+}
+
+static void linear_aligned(void) {
+    Linear linear = linear_new(1 << 16);
+    linear_allocb(&linear, 3);
+
+    for (size_t i = 0; i < ALIGN_COUNT; ++i) {
+        size_t align = aligns[i];
+        size_t snapshot = linear_snapshot(&linear);
+        void* first = linear_alloc_aligned(&linear, 40, align);
+        CHECK_ALIGNED(first, align);
+        linear_allocb(&linear, 5);
+        linear_rewind(&linear, snapshot);
+        CHECK(linear_alloc_aligned(&linear, 40, align) == first);
+    }
+
+    uint8_t* line = linear_alloc_cacheline(&linear, 1);
+    CHECK_ALIGNED(line, LINEAR_CACHE_LINE);
+    uint8_t* zeroed = linear_calloc_aligned(&linear, 64, 64);
+    CHECK_ALIGNED(zeroed, 64);
+    for (size_t i = 0; i < 64; ++i) CHECK(zeroed[i] == 0);
+
+    // Padding counts against the capacity, so a full buffer fails instead of overflowing
+    while (linear_alloc_aligned(&linear, 100, 4096) != NULL) {}
+    CHECK(linear_occupied(&linear) <= linear.capacity * sizeof(uintptr_t));
+    linear_free(&linear);
+}
+
+int main(void) {
+    arena_regions();
+    arena_large();
+    arena_marks();
+    arena_macros();
+    linear_aligned();
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <string.h>
+
+#define DAH_IMPLEMENTATION
+#include "dah.h"
+
+#include "test.h"
+
+static bool keep_even(const void* item, void* ctx) {
+    (*(size_t*)ctx)++;
+    return *(const int*)item % 2 == 0;
+}
+
+static bool keep_first_three(const void* item, void* ctx) {
+    (void)item;
+    return (*(size_t*)ctx)++ < 3;
+}
+
+// Every item goes through the predicate exactly once, in order
+static void retain(void) {
+    uint64_t rng = 88172645463325252ull;
+    for (size_t t = 0; t < 1000; ++t) {
+        int* da = NULL;
+        int expected[64];
+        size_t expected_count = 0;
+
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        size_t count = rng % 64;
+        for (size_t i = 0; i < count; ++i) {
+            int item = (int)((rng >> (i % 32)) % 10);
+            dah_append(da, item);
+            if (item % 2 == 0) expected[expected_count++] = item;
+        }
+
+        size_t calls = 0;
+        CHECK(dah_retain(da, keep_even, &calls) == expected_count);
+        CHECK(calls == count);
+        CHECK(dah_getlen(da) == expected_count);
+        for (size_t i = 0; i < expected_count; ++i) CHECK(da[i] == expected[i]);
+        dah_free(da);
+    }
+
+    int* da = NULL;
+    for (int i = 0; i < 10; ++i) dah_append(da, i);
+    size_t calls = 0;
+    CHECK(dah_retain(da, keep_first_three, &calls) == 3);
+    CHECK(calls == 10);
+    CHECK(da[0] == 0 && da[1] == 1 && da[2] == 2);
+    dah_free(da);
+
+    CHECK(dah_retain((int*)NULL, keep_even, &calls) == 0);
+}
+
+// Appending the array to itself, or a part of it, across a growth
+static void append_self(void) {
+    int* da = NULL;
+    for (int i = 0; i < 5; ++i) dah_append(da, i);
+
+    for (size_t round = 0; round < 8; ++round) {
+        size_t count = dah_getlen(da);
+        dah_append_many(da, da, count);
+        CHECK(dah_getlen(da) == 2 * count);
+        for (size_t i = 0; i < count; ++i) CHECK(da[count + i] == da[i]);
+    }
+
+    size_t count = dah_getlen(da);
+    dah_shrink_to_fit(da);
+    dah_append_many(da, da + 3, 4);
+    CHECK(dah_getlen(da) == count + 4);
+    for (size_t i = 0; i < 4; ++i) CHECK(da[count + i] == da[3 + i]);
+    dah_free(da);
+}
+
+// Inserting items taken from the array, before, after and across the insertion point
+static void insert_self(void) {
+    for (size_t from = 0; from < 10; ++from) {
+        for (size_t n = 0; from + n <= 10; ++n) {
+            for (size_t at = 0; at <= 10; ++at) {
+                int* da = NULL;
+                int expected[20];
+                for (int i = 0; i < 10; ++i) dah_append(da, i);
+                // Exactly full, so the insert has to grow
+                dah_shrink_to_fit(da);
+
+                memcpy(expected, da, at * sizeof(int));
+                memcpy(expected + at, da + from, n * sizeof(int));
+                memcpy(expected + at + n, da + at, (10 - at) * sizeof(int));
+
+                dah_insert_many(da, at, da + from, n);
+                CHECK(dah_getlen(da) == 10 + n);
+                for (size_t i = 0; i < 10 + n; ++i) CHECK(da[i] == expected[i]);
+                dah_free(da);
+            }
+        }
+    }
+}
+
+int main(void) {
+    retain();
+    append_self();
+    insert_self();
+    return 0;
+}
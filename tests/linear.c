@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LINEAR_IMPLEMENTATION
+#include "linear.h"
+
+#include "test.h"
+
+// Loading into a Linear that already owns memory frees it, leak checking catches it if not
+static void load_into_used(void) {
+    char path[] = "/tmp/linear_test_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    Linear saved = linear_new(1 << 12);
+    linear_strdup(&saved, "saved and loaded");
+    CHECK(linear_save(&saved, path));
+    linear_free(&saved);
+
+    Linear linear = linear_new(1 << 12);
+    linear_strdup(&linear, "owned before the load");
+
+    // Malloc'd, then mapped, then mapped again
+    for (int i = 0; i < 3; ++i) {
+        CHECK(linear_load(&linear, path, LINEAR_LOAD_VERIFY));
+        CHECK(linear.mapped > 0);
+        CHECK(strcmp((const char*)linear.mem, "saved and loaded") == 0);
+    }
+
+    // A failed load leaves the Linear alone
+    uintptr_t* mem = linear.mem;
+    CHECK(!linear_load(&linear, "/nonexistent/linear", 0));
+    CHECK(linear.mem == mem);
+
+    linear_free(&linear);
+    unlink(path);
+}
+
+int main(void) {
+    load_into_used();
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include <string.h>
+
+#define SV_IMPLEMENTATION
+#include "string_view.h"
+
+#include "test.h"
+
+// The iterator walks the same fields sv_split returns
+static void split_iter(void) {
+    char buffer[64];
+    uint64_t rng = 88172645463325252ull;
+    for (size_t t = 0; t < 10000; ++t) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        size_t len = rng % sizeof(buffer);
+        for (size_t i = 0; i < len; ++i) buffer[i] = "ab,"[(rng >> (i % 48)) % 3];
+        StringView sv = {buffer, len};
+
+        StringSplit split = sv_split(sv, ',');
+        SvSplitIter iter = sv_split_iter_init(sv, ',');
+        StringView field;
+        size_t i = 0;
+        while (sv_split_iter_next(&iter, &field)) {
+            CHECK(i < split.count);
+            CHECK(field.start == split.items[i].start && field.len == split.items[i].len);
+            i++;
+        }
+        CHECK(i == split.count);
+        sv_split_free(&split);
+    }
+
+    SvDelims delims = sv_delims(",;");
+    SvSplitIter iter = sv_split_iter_init_any(sv_from_cstr("x;;y,z"), &delims);
+    iter.skip_empty = true;
+    iter.max_splits = 1;
+    StringView field;
+    CHECK(sv_split_iter_next(&iter, &field) && sv_cmpc(field, "x"));
+    CHECK(sv_split_iter_next(&iter, &field) && sv_cmpc(field, ";y,z"));
+    CHECK(!sv_split_iter_next(&iter, &field));
+}
+
+static void split_fixed(void) {
+    // One past the capacity, so writing too far shows up
+    StringView fields[4];
+    for (size_t capacity = 0; capacity < 3; ++capacity) {
+        fields[capacity].start = NULL;
+        fields[capacity].len = 12345;
+        size_t count = sv_split_fixed(sv_from_cstr("a,b,c,d"), ',', fields, capacity);
+        CHECK(count == capacity);
+        CHECK(fields[capacity].len == 12345);
+    }
+
+    CHECK(sv_split_fixed(sv_from_cstr("a,b,c"), ',', fields, 1) == 1);
+    CHECK(sv_cmpc(fields[0], "a,b,c"));
+    CHECK(sv_split_fixed(sv_from_cstr("a,b,c,d"), ',', fields, 3) == 3);
+    CHECK(sv_cmpc(fields[0], "a") && sv_cmpc(fields[1], "b") && sv_cmpc(fields[2], "c,d"));
+    CHECK(sv_split_fixed(sv_from_cstr("a,b"), ',', fields, 3) == 2);
+    CHECK(sv_split_fixed(sv_from_cstr(""), ',', fields, 3) == 0);
+}
+
+static uint64_t chop_rng = 0x9e3779b97f4a7c15ull;
+
+static uint64_t chop_next(void) {
+    chop_rng ^= chop_rng << 13; chop_rng ^= chop_rng >> 7; chop_rng ^= chop_rng << 17;
+    return chop_rng;
+}
+
+// Long runs of other bytes, high ones included, so the shuffle loops get to
+// scan whole blocks before they find a delimiter
+static void chop_input(unsigned char* s, size_t len, const char* delims, size_t count) {
+    for (size_t i = 0; i < len; ++i) {
+        if (chop_next() % 48 == 0) {
+            s[i] = delims[chop_next() % count];
+        } else {
+            s[i] = 1 + chop_next() % 255;
+        }
+    }
+}
+
+// Every way of finding delimiters agrees with a plain lookup in the table
+static void chop_by_any(void) {
+    const size_t sizes[] = {1, 3, 8, 9};
+    for (size_t t = 0; t < 4000; ++t) {
+        size_t count = sizes[t % 4];
+        char delims[10] = {0};
+        for (size_t i = 0; i < count; ++i) {
+            // Distinct, and half of them with the high bit set
+            unsigned char d;
+            do d = 1 + chop_next() % 255; while (strchr(delims, d) != NULL);
+            delims[i] = (char)d;
+        }
+
+        SvDelims set = sv_delims(delims);
+        CHECK(set.nibbles == (count <= 8));
+        for (size_t b = 0; b < 256; ++b) CHECK(set.table[b] == (b != 0 && strchr(delims, (int)b) != NULL));
+
+        unsigned char input[512];
+        size_t len = 64 + chop_next() % (sizeof(input) - 64);
+        chop_input(input, len, delims, count);
+
+#ifdef SV__SIMD
+        // Both kernels, whichever one the dispatch picks on this machine
+        for (size_t from = 0; from < len; ++from) {
+            size_t expected = from + sv__find_any_scalar(input + from, len - from, &set);
+            if (!set.nibbles) continue;
+            if (__builtin_cpu_supports("ssse3")) CHECK(from + sv__find_any_ssse3(input + from, len - from, &set) == expected);
+            if (__builtin_cpu_supports("avx2")) CHECK(from + sv__find_any_avx2(input + from, len - from, &set) == expected);
+        }
+#endif // SV__SIMD
+
+        StringView sv = {(const char*)input, len};
+        size_t at = 0;
+        while (sv.len > 0) {
+            size_t end = at;
+            while (end < len && !set.table[input[end]]) end++;
+
+            StringView field = sv_chop_by_any(&sv, &set);
+            CHECK(field.start == (const char*)input + at);
+            CHECK(field.len == end - at);
+            at = end + 1;
+            if (at < len) CHECK(sv.start == (const char*)input + at && sv.len == len - at);
+        }
+    }
+}
+
+int main(void) {
+    split_iter();
+    split_fixed();
+    chop_by_any();
+    return 0;
+}
@@ -0,0 +1,3 @@
+// The string_view tests again, with the table lookups sv_chop_by_any uses without SIMD
+#define SV_NO_SIMD
+#include "string_view.c"
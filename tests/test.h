@@ -0,0 +1,16 @@
+#ifndef TEST_H_
+#define TEST_H_
+#include <stdio.h>
+#include <stdlib.h>
+
+// Unlike assert, still checks under NDEBUG
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#define CHECK_ALIGNED(ptr, align) CHECK(((uintptr_t)(ptr) & ((align) - 1)) == 0)
+
+#endif // TEST_H_
@@ -0,0 +1,125 @@
+#include <stdint.h>
+#include <string.h>
+
+#define TBUFFER_REWINDS 64
+#define TSPRINTF_IMPLEMENTATION
+#include "tsprintf.h"
+
+#include "test.h"
+
+#define MAX_STRINGS 4096
+
+typedef struct {
+    const char* str;
+    size_t generation, pass, len;
+    bool alive;
+}Tracked;
+
+static Tracked tracked[MAX_STRINGS];
+static size_t tracked_count;
+
+// Kills every tracked string that overlaps [START, END)
+static void overwrite(char* data, size_t start, size_t end) {
+    for (size_t i = 0; i < tracked_count; ++i) {
+        size_t offset = tracked[i].str - data;
+        if (offset < end && offset + tracked[i].len + 1 > start) tracked[i].alive = false;
+    }
+}
+
+// The sequence from the review: a rewind past a string kills it, even though
+// the buffer never wrapped
+static void rewind_kills(void) {
+    char data[64];
+    TBuffer buf = tbuffer_from_array(data);
+
+    char* kept = tbuffer_sprintf(&buf, "kept");
+    size_t kept_generation = buf.generation;
+    size_t snapshot = buf.size;
+    char* str = tbuffer_sprintf(&buf, "%d", 1234);
+    size_t generation = buf.generation;
+
+    tbuffer_rewind(&buf, snapshot);
+    tbuffer_sprintf(&buf, "XXXXXXXX");
+    CHECK(!tbuffer_alive(&buf, str, generation));
+    CHECK(tbuffer_alive(&buf, kept, kept_generation));
+
+    // Rewinding to the same snapshot over and over doesn't kill what's before it
+    for (int i = 0; i < 100; ++i) {
+        tbuffer_sprintf(&buf, "loop %d", i);
+        tbuffer_rewind(&buf, snapshot);
+    }
+    CHECK(tbuffer_alive(&buf, kept, kept_generation));
+
+    tbuffer_reset(&buf);
+    CHECK(!tbuffer_alive(&buf, kept, kept_generation));
+}
+
+// Random sprintfs, rewinds and wraps against a model of which strings are intact
+static void random_ops(void) {
+    char data[256];
+    TBuffer buf = tbuffer_from_array(data);
+    size_t snapshots[64];
+    size_t snapshot_count = 0;
+    size_t pass = 0;
+
+    uint64_t rng = 88172645463325252ull;
+    for (size_t step = 0; step < 100000; ++step) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+
+        // Dead strings stay dead, so they only need checking once
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < tracked_count; ++i) {
+                if (tracked[i].alive) tracked[kept++] = tracked[i];
+            }
+            tracked_count = kept;
+        }
+
+        switch (rng % 8) {
+        case 0:
+            if (snapshot_count < 64) snapshots[snapshot_count++] = buf.size;
+            break;
+        case 1:
+            if (snapshot_count > 0) {
+                size_t snapshot = snapshots[(rng >> 8) % snapshot_count];
+                if (snapshot > buf.size) break;
+                // Snapshots after it are past the new end
+                while (snapshot_count > 0 && snapshots[snapshot_count - 1] > snapshot) snapshot_count--;
+                for (size_t i = 0; i < tracked_count; ++i) {
+                    if (tracked[i].pass == pass && (size_t)(tracked[i].str - data) >= snapshot) tracked[i].alive = false;
+                }
+                tbuffer_rewind(&buf, snapshot);
+            }
+            break;
+        default: {
+            size_t before = buf.generation;
+            char* str = tbuffer_sprintf(&buf, "%.*s", (int)((rng >> 8) % 40), "0123456789012345678901234567890123456789");
+            size_t len = strlen(str);
+            if (buf.generation != before) {
+                // Wrapped: strings from two passes ago are gone, and so are the snapshots
+                for (size_t i = 0; i < tracked_count; ++i) {
+                    if (tracked[i].pass != pass) tracked[i].alive = false;
+                }
+                pass++;
+                snapshot_count = 0;
+            }
+            overwrite(data, str - data, str - data + len + 1);
+            tracked[tracked_count++] = (Tracked){str, buf.generation, pass, len, true};
+        } break;
+        }
+
+        for (size_t i = 0; i < tracked_count; ++i) {
+            bool alive = tbuffer_alive(&buf, tracked[i].str, tracked[i].generation);
+            // Never a false alarm, and exact within the current pass
+            if (tracked[i].alive) CHECK(alive);
+            if (tracked[i].pass == pass) CHECK(alive == tracked[i].alive);
+            if (tracked[i].alive) CHECK(strlen(tracked[i].str) == tracked[i].len);
+        }
+    }
+}
+
+int main(void) {
+    rewind_kills();
+    random_ops();
+    return 0;
+}